@@ -0,0 +1,51 @@
+#ifndef ADAPTIVETESS_H_
+#define ADAPTIVETESS_H_
+#include "CPUTessellator.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file AdaptiveTess.h
+/// @brief CPU mirror of the adaptive mode in tesscontrol.glsl, each outer level comes from the projected size of
+/// its edge so the cost follows what is on screen. The maths is kept identical to the shader so the estimates
+/// match what the GPU generates.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the camera values the adaptive mode depends on
+  //----------------------------------------------------------------------------------------------------------------------
+  struct ScreenSpaceParams
+  {
+    /// @brief column major model view matrix (16 floats)
+    const float *modelView = nullptr;
+    /// @brief projection[1][1] * viewport height / 2
+    float projectionScale = 1.0f;
+    /// @brief the length in pixels we would like each generated edge to be
+    float targetEdgePixels = 20.0f;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the level for the edge _a -> _b, symmetric in _a and _b so neighbouring patches never crack
+  //----------------------------------------------------------------------------------------------------------------------
+  float adaptiveEdgeLevel(const float *_a, const float *_b, const ScreenSpaceParams &_params);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief levels for a whole patch, outer level i is the edge opposite vertex i and the inner level is the average
+  //----------------------------------------------------------------------------------------------------------------------
+  TessLevels adaptivePatchLevels(const float *_p0, const float *_p1, const float *_p2, const ScreenSpaceParams &_params);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of triangles the adaptive mode generates for this camera
+  //----------------------------------------------------------------------------------------------------------------------
+  template <typename IndexType>
+  size_t estimateAdaptiveTriangles(const float *_positions, const IndexType *_patchIndices, size_t _numPatches,
+                                   const ScreenSpaceParams &_params)
+  {
+    size_t count = 0;
+    for (size_t patch = 0; patch < _numPatches; ++patch)
+    {
+      const IndexType *idx = &_patchIndices[patch * 3];
+      count += expectedTriangleCount(adaptivePatchLevels(&_positions[idx[0] * 3], &_positions[idx[1] * 3],
+                                                         &_positions[idx[2] * 3], _params));
+    }
+    return count;
+  }
+} // end namespace tess
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef APPOPTIONS_H_
+#define APPOPTIONS_H_
+#include "TessProgram.h"
+#include <string>
+
+class QCoreApplication;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file AppOptions.h
+/// @brief command line options for the demo
+//----------------------------------------------------------------------------------------------------------------------
+struct AppOptions
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief which Tess program to start with, G swaps at runtime
+  //----------------------------------------------------------------------------------------------------------------------
+  TessPipeline pipeline = TessPipeline::GeometryShader;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief load / store linked programs in the on disk binary cache
+  //----------------------------------------------------------------------------------------------------------------------
+  bool programCache = true;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the sphere's control mesh and how it is encoded for upload
+  //----------------------------------------------------------------------------------------------------------------------
+  tess::PatchMeshSettings patchMesh;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief .tpm control mesh streamed in and drawn instead of the sphere, see TessMeshTool
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string meshFile;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief highest level pre tessellated for the GeodesicLOD mode
+  //----------------------------------------------------------------------------------------------------------------------
+  int lodLevels = 64;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief GPU frame time the automatic level controller (key T) aims for
+  //----------------------------------------------------------------------------------------------------------------------
+  float budgetMS = 8.0f;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief .bpt file drawn by the Bezier patch mode (key B), a procedural wave grid is used when empty
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string patchFile;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief when set the first frame's tessellated sphere is captured to this file (.ply or raw floats), key P
+  /// captures later frames
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string captureFile;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief when set the first frame (without the HUD) is saved to this PPM, for comparing with TessRender
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string screenshotFile;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief inner and outer tessellation level the window starts at
+  //----------------------------------------------------------------------------------------------------------------------
+  float level = 1.0f;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief record CPU and GPU trace zones from start up and write them as Chrome trace JSON when the window
+  /// closes, needs a TESS_ENABLE_TRACE build
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string traceFile;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief log the mouse and key input to a file, or play a log back frame by frame and exit with its frame times
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string recordFile;
+  std::string replayFile;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief run on Qt's offscreen platform, for replays on machines without a display
+  //----------------------------------------------------------------------------------------------------------------------
+  bool headless = false;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief spheres in the GPU driven instanced mode (key I)
+  //----------------------------------------------------------------------------------------------------------------------
+  int instances = 20000;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief .tht height tiles streamed by the terrain mode (key E), a procedural terrain is generated without one
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string terrainFile;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief --bench runs TessBenchmark offscreen instead of opening the window
+  //----------------------------------------------------------------------------------------------------------------------
+  bool bench = false;
+  int benchFrames = 10;
+  int benchStep = 1;
+  int benchWidth = 1024;
+  int benchHeight = 720;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief repeat the level sweep for the uncompressed mesh and each compact encoding instead of just patchMesh
+  //----------------------------------------------------------------------------------------------------------------------
+  bool benchEncodings = false;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief results go to <benchOutput>.csv and <benchOutput>.json
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string benchOutput = "bench_results";
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief parse the application arguments, exits with the usage text on --help or an error
+//----------------------------------------------------------------------------------------------------------------------
+AppOptions parseAppOptions(const QCoreApplication &_app);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef BEZIERPATCH_H_
+#define BEZIERPATCH_H_
+#include "CPUTessellator.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file BezierPatch.h
+/// @brief bicubic Bezier patch meshes for the "Bezier" program (beziercontrol.glsl + beziereval.glsl) and a CPU
+/// evaluator for the same patches. Control point (i,j) of a patch, i along u and j along v, is index j*4+i of its 16.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a control cage, shared control points are stored once and referenced by 16 indices per patch
+  //----------------------------------------------------------------------------------------------------------------------
+  struct BezierPatchMesh
+  {
+    /// @brief packed xyz
+    std::vector<float> controlPoints;
+    /// @brief 16 per patch
+    std::vector<uint32_t> patchIndices;
+    size_t numPatches() const { return patchIndices.size() / 16; }
+    size_t numControlPoints() const { return controlPoints.size() / 3; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief what the cage costs to upload, control points plus indices
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t bytes() const { return controlPoints.size() * sizeof(float) + patchIndices.size() * sizeof(uint32_t); }
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief load a .bpt file (the patch count, then per patch a "3 3" degree line and 16 xyz control points, u
+  /// fastest). Identical control points are welded.
+  /// @returns false if the file can't be read or holds anything but bicubic patches
+  //----------------------------------------------------------------------------------------------------------------------
+  bool loadBezierPatches(const std::string &_fname, BezierPatchMesh &o_mesh);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a _patchesX by _patchesZ grid of patches spanning _size x _size around the origin with a rolling wave
+  /// height, neighbouring patches share their edge control points
+  //----------------------------------------------------------------------------------------------------------------------
+  void makeWaveGrid(int _patchesX, int _patchesZ, float _size, BezierPatchMesh &o_mesh);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of triangles GL generates for one quad patch (equal_spacing) with both inner levels at
+  /// _inner and all four outer levels at _outer, as beziercontrol.glsl sets them. 0 if the patch is discarded
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t expectedQuadTriangleCount(float _inner, float _outer);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief evaluate one patch on the (_level+1)^2 grid of u,v = k/_level that equal_spacing generates when all the
+  /// levels are _level, rows of constant v with u running fastest. Four u values are done at a time with SSE.
+  /// @param [in] _positions packed xyz control points
+  /// @param [in] _patch the 16 indices of this patch
+  /// @param [out] o_xyz (_level+1)^2 * 3 floats
+  /// @param [out] o_normals normalized dP/du x dP/dv, same size as o_xyz, may be nullptr. Zero where the
+  /// derivatives are degenerate (e.g. the collapsed edges at the top of the teapot)
+  //----------------------------------------------------------------------------------------------------------------------
+  void evaluateBezierPatch(const float *_positions, const uint32_t *_patch, int _level, float *o_xyz, float *o_normals);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief evaluate every patch at _level into an indexed mesh, 2 triangles per grid cell, patchCoords holds u,v,0
+  /// and normals is filled in
+  //----------------------------------------------------------------------------------------------------------------------
+  void tessellateBezierPatches(const BezierPatchMesh &_mesh, int _level, TessMesh &o_mesh);
+} // end namespace tess
+
+#endif
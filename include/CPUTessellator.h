@@ -0,0 +1,208 @@
+#ifndef CPUTESSELLATOR_H_
+#define CPUTESSELLATOR_H_
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file CPUTessellator.h
+/// @brief a CPU reference implementation of the "Tess" program (tesscontrol.glsl + tesseval.glsl). It follows the
+/// GL rules for the triangle domain with equal_spacing and cw winding and projects the generated points onto the
+/// unit sphere exactly as the evaluation shader does, so it can be used where no GPU is available.
+/// This library has no GL / NGL dependency on purpose.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the largest level the tessellator accepts, matches GL_MAX_TESS_GEN_LEVEL on all the drivers we use
+  //----------------------------------------------------------------------------------------------------------------------
+  constexpr int MaxTessLevel = 64;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the values written to gl_TessLevelInner[0] and gl_TessLevelOuter[0..2] by the control stage
+  //----------------------------------------------------------------------------------------------------------------------
+  struct TessLevels
+  {
+    float inner = 1.0f;
+    std::array<float, 3> outer = {{1.0f, 1.0f, 1.0f}};
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief levels after the GL clamp / round rules have been applied
+  //----------------------------------------------------------------------------------------------------------------------
+  struct IntLevels
+  {
+    int inner = 1;
+    std::array<int, 3> outer = {{1, 1, 1}};
+    /// @brief true if any outer level is <= 0 or NaN, in this case GL discards the patch
+    bool discarded = false;
+    bool operator<(const IntLevels &_r) const
+    {
+      return std::tie(inner, outer, discarded) < std::tie(_r.inner, _r.outer, _r.discarded);
+    }
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief apply the equal_spacing rules : clamp to [1,MaxTessLevel], round up, and bump an inner level of 1 to 2
+  /// when any outer level is greater than 1
+  //----------------------------------------------------------------------------------------------------------------------
+  IntLevels roundLevels(const TessLevels &_levels);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of distinct domain points GL generates for a single patch at these levels, worked out
+  /// from the tessellation rules rather than by building the pattern
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t expectedVertexCount(const TessLevels &_levels);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the number of triangles GL generates for a single patch at these levels (what GL_PRIMITIVES_GENERATED
+  /// reports per patch without a geometry shader)
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t expectedTriangleCount(const TessLevels &_levels);
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @class TessPattern
+  /// @brief the topology the fixed function tessellator produces for one set of levels, this is shared by every
+  /// patch tessellated at those levels. The gl_TessCoord values are kept as SoA arrays padded to a multiple of 4
+  /// so the evaluation loop can run 4 points at a time.
+  /// Vertex layout : the 3 corners (u=1, v=1, w=1) come first, then the points inside outer edge 0, 1 and 2
+  /// (edge i is the one opposite corner i, i.e. the one controlled by gl_TessLevelOuter[i]) and finally the
+  /// interior points.
+  //----------------------------------------------------------------------------------------------------------------------
+  class TessPattern
+  {
+  public:
+    explicit TessPattern(const TessLevels &_levels);
+    size_t numVertices() const { return m_numVertices; }
+    size_t numTriangles() const { return m_indices.size() / 3; }
+    const IntLevels &levels() const { return m_levels; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief gl_TessCoord components, size is numVertices() rounded up to a multiple of 4
+    //----------------------------------------------------------------------------------------------------------------------
+    const std::vector<float> &u() const { return m_u; }
+    const std::vector<float> &v() const { return m_v; }
+    const std::vector<float> &w() const { return m_w; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief triangle list, 3 indices per triangle wound the same way as the patch (cw in the GL domain)
+    //----------------------------------------------------------------------------------------------------------------------
+    const std::vector<uint32_t> &indices() const { return m_indices; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief first vertex and number of vertices strictly inside outer edge _e, ordered from corner (_e+1)%3
+    /// towards corner (_e+2)%3
+    //----------------------------------------------------------------------------------------------------------------------
+    uint32_t edgeStart(int _e) const { return m_edgeStart[_e]; }
+    uint32_t edgeCount(int _e) const { return static_cast<uint32_t>(m_levels.outer[_e] - 1); }
+    uint32_t interiorStart() const { return m_interiorStart; }
+
+  private:
+    uint32_t addVertex(float _u, float _v, float _w);
+    void addTriangle(uint32_t _a, uint32_t _b, uint32_t _c);
+    void stitch(const std::vector<uint32_t> &_outer, const std::vector<uint32_t> &_inner, int _ringSegments);
+    IntLevels m_levels;
+    size_t m_numVertices = 0;
+    std::vector<float> m_u;
+    std::vector<float> m_v;
+    std::vector<float> m_w;
+    std::vector<uint32_t> m_indices;
+    std::array<uint32_t, 3> m_edgeStart = {{0, 0, 0}};
+    uint32_t m_interiorStart = 0;
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the output of the CPU tessellator, an indexed triangle list with one block of vertices per patch
+  //----------------------------------------------------------------------------------------------------------------------
+  struct TessMesh
+  {
+    /// @brief tePosition packed as xyz
+    std::vector<float> positions;
+    /// @brief tePatchDistance (gl_TessCoord) packed as uvw, only filled in when asked for
+    std::vector<float> patchCoords;
+    /// @brief xyz normals, only filled in by evaluators that compute them (tessellateBezierPatches)
+    std::vector<float> normals;
+    std::vector<uint32_t> indices;
+    size_t numVertices() const { return positions.size() / 3; }
+    size_t numTriangles() const { return indices.size() / 3; }
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief evaluate tesseval.glsl for one patch, normalize(u*p0 + v*p1 + w*p2) for every point of the pattern.
+  /// @param [in] _p0,_p1,_p2 the patch control points (xyz)
+  /// @param [out] o_xyz numVertices()*3 floats
+  //----------------------------------------------------------------------------------------------------------------------
+  void evaluateSpherePatch(const TessPattern &_pattern, const float *_p0, const float *_p1, const float *_p2, float *o_xyz);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief u*p0 + v*p1 + w*p2 for every point of the pattern, the flat patch used for arbitrary triangle meshes
+  //----------------------------------------------------------------------------------------------------------------------
+  void evaluateLinearPatch(const TessPattern &_pattern, const float *_p0, const float *_p1, const float *_p2, float *o_xyz);
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @class CPUTessellator
+  /// @brief tessellates a list of triangle patches, patterns are built once per set of levels and cached
+  //----------------------------------------------------------------------------------------------------------------------
+  class CPUTessellator
+  {
+  public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief get (building if needed) the pattern for these levels
+    //----------------------------------------------------------------------------------------------------------------------
+    const TessPattern &pattern(const TessLevels &_levels);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief tessellate every patch with the same levels, as the "Tess" program does with its uniforms
+    /// @param [in] _positions packed xyz control points
+    /// @param [in] _patchIndices 3 indices per patch
+    /// @param [in] _numPatches number of patches
+    /// @param [in] _levels the inner / outer levels
+    /// @param [out] o_mesh the result, previous contents are replaced
+    /// @param [in] _patchCoords also output the tePatchDistance values
+    //----------------------------------------------------------------------------------------------------------------------
+    template <typename IndexType>
+    void tessellate(const float *_positions, const IndexType *_patchIndices, size_t _numPatches,
+                    const TessLevels &_levels, TessMesh &o_mesh, bool _patchCoords = false);
+
+  private:
+    std::map<IntLevels, std::unique_ptr<TessPattern>> m_patterns;
+  };
+
+  template <typename IndexType>
+  void CPUTessellator::tessellate(const float *_positions, const IndexType *_patchIndices, size_t _numPatches,
+                                  const TessLevels &_levels, TessMesh &o_mesh, bool _patchCoords)
+  {
+    const TessPattern &p = pattern(_levels);
+    const size_t nv = p.numVertices();
+    const size_t ni = p.indices().size();
+    if (p.levels().discarded)
+    {
+      _numPatches = 0;
+    }
+    o_mesh.positions.resize(_numPatches * nv * 3);
+    o_mesh.indices.resize(_numPatches * ni);
+    o_mesh.patchCoords.resize(_patchCoords ? _numPatches * nv * 3 : 0);
+    o_mesh.normals.clear();
+    for (size_t patch = 0; patch < _numPatches; ++patch)
+    {
+      const float *p0 = &_positions[_patchIndices[patch * 3 + 0] * 3];
+      const float *p1 = &_positions[_patchIndices[patch * 3 + 1] * 3];
+      const float *p2 = &_positions[_patchIndices[patch * 3 + 2] * 3];
+      evaluateSpherePatch(p, p0, p1, p2, &o_mesh.positions[patch * nv * 3]);
+      const uint32_t base = static_cast<uint32_t>(patch * nv);
+      uint32_t *out = &o_mesh.indices[patch * ni];
+      const uint32_t *in = p.indices().data();
+      for (size_t i = 0; i < ni; ++i)
+      {
+        out[i] = in[i] + base;
+      }
+      if (_patchCoords)
+      {
+        float *pc = &o_mesh.patchCoords[patch * nv * 3];
+        for (size_t i = 0; i < nv; ++i)
+        {
+          pc[i * 3 + 0] = p.u()[i];
+          pc[i * 3 + 1] = p.v()[i];
+          pc[i * 3 + 2] = p.w()[i];
+        }
+      }
+    }
+  }
+
+} // end namespace tess
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef FRAMESTATS_H_
+#define FRAMESTATS_H_
+#include <ngl/Types.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file FrameStats.h
+/// @brief per frame GPU time and primitive counts gathered with a ring of asynchronous queries
+/// @class FrameStats
+/// @brief each frame uses the next slot of GL_TIME_ELAPSED / GL_PRIMITIVES_GENERATED queries and results are
+/// read back a few frames later once GL says they are available, so reading the stats never waits for the GPU.
+/// If the GPU is so far behind that the next slot is still in flight the frame is simply not measured. The shown
+/// times are means republished every ShowIntervalMS for the HUD, whose text would otherwise change every frame.
+//----------------------------------------------------------------------------------------------------------------------
+class FrameStats
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief number of frames that can be in flight before we skip measuring
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr size_t Latency = 4;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief number of different tags results are kept for (e.g. one per pipeline)
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr size_t MaxTags = 6;
+  static constexpr float ShowIntervalMS = 250.0f;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the queries, needs a current context
+  //----------------------------------------------------------------------------------------------------------------------
+  void init();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief delete the queries, needs a current context
+  //----------------------------------------------------------------------------------------------------------------------
+  void release();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief start measuring the draw calls of this frame, the results are filed under _tag
+  //----------------------------------------------------------------------------------------------------------------------
+  void begin(size_t _tag);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief stop measuring, must pair with begin
+  //----------------------------------------------------------------------------------------------------------------------
+  void end();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief read back every slot that has finished, oldest first, without blocking
+  //----------------------------------------------------------------------------------------------------------------------
+  void collect();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the CPU time of the last frame is measured by the caller and stored here, call once a frame after
+  /// collect(), it also republishes the shown times when ShowIntervalMS has passed
+  //----------------------------------------------------------------------------------------------------------------------
+  void setCPUTime(float _ms);
+  float cpuMS() const { return m_cpuMS; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief latest results, these lag the current frame by up to Latency frames
+  //----------------------------------------------------------------------------------------------------------------------
+  float gpuMS() const { return m_gpuMS; }
+  float gpuMS(size_t _tag) const { return m_gpuMSByTag[_tag]; }
+  uint64_t primitives() const { return m_primitives; }
+  uint64_t primitives(size_t _tag) const { return m_primitivesByTag[_tag]; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief total number of frames collected, useful to see if anything new arrived
+  //----------------------------------------------------------------------------------------------------------------------
+  uint64_t framesCollected() const { return m_framesCollected; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the means over the last ShowIntervalMS, a tag not drawn in that time keeps its previous mean
+  //----------------------------------------------------------------------------------------------------------------------
+  float shownCPUMS() const { return m_shownCPUMS; }
+  float shownGPUMS() const { return m_shownGPUMS; }
+  float shownGPUMS(size_t _tag) const { return m_shownGPUMSByTag[_tag]; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how many times the shown times have been republished, so other HUD values can follow the same cadence
+  //----------------------------------------------------------------------------------------------------------------------
+  uint64_t shownUpdates() const { return m_shownUpdates; }
+
+private:
+  struct Slot
+  {
+    GLuint time = 0;
+    GLuint primitives = 0;
+    size_t tag = 0;
+    uint64_t frame = 0;
+    bool pending = false;
+  };
+  std::array<Slot, Latency> m_slots;
+  size_t m_next = 0;
+  uint64_t m_frame = 0;
+  bool m_active = false;
+  float m_cpuMS = 0.0f;
+  float m_gpuMS = 0.0f;
+  std::array<float, MaxTags> m_gpuMSByTag = {};
+  uint64_t m_primitives = 0;
+  std::array<uint64_t, MaxTags> m_primitivesByTag = {};
+  uint64_t m_framesCollected = 0;
+  // sums since the shown times were last republished
+  double m_cpuSum = 0.0;
+  size_t m_cpuFrames = 0;
+  double m_gpuSum = 0.0;
+  size_t m_gpuFrames = 0;
+  std::array<double, MaxTags> m_gpuSumByTag = {};
+  std::array<size_t, MaxTags> m_gpuFramesByTag = {};
+  float m_shownCPUMS = 0.0f;
+  float m_shownGPUMS = 0.0f;
+  std::array<float, MaxTags> m_shownGPUMSByTag = {};
+  uint64_t m_shownUpdates = 0;
+  std::chrono::steady_clock::time_point m_lastShown;
+};
+
+#endif
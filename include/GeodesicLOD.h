@@ -0,0 +1,56 @@
+#ifndef GEODESICLOD_H_
+#define GEODESICLOD_H_
+#include <ngl/Types.h>
+#include <cstddef>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file GeodesicLOD.h
+/// @brief the icosphere the Tess program generates is fully determined by the level, so this builds every uniform
+/// level once with the CPU tessellator and draws the chosen one as plain triangles
+/// @class GeodesicLOD
+/// @brief all levels are packed into one vertex buffer (position + patch coordinate) and one 32 bit index buffer,
+/// each level is drawn with glDrawElementsBaseVertex from its own offsets
+//----------------------------------------------------------------------------------------------------------------------
+class GeodesicLOD
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief tessellate levels 1.._maxLevel (inner == outer) and upload them, needs a current context
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit GeodesicLOD(int _maxLevel);
+  ~GeodesicLOD();
+  GeodesicLOD(const GeodesicLOD &) = delete;
+  GeodesicLOD &operator=(const GeodesicLOD &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw level _level (clamped to the levels we built) with whatever program is active
+  //----------------------------------------------------------------------------------------------------------------------
+  void draw(int _level) const;
+  int maxLevel() const { return static_cast<int>(m_levels.size()); }
+  size_t numTriangles(int _level) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief GPU memory used by all the levels
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t bytes() const { return m_bytes; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief CPU time it took to tessellate and pack every level
+  //----------------------------------------------------------------------------------------------------------------------
+  double buildMS() const { return m_buildMS; }
+
+private:
+  struct Level
+  {
+    size_t firstIndex = 0;
+    GLsizei indexCount = 0;
+    GLint baseVertex = 0;
+  };
+  int clampLevel(int _level) const;
+  std::vector<Level> m_levels;
+  GLuint m_vao = 0;
+  GLuint m_vbo = 0;
+  GLuint m_ibo = 0;
+  size_t m_bytes = 0;
+  double m_buildMS = 0.0;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef GPUTRACE_H_
+#define GPUTRACE_H_
+#include "TessTrace.h"
+#include <ngl/Types.h>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file GpuTrace.h
+/// @brief GPU zones for the Chrome trace, measured with GL_TIMESTAMP queries
+/// @class GpuTrace
+/// @brief begin / end put a timestamp query either side of the GL commands of a zone. Like FrameStats the queries
+/// are only read back once GL says they are available, collect() is called once a frame and never waits. The GPU
+/// clock is mapped onto the Trace clock with an offset measured with glGetInteger64v(GL_TIMESTAMP) every
+/// CalibrateFrames, and each zone gets a flow arrow from the point on the CPU where it was submitted, so the
+/// trace shows how far the GPU runs behind. Zones nest; when MaxZones are in flight new ones are not measured.
+//----------------------------------------------------------------------------------------------------------------------
+class GpuTrace
+{
+public:
+  static constexpr size_t MaxZones = 256;
+  static constexpr int CalibrateFrames = 120;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the queries and the "GPU" track, needs a current context. Does nothing in builds without
+  /// TESS_ENABLE_TRACE, so they make no queries and no timestamp calls
+  //----------------------------------------------------------------------------------------------------------------------
+  void init();
+  void release();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief mark the start / end of a zone in the command stream, _name must outlive the trace
+  //----------------------------------------------------------------------------------------------------------------------
+  void begin(const char *_name);
+  void end();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief hand every zone the GPU has finished to the Trace, oldest first, without blocking
+  //----------------------------------------------------------------------------------------------------------------------
+  void collect();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief wait for the GPU and collect everything, before writing the trace at shut down
+  //----------------------------------------------------------------------------------------------------------------------
+  void finish();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief zones not measured because all the queries were in flight
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t skipped() const { return m_skipped; }
+
+private:
+  struct Zone
+  {
+    GLuint start = 0;
+    GLuint end = 0;
+    const char *name = nullptr;
+    uint64_t submitNS = 0;
+    uint32_t frame = 0;
+    bool open = false;
+  };
+  void calibrate();
+  /// @brief a ring, m_oldest is the first zone not yet collected
+  std::vector<Zone> m_zones;
+  size_t m_oldest = 0;
+  size_t m_used = 0;
+  /// @brief the zones begun and not ended, NoZone for the ones that weren't measured
+  std::vector<size_t> m_open;
+  static constexpr size_t NoZone = ~size_t(0);
+  uint32_t m_track = 0;
+  /// @brief Trace::now() - GL_TIMESTAMP
+  int64_t m_offset = 0;
+  int m_framesSinceCalibrate = 0;
+  size_t m_skipped = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief records the GL commands of the scope it is declared in, use TESS_TRACE_GPU_ZONE
+//----------------------------------------------------------------------------------------------------------------------
+class GpuTraceZone
+{
+public:
+  GpuTraceZone(GpuTrace &_trace, const char *_name) : m_trace(_trace) { m_trace.begin(_name); }
+  ~GpuTraceZone() { m_trace.end(); }
+  GpuTraceZone(const GpuTraceZone &) = delete;
+  GpuTraceZone &operator=(const GpuTraceZone &) = delete;
+
+private:
+  GpuTrace &m_trace;
+};
+
+#ifdef TESS_ENABLE_TRACE
+#define TESS_TRACE_GPU_ZONE(_trace, _name) GpuTraceZone TESS_TRACE_CONCAT(tessTraceGpuZone, __LINE__)(_trace, _name)
+#else
+#define TESS_TRACE_GPU_ZONE(_trace, _name) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef HUDTEXT_H_
+#define HUDTEXT_H_
+#include "ProgramCache.h"
+#include <ngl/Types.h>
+#include <QImage>
+#include <array>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file HudText.h
+/// @brief text overlay for the frame statistics
+/// @class HudText
+/// @brief draws a few lines of text from a glyph atlas built once from a TrueType font. The quads for all the
+/// lines live in one vertex buffer that is only rebuilt when the text of a line changes, drawing an unchanged HUD
+/// is a single draw call with no layout work.
+//----------------------------------------------------------------------------------------------------------------------
+class HudText
+{
+public:
+  static constexpr char FirstGlyph = 32;
+  static constexpr char LastGlyph = 126;
+  struct Glyph
+  {
+    float u0 = 0.0f;
+    float v0 = 0.0f;
+    float u1 = 0.0f;
+    float v1 = 0.0f;
+    float advance = 0.0f;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the rasterised glyphs and their layout, everything but the GL objects
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Atlas
+  {
+    QImage image;
+    std::array<Glyph, LastGlyph - FirstGlyph + 1> glyphs;
+    float cellWidth = 0.0f;
+    float lineHeight = 0.0f;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how long loading the font and drawing the glyphs took
+    //----------------------------------------------------------------------------------------------------------------------
+    double ms = 0.0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief load the font and draw the glyphs into an image, needs no context so it can run on a worker thread
+  /// while the window starts (QFont and QPainter on a QImage are safe off the GUI thread)
+  /// @param [in] _font the .ttf file to use
+  /// @param [in] _pixelSize the font size in pixels
+  //----------------------------------------------------------------------------------------------------------------------
+  static Atlas buildAtlas(const std::string &_font, int _pixelSize);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the "HudText" program, it must be built before the first draw
+  //----------------------------------------------------------------------------------------------------------------------
+  static ProgramRequest programRequest();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief upload _atlas, needs a current context
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit HudText(const Atlas &_atlas);
+  ~HudText();
+  HudText(const HudText &) = delete;
+  HudText &operator=(const HudText &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the size of the viewport in pixels
+  //----------------------------------------------------------------------------------------------------------------------
+  void setScreenSize(int _w, int _h);
+  void setColour(float _r, float _g, float _b);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set the text of line _line (counted from the top), only marks the geometry dirty if it changed
+  //----------------------------------------------------------------------------------------------------------------------
+  void setLine(size_t _line, const std::string &_text);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw all the lines, rebuilding the vertex buffer first if any line changed
+  //----------------------------------------------------------------------------------------------------------------------
+  void draw();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how many times the geometry has been rebuilt
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t rebuilds() const { return m_rebuilds; }
+
+private:
+  void rebuild();
+  std::array<Glyph, LastGlyph - FirstGlyph + 1> m_glyphs;
+  float m_cellWidth = 0.0f;
+  float m_lineHeight = 0.0f;
+  std::vector<std::string> m_lines;
+  bool m_dirty = true;
+  size_t m_rebuilds = 0;
+  GLsizei m_numVerts = 0;
+  GLuint m_texture = 0;
+  GLuint m_vao = 0;
+  GLuint m_vbo = 0;
+  int m_width = 1;
+  int m_height = 1;
+  std::array<float, 3> m_colour = {{1.0f, 1.0f, 1.0f}};
+};
+
+#endif
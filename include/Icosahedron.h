@@ -0,0 +1,62 @@
+#ifndef ICOSAHEDRON_H_
+#define ICOSAHEDRON_H_
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Icosahedron.h
+/// @brief the control mesh used for the tessellation demo, shared by the GL path in NGLScene and the
+/// CPU reference tessellator so both always work on exactly the same patches
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief triangle patch indices, 3 per patch (20 patches)
+  //----------------------------------------------------------------------------------------------------------------------
+  constexpr std::array<uint8_t, 60> IcosahedronFaces = {
+      2, 1, 0,
+      3, 2, 0,
+      4, 3, 0,
+      5, 4, 0,
+      1, 5, 0,
+
+      11, 6, 7,
+      11, 7, 8,
+      11, 8, 9,
+      11, 9, 10,
+      11, 10, 6,
+
+      1, 2, 6,
+      2, 3, 7,
+      3, 4, 8,
+      4, 5, 9,
+      5, 1, 10,
+
+      2, 7, 6,
+      3, 8, 7,
+      4, 9, 8,
+      5, 10, 9,
+      1, 6, 10};
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief vertex positions as packed xyz (12 vertices)
+  //----------------------------------------------------------------------------------------------------------------------
+  constexpr std::array<float, 36> IcosahedronVerts = {
+      0.000f, 0.000f, 1.000f,
+      0.894f, 0.000f, 0.447f,
+      0.276f, 0.851f, 0.447f,
+      -0.724f, 0.526f, 0.447f,
+      -0.724f, -0.526f, 0.447f,
+      0.276f, -0.851f, 0.447f,
+      0.724f, 0.526f, -0.447f,
+      -0.276f, 0.851f, -0.447f,
+      -0.894f, 0.000f, -0.447f,
+      -0.276f, -0.851f, -0.447f,
+      0.724f, -0.526f, -0.447f,
+      0.000f, 0.000f, -1.000f};
+
+  constexpr size_t IcosahedronPatchCount = IcosahedronFaces.size() / 3;
+  constexpr size_t IcosahedronVertexCount = IcosahedronVerts.size() / 3;
+} // end namespace tess
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef INPUTRECORDER_H_
+#define INPUTRECORDER_H_
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InputRecorder.h
+/// @brief the window's mouse and key input logged to a file and played back frame by frame, so performance runs
+/// can be repeated over exactly the same views and tessellation levels. The log is text, a header then one event
+/// per line:
+/// @code
+/// tessinput 1
+/// size 1024 720
+/// level 1 1
+/// <frame> <ms> press <x> <y> <button>
+/// <frame> <ms> release <x> <y> <button>
+/// <frame> <ms> move <x> <y> <buttons>
+/// <frame> <ms> wheel <dx> <dy>
+/// <frame> <ms> key <key>
+/// <frame> <ms> end
+/// @endcode
+/// frame is the number of frames drawn before the event arrived, ms the time since recording started which is
+/// only there for reading, replay goes by frame. The buttons and keys are Qt's values.
+//----------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the parts of the Qt input events NGLScene acts on
+//----------------------------------------------------------------------------------------------------------------------
+struct InputEvent
+{
+  enum class Type
+  {
+    MousePress,
+    MouseRelease,
+    MouseMove,
+    Wheel,
+    Key
+  };
+  Type type = Type::Key;
+  uint64_t frame = 0;
+  double ms = 0.0;
+  double x = 0.0;
+  double y = 0.0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the button for press / release, all held buttons for a move
+  //----------------------------------------------------------------------------------------------------------------------
+  int buttons = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief angleDelta of a wheel event
+  //----------------------------------------------------------------------------------------------------------------------
+  int deltaX = 0;
+  int deltaY = 0;
+  int key = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the state a log starts from, replay puts the window back into it
+//----------------------------------------------------------------------------------------------------------------------
+struct InputSession
+{
+  int width = 1024;
+  int height = 720;
+  float innerLevel = 1.0f;
+  float outerLevel = 1.0f;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class InputRecorder
+/// @brief writes events as they arrive, the end line goes in when it is destroyed
+//----------------------------------------------------------------------------------------------------------------------
+class InputRecorder
+{
+public:
+  ~InputRecorder();
+  bool open(const std::string &_fname, const InputSession &_session);
+  void record(InputEvent _event);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief call after each frame is drawn
+  //----------------------------------------------------------------------------------------------------------------------
+  void endFrame() { ++m_frame; }
+  size_t events() const { return m_events; }
+
+private:
+  double msSinceOpen() const;
+  std::ofstream m_file;
+  std::chrono::steady_clock::time_point m_start;
+  uint64_t m_frame = 0;
+  size_t m_events = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class InputReplay
+/// @brief hands back a log's events a frame at a time and keeps the frame times seen while doing it
+//----------------------------------------------------------------------------------------------------------------------
+class InputReplay
+{
+public:
+  bool load(const std::string &_fname);
+  const InputSession &session() const { return m_session; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the events recorded before the frame about to be drawn, in order
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<InputEvent> due() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief call after each frame is drawn with its CPU time, and the GPU time when a new one has arrived (< 0 if not)
+  //----------------------------------------------------------------------------------------------------------------------
+  void endFrame(float _cpuMS, float _gpuMS);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief every frame of the recording has been drawn
+  //----------------------------------------------------------------------------------------------------------------------
+  bool finished() const { return m_frame > m_endFrame; }
+  uint64_t frame() const { return m_frame; }
+  uint64_t frames() const { return m_endFrame + 1; }
+  size_t events() const { return m_events.size(); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief frames, wall time and the mean / 95th percentile CPU and GPU frame times of the replay so far
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string summary() const;
+
+private:
+  InputSession m_session;
+  std::vector<InputEvent> m_events;
+  size_t m_next = 0;
+  uint64_t m_frame = 0;
+  uint64_t m_endFrame = 0;
+  std::vector<float> m_cpuMS;
+  std::vector<float> m_gpuMS;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+#endif
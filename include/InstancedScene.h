@@ -0,0 +1,97 @@
+#ifndef INSTANCEDSCENE_H_
+#define INSTANCEDSCENE_H_
+#include <ngl/Types.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file InstancedScene.h
+/// @brief a field of tessellated spheres drawn entirely from GPU buffers, needs GL 4.3
+/// @class InstancedScene
+/// @brief every instance's transform and bounding sphere lives in a shader storage buffer. Each frame instcull.glsl
+/// tests the instances against the frustum, picks a control mesh LOD from the distance to the eye and fills in one
+/// DrawElementsIndirect command per LOD, then the whole field is drawn with a single glMultiDrawElementsIndirect.
+/// The CPU work per frame is the same whatever the instance count.
+//----------------------------------------------------------------------------------------------------------------------
+class InstancedScene
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief shader storage binding points used by instcull.glsl and insteval.glsl
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr GLuint InstanceBufferBinding = 0;
+  static constexpr GLuint VisibleBufferBinding = 1;
+  static constexpr GLuint CommandBufferBinding = 2;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief control meshes from near to far, icospheres of 2, 1 and 0 subdivisions
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr int LODCount = 3;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief true if the current context has compute shaders and multi draw indirect (GL 4.3)
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool supported();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief lay out _instances spheres on a grid in the xz plane _spacing apart with random size and rotation and
+  /// upload everything, needs a current context
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit InstancedScene(size_t _instances, float _spacing = 3.0f);
+  ~InstancedScene();
+  InstancedScene(const InstancedScene &) = delete;
+  InstancedScene &operator=(const InstancedScene &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief look up the cull pass uniforms of _program once it has linked, cull() sets them through these
+  //----------------------------------------------------------------------------------------------------------------------
+  void setCullProgram(GLuint _program);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief reset the draw commands and run the cull pass, the InstanceCull program given to setCullProgram must be
+  /// active and the ObjectBlock bound
+  /// @param [in] _lodDistance instances further away than this use the next coarser mesh
+  //----------------------------------------------------------------------------------------------------------------------
+  void cull(float _lodDistance);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the commands written by the last cull with the TessInstanced program
+  //----------------------------------------------------------------------------------------------------------------------
+  void draw() const;
+  size_t numInstances() const { return m_numInstances; }
+  size_t lodPatches(int _lod) const { return m_commands[_lod].count / 3; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief GPU memory for the meshes, instances, visible list and commands
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t bytes() const { return m_bytes; }
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief std430 layout of one instance, the Instance struct in the shaders
+  //----------------------------------------------------------------------------------------------------------------------
+  struct InstanceData
+  {
+    float model[16];
+    float sphere[4];
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the GL DrawElementsIndirectCommand
+  //----------------------------------------------------------------------------------------------------------------------
+  struct DrawCommand
+  {
+    GLuint count = 0;
+    GLuint instanceCount = 0;
+    GLuint firstIndex = 0;
+    GLint baseVertex = 0;
+    GLuint baseInstance = 0;
+  };
+
+private:
+  size_t m_numInstances = 0;
+  size_t m_bytes = 0;
+  std::array<DrawCommand, LODCount> m_commands;
+  GLuint m_vao = 0;
+  GLuint m_vbo = 0;
+  GLuint m_ibo = 0;
+  GLuint m_instanceBuffer = 0;
+  GLuint m_visibleBuffer = 0;
+  GLuint m_commandBuffer = 0;
+  GLint m_instanceCountLocation = -1;
+  GLint m_lodDistanceLocation = -1;
+};
+
+#endif
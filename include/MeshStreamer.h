@@ -0,0 +1,111 @@
+#ifndef MESHSTREAMER_H_
+#define MESHSTREAMER_H_
+#include "PatchMeshFile.h"
+#include <ngl/Types.h>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file MeshStreamer.h
+/// @brief streams a .tpm control mesh to the GPU a few chunks per frame
+/// @class MeshStreamer
+/// @brief the file is memory mapped, never read into a buffer of its own. The GPU buffers are allocated up front
+/// and filled block by block through a staging ring of Slots chunks: each chunk is copied from the mapping into a
+/// free slot, glCopyBufferSubData moves it to its destination and a fence frees the slot again. With GL 4.4 the
+/// staging buffer is persistently mapped (as in UniformRing), older contexts glBufferSubData the slot. A slot the
+/// GPU is still copying from ends the frame's upload instead of waiting, so drawing never stalls on the file.
+/// Every block whose vertices, indices and hints are all resident is drawn, the rest of the mesh appears as it
+/// arrives.
+//----------------------------------------------------------------------------------------------------------------------
+class MeshStreamer
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief size of one staging slot and the number of slots in the ring
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr size_t ChunkBytes = 4 * 1024 * 1024;
+  static constexpr size_t Slots = 4;
+  MeshStreamer() = default;
+  ~MeshStreamer();
+  MeshStreamer(const MeshStreamer &) = delete;
+  MeshStreamer &operator=(const MeshStreamer &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief map _fname and allocate the GPU buffers, nothing is uploaded yet. Needs a current context
+  //----------------------------------------------------------------------------------------------------------------------
+  bool open(const std::string &_fname);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief upload up to _maxChunks chunks, the mapping is closed once the whole mesh is resident
+  /// @returns the number of chunks uploaded
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t update(size_t _maxChunks = Slots);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the resident patches as 3 vertex GL_PATCHES
+  //----------------------------------------------------------------------------------------------------------------------
+  void draw() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief bind the per patch hints (a GL_R32F buffer texture indexed by gl_PrimitiveID) to _unit
+  //----------------------------------------------------------------------------------------------------------------------
+  void bindHints(GLuint _unit) const;
+  bool hasHints() const { return m_hasHints; }
+  bool complete() const { return m_numPatches > 0 && m_residentPatches == m_numPatches; }
+  bool persistent() const { return m_mapped != nullptr; }
+  size_t numPatches() const { return m_numPatches; }
+  size_t numVertices() const { return m_numVertices; }
+  size_t residentPatches() const { return m_residentPatches; }
+  size_t bytesUploaded() const { return m_bytesUploaded; }
+  size_t totalBytes() const { return m_totalBytes; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how many times update found the next staging slot still in use by the GPU
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t stalls() const { return m_stalls; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ms from open to the first drawable block and to the whole mesh
+  //----------------------------------------------------------------------------------------------------------------------
+  float firstBlockMS() const { return m_firstBlockMS; }
+  float loadMS() const { return m_loadMS; }
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the next free staging slot, false if the GPU has not finished with it yet
+  //----------------------------------------------------------------------------------------------------------------------
+  bool acquireSlot();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief copy bytes [io_done, _end) of a section of the file into the same range of _buffer
+  /// @returns true once io_done reaches _end, false if it ran out of chunks or slots first
+  //----------------------------------------------------------------------------------------------------------------------
+  bool upload(GLuint _buffer, const uint8_t *_src, size_t &io_done, size_t _end, size_t &io_chunks, size_t _maxChunks);
+  void release();
+
+  tess::MappedPatchMesh m_file;
+  GLuint m_vao = 0;
+  GLuint m_vbo = 0;
+  GLuint m_ibo = 0;
+  GLuint m_hintBuffer = 0;
+  GLuint m_hintTexture = 0;
+  GLuint m_staging = 0;
+  uint8_t *m_mapped = nullptr;
+  std::array<GLsync, Slots> m_fences = {};
+  size_t m_slot = 0;
+  GLenum m_indexType = GL_UNSIGNED_INT;
+  bool m_hasHints = false;
+  size_t m_numPatches = 0;
+  size_t m_numVertices = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the next block to finish and how many bytes of each section are already on the GPU
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t m_block = 0;
+  size_t m_vertexBytes = 0;
+  size_t m_indexBytes = 0;
+  size_t m_hintBytes = 0;
+  size_t m_residentPatches = 0;
+  size_t m_bytesUploaded = 0;
+  size_t m_totalBytes = 0;
+  size_t m_stalls = 0;
+  std::chrono::steady_clock::time_point m_openTime;
+  float m_firstBlockMS = 0.0f;
+  float m_loadMS = 0.0f;
+};
+
+#endif
@@ -2,9 +2,28 @@
 #define NGLSCENE_H_
 #include <ngl/AbstractVAO.h>
 #include <ngl/Transformation.h>
-#include <ngl/Text.h>
+#include "AppOptions.h"
+#include "FrameStats.h"
+#include "GeodesicLOD.h"
+#include "GpuTrace.h"
+#include "HudText.h"
+#include "InputRecorder.h"
+#include "InstancedScene.h"
+#include "MeshStreamer.h"
+#include "PatchMesh.h"
+#include "ProgramBatch.h"
+#include "TerrainScene.h"
+#include "TessCapture.h"
+#include "TessLevelController.h"
+#include "TessVariants.h"
+#include "UniformRing.h"
 #include <QOpenGLWindow>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
 #include <memory>
+#include <string>
 
 //----------------------------------------------------------------------------------------------------------------------
 /// @file NGLScene.h
@@ -24,9 +43,10 @@ class NGLScene : public QOpenGLWindow
   public:
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief ctor for our NGL drawing class
-    /// @param [in] parent the parent window to the class
+    /// @param [in] _options the command line options
+    /// @param [in] _replay the already loaded --replay log, null when not replaying
     //----------------------------------------------------------------------------------------------------------------------
-    NGLScene();
+    NGLScene(const AppOptions &_options, std::unique_ptr<InputReplay> _replay = nullptr);
     //----------------------------------------------------------------------------------------------------------------------
     /// @brief dtor must close down ngl and release OpenGL resources
     //----------------------------------------------------------------------------------------------------------------------
@@ -47,6 +67,10 @@ class NGLScene : public QOpenGLWindow
     void resizeGL(QResizeEvent *_event);
     // Qt 5.x uses this instead! http://doc.qt.io/qt-5/qopenglwindow.html#resizeGL
     void resizeGL(int _w, int _h);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the size to open the window at, a replay is drawn at the size it was recorded at
+    //----------------------------------------------------------------------------------------------------------------------
+    QSize initialSize() const;
 
 
 private:
@@ -108,15 +132,70 @@ private:
     //----------------------------------------------------------------------------------------------------------------------
     ngl::Vec3 m_modelPos;
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief text rendering
+    /// @brief text rendering for the statistics overlay
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<HudText> m_hud;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the HUD's glyphs, drawn on a worker thread started in the ctor and uploaded by the first frame to find
+    /// them ready
+    //----------------------------------------------------------------------------------------------------------------------
+    std::future<HudText::Atlas> m_hudAtlas;
+    double m_hudAtlasMS = 0.0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the programs submitted in initializeGL, until they are all linked paintGL only clears the window.
+    /// Released once the scene has drawn its first frame
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<ProgramBatch> m_startupPrograms;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the time to first frame breakdown: ctor to initializeGL (the window and context), initializeGL itself
+    /// and the placeholder frames drawn while the programs were built
+    //----------------------------------------------------------------------------------------------------------------------
+    std::chrono::steady_clock::time_point m_startTime;
+    double m_contextMS = 0.0;
+    double m_initMS = 0.0;
+    int m_placeholderFrames = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief print the breakdown after the first real frame
+    //----------------------------------------------------------------------------------------------------------------------
+    void reportStartup();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief create m_hud if the atlas has finished and isn't already uploaded
+    //----------------------------------------------------------------------------------------------------------------------
+    void createHud();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief CPU / GPU frame times and primitive counts gathered without stalling
+    //----------------------------------------------------------------------------------------------------------------------
+    FrameStats m_stats;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief GPU zones of the --trace file, written when the window closes
+    //----------------------------------------------------------------------------------------------------------------------
+    GpuTrace m_gpuTrace;
+    std::string m_traceFile;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief triple buffered storage for the FrameBlock / ObjectBlock uniform blocks
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<UniformRing> m_uniforms;
+    static constexpr size_t UniformRingFrameBytes = 16 * 1024;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief set the overlay text for this frame
     //----------------------------------------------------------------------------------------------------------------------
-    std::unique_ptr<ngl::Text> m_text;
+    void updateHud();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief averages that aren't FrameStats' own, taken when it republishes its shown times
+    //----------------------------------------------------------------------------------------------------------------------
+    uint64_t m_hudTimesUpdate = 0;
+    float m_hudControllerMS = 0.0f;
+    float m_hudTerrainLoadMS = 0.0f;
 
     //----------------------------------------------------------------------------------------------------------------------
-    /// @brief method to load transform matrices to the shader
+    /// @brief write this frame's uniform blocks and bind them
     //----------------------------------------------------------------------------------------------------------------------
     void loadMatricesToShader();
     //----------------------------------------------------------------------------------------------------------------------
+    /// @brief projection[1][1] * viewport height / 2, used to turn view space sizes into pixels
+    //----------------------------------------------------------------------------------------------------------------------
+    float projectionScale() const;
+    //----------------------------------------------------------------------------------------------------------------------
     /// @brief Qt Event called when a key is pressed
     /// @param [in] _event the Qt event to query for size etc
     //----------------------------------------------------------------------------------------------------------------------
@@ -145,15 +224,177 @@ private:
     /// @param _event the Qt Event structure
     //----------------------------------------------------------------------------------------------------------------------
     void wheelEvent( QWheelEvent *_event);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief every Qt input event is turned into an InputEvent and goes through here, so the recorder sees exactly
+    /// what the scene acts on and a replay drives the scene the same way
+    /// @param [in] _replayed the event comes from m_replay, anything else is ignored while replaying
+    //----------------------------------------------------------------------------------------------------------------------
+    void input(const InputEvent &_event, bool _replayed = false);
+    void applyMousePress(const InputEvent &_event);
+    void applyMouseRelease(const InputEvent &_event);
+    void applyMouseMove(const InputEvent &_event);
+    void applyWheel(const InputEvent &_event);
+    void applyKey(const InputEvent &_event);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief --record / --replay, both count frames from the first real frame. A replay feeds each frame the events
+    /// recorded before it, keeps drawing until the recording's last frame and then prints its frame times and exits
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_recordFile;
+    std::unique_ptr<InputRecorder> m_recorder;
+    std::unique_ptr<InputReplay> m_replay;
+    uint64_t m_replayGPUFrames = 0;
+    void startInput();
+    void endInputFrame();
 
-    void createIcosahedron();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief build the sphere's control mesh from m_patchMeshSettings and upload it to m_vao
+    //----------------------------------------------------------------------------------------------------------------------
+    void createPatchMesh();
     std::unique_ptr <ngl::AbstractVAO> m_vao;
+    tess::PatchMeshSettings m_patchMeshSettings;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the control mesh as floats for the CPU side culling / level estimates and as it was uploaded
+    //----------------------------------------------------------------------------------------------------------------------
+    tess::TrianglePatchMesh m_patchMesh;
+    tess::EncodedPatchMesh m_encodedMesh;
+    double m_patchACMR = 0.0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the --mesh file streamed in over the first frames and drawn instead of the sphere. The CPU mirrors
+    /// (culled count, adaptive estimate, capture) only know the sphere so they are off while it is used
+    //----------------------------------------------------------------------------------------------------------------------
+    std::string m_meshFile;
+    std::unique_ptr<MeshStreamer> m_streamer;
     void updateInnerTess(float _v);
     void updateOuterTess(float _v);
-    inline void reset(){ m_innerLevel=1.0; m_outerLevel=1.0;}
+    void updateTargetEdgePixels(float _v);
+    inline void reset(){ m_innerLevel=1.0; m_outerLevel=1.0; m_targetEdgePixels=20.0f;}
 
     float m_innerLevel;
     float m_outerLevel;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief when true the control shader picks per edge levels from the projected edge length instead of
+    /// using m_innerLevel / m_outerLevel
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_adaptive = false;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the length in pixels adaptive mode aims for on each generated edge
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_targetEdgePixels = 20.0f;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief when true the control shader discards patches outside the frustum or facing away from the eye
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_cullPatches = false;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how many patches the cull test rejected last frame (from the CPU mirror of the shader test)
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t m_culledPatches = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief which Tess program variant is drawn
+    //----------------------------------------------------------------------------------------------------------------------
+    TessPipeline m_pipeline = TessPipeline::GeometryShader;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the spacing / winding / primitive permutation asked for (keys V O M) and the one actually drawn, which
+    /// stays on the last built program until the requested one is ready
+    //----------------------------------------------------------------------------------------------------------------------
+    TessVariant m_variant;
+    TessVariant m_drawnVariant;
+    std::unique_ptr<TessVariantTable> m_variants;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief make the program for m_variant / m_pipeline active, or the last one drawn while it is being built
+    //----------------------------------------------------------------------------------------------------------------------
+    void useTessProgram();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief use the on disk program binary cache
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_programCache = true;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw the pre tessellated sphere with plain triangles instead of GL_PATCHES
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_lodMode = false;
+    int m_lodLevels = 64;
+    std::unique_ptr<GeodesicLOD> m_lod;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the level drawn in LOD mode, only uniform levels are pre built so take the larger of the two
+    //----------------------------------------------------------------------------------------------------------------------
+    int lodLevel() const { return static_cast<int>(std::max(m_innerLevel, m_outerLevel)); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief FrameStats tag for the LOD mode, the pipelines use 0 and 1
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr size_t LODStatsTag = 2;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief when true m_innerLevel / m_outerLevel are driven by m_levelController to hold the frame budget
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_autoLevels = false;
+    tess::TessLevelController m_levelController;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief FrameStats::framesCollected when the controller was last fed, so each GPU result is used once
+    //----------------------------------------------------------------------------------------------------------------------
+    uint64_t m_controllerFrames = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief feed the latest GPU time to the controller and apply its level
+    //----------------------------------------------------------------------------------------------------------------------
+    void updateAutoLevels();
+    void setAutoLevels(bool _on);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw the bicubic Bezier patches instead of the sphere
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_bezierMode = false;
+    std::string m_patchFile;
+    tess::BezierPatchMesh m_bezierPatches;
+    std::unique_ptr<ngl::AbstractVAO> m_bezierVAO;
+    static constexpr size_t BezierStatsTag = 3;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the same patches evaluated on the CPU at the current level, to compare against the GPU primitive count
+    /// and to show what the dense mesh would cost to upload
+    //----------------------------------------------------------------------------------------------------------------------
+    tess::TessMesh m_bezierReference;
+    int m_bezierReferenceLevel = 0;
+    float m_bezierReferenceMS = 0.0f;
+    void loadBezierPatches();
+    void updateBezierReference();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief transform feedback capture of the tessellated sphere, m_captureFile is the pending request
+    //----------------------------------------------------------------------------------------------------------------------
+    std::unique_ptr<TessCapture> m_capture;
+    std::string m_captureFile;
+    int m_captureCount = 0;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief cap on the capture buffer (36 bytes a triangle) for the heavily subdivided meshes
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr size_t MaxCaptureTriangles = 4 * 1024 * 1024;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief draw a field of m_numInstances spheres culled and submitted on the GPU, null without GL 4.3
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_instancedMode = false;
+    int m_numInstances = 20000;
+    std::unique_ptr<InstancedScene> m_instanced;
+    static constexpr float InstanceLODDistance = 12.0f;
+    static constexpr size_t InstancedStatsTag = 4;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief fly over a height mapped terrain streamed from m_terrainFile, or generated when there is none.
+    /// m_terrain (the loader thread and the tile pool) is only made by createTerrain the first time the mode is on
+    //----------------------------------------------------------------------------------------------------------------------
+    bool m_terrainMode = false;
+    std::string m_terrainFile;
+    std::unique_ptr<TerrainScene> m_terrain;
+    static constexpr size_t TerrainStatsTag = 5;
+    void createTerrain();
+    void captureFrame();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief read back the scene (before the HUD is drawn) to m_screenshotFile, then clear the request
+    //----------------------------------------------------------------------------------------------------------------------
+    void saveScreenshot();
+    std::string m_screenshotFile;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the levels the first frame is drawn at, --level for both or those of the --replay recording
+    //----------------------------------------------------------------------------------------------------------------------
+    float m_startInnerLevel = 1.0f;
+    float m_startOuterLevel = 1.0f;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief what the CPU model of the Tess program says this frame generates, taking adaptive levels and
+    /// culling into account
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t expectedTriangles();
 };
 
 
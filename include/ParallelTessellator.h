@@ -0,0 +1,119 @@
+#ifndef PARALLELTESSELLATOR_H_
+#define PARALLELTESSELLATOR_H_
+#include "CPUTessellator.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ParallelTessellator.h
+/// @brief CPU tessellation of large triangle control meshes across a ThreadPool, producing one welded mesh
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how the generated points are placed
+  //----------------------------------------------------------------------------------------------------------------------
+  enum class PatchEvaluation
+  {
+    /// @brief normalize(u*p0 + v*p1 + w*p2), what tesseval.glsl does for the icosphere
+    Sphere,
+    /// @brief u*p0 + v*p1 + w*p2, subdivides any triangle mesh in place
+    Linear
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief levels for one patch. Patches sharing an edge must give it the same outer level, which holds for
+  /// uniform levels and for adaptiveEdgeLevel
+  //----------------------------------------------------------------------------------------------------------------------
+  using PatchLevelFunction = std::function<TessLevels(size_t _patch)>;
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @class ParallelTessellator
+  /// @brief tessellates every patch of an indexed triangle mesh and welds the result so neighbouring patches share
+  /// their corner and edge vertices, giving a watertight indexed mesh instead of one block of vertices per patch.
+  /// Vertices are laid out as [control points | edge points | interior points]:
+  ///  - corners are the control points themselves,
+  ///  - each mesh edge gets one run of outer level - 1 points, written only by the first patch using the edge (its
+  ///    owner) and referenced in the reverse order by a neighbour that walks the edge the other way,
+  ///  - interior points and the triangles are written into per worker arenas and copied out in patch order at
+  ///    the end, so the output is the same whatever the thread count or scheduling.
+  //----------------------------------------------------------------------------------------------------------------------
+  class ParallelTessellator
+  {
+  public:
+    explicit ParallelTessellator(ThreadPool &_pool);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief tessellate _numPatches triangles
+    /// @param [in] _positions packed xyz control points
+    /// @param [in] _numPositions number of control points
+    /// @param [in] _patchIndices 3 indices per patch
+    /// @param [in] _levels levels per patch
+    /// @param [in] _evaluation sphere or flat patches
+    /// @param [out] o_mesh positions and indices, previous contents are replaced
+    //----------------------------------------------------------------------------------------------------------------------
+    void tessellate(const float *_positions, size_t _numPositions, const uint32_t *_patchIndices, size_t _numPatches,
+                    const PatchLevelFunction &_levels, PatchEvaluation _evaluation, TessMesh &o_mesh);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief patches handed to a worker at a time
+    //----------------------------------------------------------------------------------------------------------------------
+    void setGrain(size_t _grain) { m_grain = _grain; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief where the time of the last tessellate went
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Timings
+    {
+      /// @brief finding the shared edges, the only serial part
+      double edgesMS = 0.0;
+      double patchesMS = 0.0;
+      double mergeMS = 0.0;
+    };
+    const Timings &timings() const { return m_timings; }
+
+  private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a block of patches' output inside one arena
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Segment
+    {
+      size_t chunk = 0;
+      size_t vertexStart = 0;
+      size_t vertexCount = 0;
+      size_t indexStart = 0;
+      size_t indexCount = 0;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief everything one worker writes, including its own pattern cache as CPUTessellator isn't thread safe
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Arena
+    {
+      CPUTessellator tessellator;
+      std::vector<float> vertices;
+      std::vector<uint32_t> indices;
+      std::vector<Segment> segments;
+      std::vector<float> scratch;
+      std::vector<uint32_t> remap;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief one side of a mesh edge as seen from a patch
+    //----------------------------------------------------------------------------------------------------------------------
+    struct PatchEdge
+    {
+      uint32_t edge = 0;
+      bool owner = false;
+      bool reversed = false;
+    };
+    void buildEdges(const uint32_t *_patchIndices, size_t _numPatches);
+    ThreadPool &m_pool;
+    Timings m_timings;
+    std::vector<TessLevels> m_patchLevels;
+    size_t m_grain = 256;
+    std::vector<Arena> m_arenas;
+    std::vector<PatchEdge> m_patchEdges;
+    std::vector<size_t> m_edgeStart;
+  };
+} // end namespace tess
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PATCHCULLING_H_
+#define PATCHCULLING_H_
+#include <cstddef>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file PatchCulling.h
+/// @brief CPU mirror of patchCulled() in tesscontrol.glsl. The GL side has no cheap way to read back how many
+/// patches the control stage threw away, so the counts shown in the app come from running the same test here.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the camera values the cull test needs
+  //----------------------------------------------------------------------------------------------------------------------
+  struct CullParams
+  {
+    /// @brief column major model view projection matrix (16 floats)
+    const float *MVP = nullptr;
+    /// @brief the eye position in object space
+    float eye[3] = {0.0f, 0.0f, 0.0f};
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief conservative test, true if the sphere patch is outside the frustum or faces away from the eye
+  //----------------------------------------------------------------------------------------------------------------------
+  bool patchCulled(const float *_p0, const float *_p1, const float *_p2, const CullParams &_params);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief number of patches patchCulled rejects
+  //----------------------------------------------------------------------------------------------------------------------
+  template <typename IndexType>
+  size_t countCulledPatches(const float *_positions, const IndexType *_patchIndices, size_t _numPatches,
+                            const CullParams &_params)
+  {
+    size_t count = 0;
+    for (size_t patch = 0; patch < _numPatches; ++patch)
+    {
+      const IndexType *idx = &_patchIndices[patch * 3];
+      if (patchCulled(&_positions[idx[0] * 3], &_positions[idx[1] * 3], &_positions[idx[2] * 3], _params))
+      {
+        ++count;
+      }
+    }
+    return count;
+  }
+} // end namespace tess
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef PATCHMESH_H_
+#define PATCHMESH_H_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file PatchMesh.h
+/// @brief triangle patch control meshes for the Tess programs and the compact vertex / index encodings they are
+/// uploaded with. Everything here is GL free, TessProgram turns an EncodedPatchMesh into a VAO.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief 3 vertex patches, shared control points are stored once
+  //----------------------------------------------------------------------------------------------------------------------
+  struct TrianglePatchMesh
+  {
+    /// @brief packed xyz
+    std::vector<float> positions;
+    /// @brief 3 per patch
+    std::vector<uint32_t> patchIndices;
+    size_t numPatches() const { return patchIndices.size() / 3; }
+    size_t numVertices() const { return positions.size() / 3; }
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the icosahedron from Icosahedron.h with every face split into 4 _subdivisions times (20 * 4^n patches),
+  /// new points are pushed out to the unit sphere. 0 gives the icosahedron itself.
+  //----------------------------------------------------------------------------------------------------------------------
+  void makeIcosphere(int _subdivisions, TrianglePatchMesh &o_mesh);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief average vertex shader invocations per patch drawing _mesh through a FIFO post transform cache of
+  /// _cacheSize entries, 3 is no reuse at all and a closed triangle mesh can get close to 0.5
+  //----------------------------------------------------------------------------------------------------------------------
+  double patchACMR(const TrianglePatchMesh &_mesh, size_t _cacheSize = 32);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief sort the patches along a Morton curve through their centroids so neighbours are drawn close together,
+  /// then renumber the vertices in the order they are first used so the fetches walk forward through the buffer
+  //----------------------------------------------------------------------------------------------------------------------
+  void reorderPatches(TrianglePatchMesh &io_mesh);
+
+  enum class IndexFormat
+  {
+    UInt8,
+    UInt16,
+    UInt32
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how the control points are stored in the vertex buffer, tessvert.glsl decodes them
+  //----------------------------------------------------------------------------------------------------------------------
+  enum class PositionFormat
+  {
+    /// @brief 3 floats, 12 bytes
+    Float32,
+    /// @brief 3 normalized shorts scaled by ObjectBlock.PositionScale, padded to 8 bytes for alignment
+    Snorm16,
+    /// @brief a unit vector folded onto an octahedron as 2 normalized shorts, 4 bytes. Only the direction is kept,
+    /// which is all tesseval.glsl uses on the sphere
+    Octahedral
+  };
+  const char *indexFormatName(IndexFormat _format);
+  const char *positionFormatName(PositionFormat _format);
+  size_t indexFormatSize(IndexFormat _format);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the smallest index type that can address _numVertices
+  //----------------------------------------------------------------------------------------------------------------------
+  IndexFormat smallestIndexFormat(size_t _numVertices);
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the vertex and index buffers exactly as they are uploaded
+  //----------------------------------------------------------------------------------------------------------------------
+  struct EncodedPatchMesh
+  {
+    PositionFormat positionFormat = PositionFormat::Float32;
+    IndexFormat indexFormat = IndexFormat::UInt32;
+    std::vector<uint8_t> vertexData;
+    std::vector<uint8_t> indexData;
+    size_t vertexStride = 0;
+    size_t numVertices = 0;
+    size_t numIndices = 0;
+    /// @brief Snorm16 positions are multiplied by this in the shader, 1 for the other formats
+    float positionScale = 1.0f;
+    size_t bytes() const { return vertexData.size() + indexData.size(); }
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief encode _mesh for upload
+  /// @returns false (and leaves o_encoded empty) if _indices can't address every vertex
+  //----------------------------------------------------------------------------------------------------------------------
+  bool encodePatchMesh(const TrianglePatchMesh &_mesh, PositionFormat _positions, IndexFormat _indices,
+                       EncodedPatchMesh &o_encoded);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief what the shader gets back for vertex _vertex, using the GL snorm conversion max(c / 32767, -1)
+  //----------------------------------------------------------------------------------------------------------------------
+  void decodePosition(const EncodedPatchMesh &_encoded, size_t _vertex, float *o_xyz);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief largest distance between a decoded vertex and _mesh, against the normalized position for Octahedral
+  //----------------------------------------------------------------------------------------------------------------------
+  float maxPositionError(const TrianglePatchMesh &_mesh, const EncodedPatchMesh &_encoded);
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how NGLScene and TessBenchmark build the sphere's control mesh (--subdivisions, --positions,
+  /// --indices, --reorder)
+  //----------------------------------------------------------------------------------------------------------------------
+  struct PatchMeshSettings
+  {
+    int subdivisions = 0;
+    PositionFormat positions = PositionFormat::Float32;
+    /// @brief 8, 16 or 32, 0 picks the smallest that fits
+    int indexBits = 0;
+    bool reorder = false;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief build and encode the mesh described by _settings, an index size too small for the mesh is widened
+  //----------------------------------------------------------------------------------------------------------------------
+  void buildPatchMesh(const PatchMeshSettings &_settings, TrianglePatchMesh &o_mesh, EncodedPatchMesh &o_encoded);
+} // end namespace tess
+
+#endif
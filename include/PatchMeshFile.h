@@ -0,0 +1,97 @@
+#ifndef PATCHMESHFILE_H_
+#define PATCHMESHFILE_H_
+#include "PatchMesh.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file PatchMeshFile.h
+/// @brief the .tpm binary control mesh format and a read only memory mapping of it. A file is:
+///  - a PatchMeshFileHeader,
+///  - numVertices float xyz positions,
+///  - numPatches * 3 indices of indexSize bytes,
+///  - optionally numPatches float hints (multipliers of the patch's inner level),
+///  - numBlocks uint64 vertex counts, block b's patches only use vertices below blockVertexEnd[b] so a reader can
+///    upload (and draw) the mesh a block at a time.
+/// Every section starts on a 16 byte boundary and everything is little endian.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  constexpr uint32_t PatchMeshFileVersion = 1;
+  constexpr uint32_t PatchMeshHasHints = 1;
+
+  struct PatchMeshFileHeader
+  {
+    char magic[4] = {'T', 'P', 'M', 'F'};
+    uint32_t version = PatchMeshFileVersion;
+    /// @brief 2 or 4
+    uint32_t indexSize = 4;
+    uint32_t flags = 0;
+    uint64_t numVertices = 0;
+    uint64_t numPatches = 0;
+    uint64_t patchesPerBlock = 0;
+    uint64_t numBlocks = 0;
+    /// @brief byte offsets of the sections from the start of the file, hintsOffset is 0 without hints
+    uint64_t positionsOffset = 0;
+    uint64_t indicesOffset = 0;
+    uint64_t hintsOffset = 0;
+    uint64_t blocksOffset = 0;
+  };
+  static_assert(sizeof(PatchMeshFileHeader) == 80, "PatchMeshFileHeader is written as is");
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write _mesh as a .tpm file with the smallest index size that fits
+  /// @param [in] _hints one per patch or empty for none
+  /// @param [in] _patchesPerBlock granularity of the block table
+  //----------------------------------------------------------------------------------------------------------------------
+  bool writePatchMeshFile(const std::string &_fname, const TrianglePatchMesh &_mesh, const std::vector<float> &_hints,
+                          uint64_t _patchesPerBlock = 64 * 1024);
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @class MappedPatchMesh
+  /// @brief maps a .tpm file read only, the sections are used in place and only paged in as they are touched
+  //----------------------------------------------------------------------------------------------------------------------
+  class MappedPatchMesh
+  {
+  public:
+    MappedPatchMesh() = default;
+    ~MappedPatchMesh();
+    MappedPatchMesh(const MappedPatchMesh &) = delete;
+    MappedPatchMesh &operator=(const MappedPatchMesh &) = delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief map _fname and check the header and section sizes against the file size and the block table against
+    /// the mesh
+    //----------------------------------------------------------------------------------------------------------------------
+    bool open(const std::string &_fname);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+    const PatchMeshFileHeader &header() const { return *reinterpret_cast<const PatchMeshFileHeader *>(m_data); }
+    size_t numVertices() const { return static_cast<size_t>(header().numVertices); }
+    size_t numPatches() const { return static_cast<size_t>(header().numPatches); }
+    size_t numBlocks() const { return static_cast<size_t>(header().numBlocks); }
+    size_t indexSize() const { return header().indexSize; }
+    bool hasHints() const { return header().hintsOffset != 0; }
+    const uint8_t *positions() const { return m_data + header().positionsOffset; }
+    const uint8_t *indices() const { return m_data + header().indicesOffset; }
+    const uint8_t *hints() const { return hasHints() ? m_data + header().hintsOffset : nullptr; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief patches [0, blockPatchEnd(b)) only use vertices [0, blockVertexEnd(b))
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t blockPatchEnd(size_t _block) const;
+    size_t blockVertexEnd(size_t _block) const;
+    size_t bytes() const { return m_size; }
+
+  private:
+    bool validBlocks() const;
+    const uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+#if defined(_WIN32)
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#endif
+  };
+} // end namespace tess
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef PROGRAMBATCH_H_
+#define PROGRAMBATCH_H_
+#include "ProgramCache.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ProgramBatch.h
+/// @brief start up programs submitted together and finished as the driver completes them
+/// @class ProgramBatch
+/// @brief ShaderLib programs built the way TessVariantTable builds its variants: add() hands every stage to the
+/// driver (or the cached binary from the ProgramCache) and links without asking for any status, so with
+/// KHR_parallel_shader_compile the whole batch compiles at once on the driver's threads while the caller gets on
+/// with other work. poll() finishes the programs that are done, checking the link, saving the binary, registering
+/// the uniforms and running the request's setup. Without the extension a program is finished every PollFrames
+/// frames, which still spreads the waits over the first frames instead of stacking them up in initializeGL.
+//----------------------------------------------------------------------------------------------------------------------
+class ProgramBatch
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief frames between finishing programs without KHR_parallel_shader_compile
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr int PollFrames = 1;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief needs a current context
+  /// @param [in] _programCache load / store the programs in the on disk binary cache
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit ProgramBatch(bool _programCache);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief submit _request to the driver, it can't be used until done() (or poll() has finished it)
+  //----------------------------------------------------------------------------------------------------------------------
+  void add(ProgramRequest _request);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief finish the programs the driver is done with, call once a frame. Returns done()
+  //----------------------------------------------------------------------------------------------------------------------
+  bool poll();
+  bool done() const { return m_finished == m_entries.size(); }
+  bool parallelCompile() const { return m_parallelCompile; }
+  size_t size() const { return m_entries.size(); }
+  size_t cacheHits() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ms from the first add to the last program finishing
+  //----------------------------------------------------------------------------------------------------------------------
+  double ms() const { return m_ms; }
+
+private:
+  struct Entry
+  {
+    ProgramRequest request;
+    uint64_t cacheKey = 0;
+    bool cacheHit = false;
+    bool finished = false;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief attach, compile and link from source through ShaderLib without checking anything
+  //----------------------------------------------------------------------------------------------------------------------
+  void submitCompile(const Entry &_entry) const;
+  void finish(Entry &io_entry);
+
+  ProgramCache m_cache;
+  bool m_parallelCompile = false;
+  std::vector<Entry> m_entries;
+  size_t m_finished = 0;
+  int m_frames = 0;
+  std::chrono::steady_clock::time_point m_start;
+  double m_ms = 0.0;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef PROGRAMCACHE_H_
+#define PROGRAMCACHE_H_
+#include <ngl/ShaderLib.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ProgramCache.h
+/// @brief on disk cache of linked program binaries so start up doesn't have to compile every stage each launch
+//----------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief one stage of a program, the source is the GLSL text not a file name
+//----------------------------------------------------------------------------------------------------------------------
+struct ShaderStageSource
+{
+  std::string name;
+  ngl::ShaderType type;
+  std::string source;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief everything needed to build one ShaderLib program, so it can be built now (ProgramCache::build) or
+/// submitted with others and finished later (ProgramBatch)
+//----------------------------------------------------------------------------------------------------------------------
+struct ProgramRequest
+{
+  std::string name;
+  std::vector<ShaderStageSource> stages;
+  /// @brief extra lines added after the #version line of every stage
+  std::string defines;
+  /// @brief outputs captured with transform feedback (interleaved)
+  std::vector<std::string> feedbackVaryings;
+  /// @brief run once the program is linked and active, for block bindings and uniforms that never change
+  std::function<void()> setup;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief what happened when a program was built
+//----------------------------------------------------------------------------------------------------------------------
+struct ProgramBuildInfo
+{
+  bool cacheHit = false;
+  double ms = 0.0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ProgramCache
+/// @brief builds ShaderLib programs, storing the glGetProgramBinary result keyed by a hash of the stage sources,
+/// the defines and the GL vendor / renderer / version strings. On the next start the binary is loaded with
+/// glProgramBinary, if the driver rejects it (or anything in the key changed) we fall back to compiling.
+//----------------------------------------------------------------------------------------------------------------------
+class ProgramCache
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param [in] _enabled when false programs are always compiled and nothing is written
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit ProgramCache(bool _enabled = true);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create the ShaderLib program _program from _stages, the program is left active with its uniforms registered
+  /// @param [in] _defines extra lines (#defines, shared declarations) added after the #version line of every stage
+  /// @param [in] _feedbackVaryings outputs captured with transform feedback (interleaved), set before linking
+  //----------------------------------------------------------------------------------------------------------------------
+  ProgramBuildInfo build(const std::string &_program, const std::vector<ShaderStageSource> &_stages,
+                         const std::string &_defines = "", const std::vector<std::string> &_feedbackVaryings = {});
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief build _request and run its setup
+  //----------------------------------------------------------------------------------------------------------------------
+  ProgramBuildInfo build(const ProgramRequest &_request);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the directory the binaries are stored in
+  //----------------------------------------------------------------------------------------------------------------------
+  const std::string &directory() const { return m_directory; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief read a whole text file, empty if it can't be opened
+  //----------------------------------------------------------------------------------------------------------------------
+  static std::string readFile(const std::string &_fname);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief insert _defines after the #version line of _source
+  //----------------------------------------------------------------------------------------------------------------------
+  static std::string injectDefines(const std::string &_source, const std::string &_defines);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the pieces of build for programs created outside ShaderLib (TessVariantTable and ProgramBatch link without waiting)
+  //----------------------------------------------------------------------------------------------------------------------
+  bool enabled() const { return m_enabled; }
+  uint64_t key(const std::vector<ShaderStageSource> &_stages, const std::string &_defines,
+              const std::vector<std::string> &_feedbackVaryings = {}) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief glProgramBinary the cached binary for _key into _program, false if there is none. The link status is
+  /// not checked so the caller decides when to wait for it
+  //----------------------------------------------------------------------------------------------------------------------
+  bool submitBinary(GLuint _program, uint64_t _key) const;
+  void saveBinary(GLuint _program, uint64_t _key) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief turn on KHR_parallel_shader_compile (or the ARB version) for the current context if it has it, after
+  /// which compiles and links run on the driver's threads and linkCompleted can be polled without waiting
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool enableParallelCompile();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief GL_COMPLETION_STATUS_KHR of _program, only meaningful after enableParallelCompile returned true
+  //----------------------------------------------------------------------------------------------------------------------
+  static bool linkCompleted(GLuint _program);
+
+private:
+  bool loadBinary(GLuint _program, uint64_t _key) const;
+  std::string fileName(uint64_t _key) const;
+  bool m_enabled = true;
+  std::string m_directory;
+};
+
+#endif
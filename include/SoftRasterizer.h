@@ -0,0 +1,188 @@
+#ifndef SOFTRASTERIZER_H_
+#define SOFTRASTERIZER_H_
+#include "CPUTessellator.h"
+#include "ThreadPool.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file SoftRasterizer.h
+/// @brief a CPU renderer for TessMesh output so images of the tessellated surfaces can be made (and diffed) on
+/// machines without a GPU. Like the rest of TessCore it has no GL / NGL dependency.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief 8 bit RGB pixels, rows top to bottom as they are stored in a PPM
+  //----------------------------------------------------------------------------------------------------------------------
+  struct RasterImage
+  {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgb;
+    void resize(int _width, int _height)
+    {
+      width = _width;
+      height = _height;
+      rgb.resize(static_cast<size_t>(_width) * _height * 3);
+    }
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief binary (P6) PPM, the format needs no library to read or write and every image viewer opens it
+  //----------------------------------------------------------------------------------------------------------------------
+  bool writePPM(const std::string &_fname, const RasterImage &_image);
+  bool readPPM(const std::string &_fname, RasterImage &o_image);
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how far apart two images are, per channel differences in 0..255
+  //----------------------------------------------------------------------------------------------------------------------
+  struct ImageDiff
+  {
+    bool sameSize = false;
+    int maxDifference = 0;
+    double meanDifference = 0.0;
+    /// @brief pixels with any channel more than the tolerance apart
+    size_t pixelsOver = 0;
+    double fractionOver = 0.0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief compare _a and _b, an edge moving by a pixel shows up in pixelsOver rather than failing everything
+  /// @param [in] _tolerance channel difference that still counts as the same
+  /// @param [out] o_diff when not null the per channel differences scaled up 4 times, for looking at
+  //----------------------------------------------------------------------------------------------------------------------
+  ImageDiff compareImages(const RasterImage &_a, const RasterImage &_b, int _tolerance, RasterImage *o_diff = nullptr);
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the uniforms tessfrag.glsl shades with, the defaults are the ones the "Tess" program is given
+  //----------------------------------------------------------------------------------------------------------------------
+  struct RasterShading
+  {
+    std::array<float, 3> ambient = {{0.1f, 0.1f, 0.1f}};
+    std::array<float, 3> diffuse = {{0.8f, 0.0f, 0.0f}};
+    std::array<float, 3> lightPosition = {{1.0f, 1.0f, 1.0f}};
+    /// @brief the glClearColor of NGLScene
+    std::array<float, 3> clearColour = {{0.4f, 0.4f, 0.4f}};
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @class SoftRasterizer
+  /// @brief draws a TessMesh the way the "Tess" program with the geometry shader does: flat facet lighting from
+  /// tessgeom.glsl and the amplify() edge lines of tessfrag.glsl over the triangle and patch barycentrics.
+  /// The frame is rendered in three passes over the ThreadPool:
+  ///  - transform every vertex to clip space,
+  ///  - set up each triangle (clipped against the near / far planes and a guard band, so the fixed point maths can't
+  ///    overflow) and bin it into every TileSize square tile its bounds touch, one set of bins per worker,
+  ///  - rasterise the tiles in parallel, each owning its pixels so no locking is needed. A tile's triangles are
+  ///    drawn in mesh order, which keeps depth ties and so the image the same whatever the thread count.
+  /// Coverage uses integer edge functions on 4 bit sub pixel positions with a top left style tie break, so
+  /// neighbouring triangles never leave gaps or touch a pixel twice, evaluated 4 pixels at a time with SSE2
+  /// together with the depth test. Shading is perspective correct. GL is multisampled and this is not, so compare
+  /// against GL images with a tolerance and expect the silhouette and edge lines to differ by a pixel.
+  //----------------------------------------------------------------------------------------------------------------------
+  class SoftRasterizer
+  {
+  public:
+    static constexpr int TileSize = 32;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief largest width or height, above this the guard band no longer keeps the edge functions in 32 bits
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr int MaxImageSize = 4096;
+    explicit SoftRasterizer(ThreadPool &_pool);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief render _mesh into io_image, which must already be sized (1..MaxImageSize each way)
+    /// @param [in] _mesh positions and indices, patchCoords when present give the patch edge lines
+    /// @param [in] _modelview,_projection column major matrices as in TessMath.h
+    /// @return false if the image size isn't supported
+    //----------------------------------------------------------------------------------------------------------------------
+    bool render(const TessMesh &_mesh, const float *_modelview, const float *_projection, const RasterShading &_shading,
+                RasterImage &io_image);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief where the time of the last render went
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Stats
+    {
+      double transformMS = 0.0;
+      double binMS = 0.0;
+      double rasterMS = 0.0;
+      /// @brief triangles left after clipping, split by the clipper and dropped when they cover no area
+      size_t triangles = 0;
+      /// @brief triangle / tile pairs, how much work the binning handed the raster pass
+      size_t binned = 0;
+      size_t tiles = 0;
+    };
+    const Stats &stats() const { return m_stats; }
+
+  private:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a triangle ready to rasterise, vertex 0..2 after clipping, wound so its area is positive
+    //----------------------------------------------------------------------------------------------------------------------
+    struct SetupTriangle
+    {
+      /// @brief mesh triangle * 8 + the clipper's output index, the order tiles draw in
+      uint64_t order = 0;
+      /// @brief sub pixel positions and the edge function coefficients, edge i is opposite vertex i
+      std::array<int32_t, 3> x;
+      std::array<int32_t, 3> y;
+      std::array<int32_t, 3> a;
+      std::array<int32_t, 3> b;
+      /// @brief 1 for edges that don't own the pixels exactly on them
+      std::array<int32_t, 3> bias;
+      int minX = 0;
+      int minY = 0;
+      int maxX = 0;
+      int maxY = 0;
+      double invArea = 0.0;
+      std::array<float, 3> depth;
+      std::array<float, 3> invW;
+      /// @brief the barycentrics of each vertex in the unclipped triangle (gTriDistance)
+      std::array<std::array<float, 3>, 3> triDistance;
+      /// @brief tePatchDistance at the unclipped triangle's corners
+      std::array<std::array<float, 3>, 3> patchDistance;
+      /// @brief ambient + diffuse lighting, it is flat across the facet
+      std::array<float, 3> colour;
+    };
+    struct ClipVertex
+    {
+      std::array<float, 4> clip;
+      std::array<float, 3> triDistance;
+    };
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief what one worker writes while binning
+    //----------------------------------------------------------------------------------------------------------------------
+    struct Bins
+    {
+      std::vector<SetupTriangle> triangles;
+      std::vector<std::vector<uint32_t>> tiles;
+      std::vector<const SetupTriangle *> scratch;
+      std::vector<ClipVertex> polygon;
+      std::vector<ClipVertex> clipped;
+    };
+    void setupTriangle(const TessMesh &_mesh, size_t _triangle, const RasterShading &_shading, Bins &io_bins);
+    void addTriangle(const ClipVertex &_v0, const ClipVertex &_v1, const ClipVertex &_v2, const SetupTriangle &_shared,
+                     Bins &io_bins);
+    void rasteriseTile(size_t _tile, const RasterShading &_shading, Bins &io_scratch, RasterImage &io_image);
+    void drawTriangle(const SetupTriangle &_t, int _x0, int _y0, int _x1, int _y1, RasterImage &io_image);
+
+    ThreadPool &m_pool;
+    Stats m_stats;
+    int m_width = 0;
+    int m_height = 0;
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    /// @brief the guard band in clip space, x / w and y / w are clipped to +-m_guard
+    float m_guardX = 1.0f;
+    float m_guardY = 1.0f;
+    std::array<float, 16> m_modelview;
+    /// @brief xyzw per vertex
+    std::vector<float> m_clip;
+    /// @brief depth buffer, rows padded to a multiple of 4 so the 4 wide loads stay inside
+    std::vector<float> m_depth;
+    int m_depthStride = 0;
+    std::vector<Bins> m_bins;
+  };
+} // end namespace tess
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef TERRAINSCENE_H_
+#define TERRAINSCENE_H_
+#include "TerrainTiles.h"
+#include <ngl/Types.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TerrainScene.h
+/// @brief a height mapped terrain drawn as quad patches displaced in terraineval.glsl, with its tiles streamed in
+/// around a camera flying over it
+/// @class TerrainScene
+/// @brief the heights live in a GL_TEXTURE_2D_ARRAY of PoolLayers tiles allocated once, so the GPU memory is the
+/// same however big the terrain on disk is. Every frame the tiles within ResidentRadius of the camera are asked of
+/// a TerrainTileLoader, nearest first, and up to UploadsPerFrame of the ones it has finished are copied into a
+/// free layer, or the layer of the tile least recently near the camera. The resident tiles are drawn with one
+/// instanced draw of a PatchesPerTile^2 grid of 4 vertex patches, terraincontrol.glsl sets each edge's level from
+/// its distance to the eye. Tiles that haven't arrived yet are left out rather than waited for.
+//----------------------------------------------------------------------------------------------------------------------
+class TerrainScene
+{
+public:
+  static constexpr int PoolLayers = 96;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the most GPU memory the pool may take, terrains whose tiles would need more are generated instead. At
+  /// 96 layers of 16 bit samples that is tiles of up to 1182 samples a side
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr size_t PoolBudgetBytes = 256 * 1024 * 1024;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief tiles either side of the camera's tile that are kept resident, (2 * 4 + 1)^2 = 81 fit in the pool
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr int ResidentRadius = 4;
+  static_assert((2 * ResidentRadius + 1) * (2 * ResidentRadius + 1) <= PoolLayers, "every wanted tile needs a layer");
+  static constexpr int UploadsPerFrame = 4;
+  static constexpr int PatchesPerTile = 8;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief world units the camera moves each frame, per frame rather than per second so replays see the same views
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr float FlightSpeed = 0.5f;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief stream _fname (a .tht written by TessMeshTool --terrain), or generate the tiles if it is empty, can't
+  /// be read, has tiles larger than GL_MAX_TEXTURE_SIZE or maxPoolSamples(), or its pool can't be allocated. Needs
+  /// a current context
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit TerrainScene(const std::string &_fname);
+  ~TerrainScene();
+  TerrainScene(const TerrainScene &) = delete;
+  TerrainScene &operator=(const TerrainScene &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief move the camera on, then update the resident tiles and upload the ones that have arrived
+  /// @param [in] _yaw _pitch degrees the view is turned from the direction of flight (the mouse rotation)
+  //----------------------------------------------------------------------------------------------------------------------
+  void update(float _yaw, float _pitch);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the view matrix and eye position for this frame, the terrain has no model transform
+  //----------------------------------------------------------------------------------------------------------------------
+  const float *view() const { return m_view; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief set this terrain's tile size, height scale and sample counts on the linked Terrain program, they don't
+  /// change so once is enough
+  //----------------------------------------------------------------------------------------------------------------------
+  void setProgramUniforms(GLuint _program) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief draw the resident tiles near the camera with the Terrain program given to setProgramUniforms active, the
+  /// blocks bound and GL_PATCH_VERTICES set to 4
+  //----------------------------------------------------------------------------------------------------------------------
+  void draw() const;
+  const tess::TerrainInfo &info() const { return m_loader.info(); }
+  bool procedural() const { return m_loader.procedural(); }
+  size_t residentTiles() const { return m_residentTiles; }
+  size_t drawnTiles() const { return m_drawTiles.size() / 3; }
+  size_t drawnPatches() const { return drawnTiles() * PatchesPerTile * PatchesPerTile; }
+  size_t queuedTiles() const { return m_loader.queued(); }
+  size_t tilesLoaded() const { return m_loader.tilesLoaded(); }
+  size_t tilesUploaded() const { return m_uploads; }
+  float averageLoadMS() const { return m_loader.averageLoadMS(); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief GPU memory for the tile pool and the patch grid
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t bytes() const { return m_bytes; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the largest tile side whose PoolLayers layers fit in PoolBudgetBytes
+  //----------------------------------------------------------------------------------------------------------------------
+  static uint32_t maxPoolSamples();
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief allocate every layer of m_heightTexture for the current terrain, false if GL couldn't
+  //----------------------------------------------------------------------------------------------------------------------
+  bool allocatePool();
+  void updateCamera(float _yaw, float _pitch);
+  void updateTiles();
+  void upload(const tess::TerrainTile &_tile, int _layer);
+  tess::TerrainTileLoader m_loader;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the tile in each layer of the pool (-1 for none) and the frame it was last wanted
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Layer
+  {
+    int64_t tile = -1;
+    uint64_t lastWanted = 0;
+  };
+  std::vector<Layer> m_layers;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the pool layer of every tile of the terrain, -1 if it isn't resident
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<int> m_tileLayer;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief tiles the loader has finished that haven't been uploaded yet
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<tess::TerrainTile> m_arrived;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief tile x, tile z, layer for every tile drawn this frame, the per instance attribute
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<float> m_drawTiles;
+  uint64_t m_frame = 0;
+  size_t m_residentTiles = 0;
+  size_t m_uploads = 0;
+  size_t m_bytes = 0;
+  float m_distance = 0.0f;
+  float m_eye[3] = {0.0f, 0.0f, 0.0f};
+  float m_view[16] = {};
+  GLuint m_heightTexture = 0;
+  GLuint m_vao = 0;
+  GLuint m_patchBuffer = 0;
+  GLuint m_tileBuffer = 0;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef TERRAINTILES_H_
+#define TERRAINTILES_H_
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TerrainTiles.h
+/// @brief the .tht height tile format and a background loader for it. The terrain is tilesX * tilesZ square tiles,
+/// each (resolution + 1)^2 uint16 heights so neighbouring tiles repeat their shared edge and every tile can be
+/// sampled on its own. A file is a TerrainFileHeader then the tiles row by row (z then x), each one contiguous, so a
+/// tile is one seek and one read. Everything is little endian.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  constexpr uint32_t TerrainFileVersion = 1;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the largest terrain a file may describe, the viewer keeps a layer index per tile and a tile is one layer
+  /// of a texture array
+  //----------------------------------------------------------------------------------------------------------------------
+  constexpr uint32_t MaxTerrainTilesPerSide = 1024;
+  constexpr uint32_t MaxTerrainResolution = 4096;
+
+  struct TerrainFileHeader
+  {
+    char magic[4] = {'T', 'H', 'T', 'F'};
+    uint32_t version = TerrainFileVersion;
+    /// @brief quads along a tile side, a tile has resolution + 1 samples a side
+    uint32_t resolution = 128;
+    uint32_t tilesX = 32;
+    uint32_t tilesZ = 32;
+    /// @brief world size of a tile side and of a height of 65535
+    float tileSize = 32.0f;
+    float heightScale = 24.0f;
+    uint32_t seed = 0;
+    uint64_t tilesOffset = sizeof(TerrainFileHeader);
+  };
+  static_assert(sizeof(TerrainFileHeader) == 40, "TerrainFileHeader is written as is");
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the layout of a terrain, from a file header or for a procedural one
+  //----------------------------------------------------------------------------------------------------------------------
+  struct TerrainInfo
+  {
+    uint32_t resolution = 128;
+    uint32_t tilesX = 32;
+    uint32_t tilesZ = 32;
+    float tileSize = 32.0f;
+    float heightScale = 24.0f;
+    uint32_t seed = 1234;
+    uint32_t samples() const { return resolution + 1; }
+    size_t tileBytes() const { return static_cast<size_t>(samples()) * samples() * sizeof(uint16_t); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the tile count of a valid() terrain also fits the uint32_t tile indices
+    //----------------------------------------------------------------------------------------------------------------------
+    uint64_t numTiles() const { return static_cast<uint64_t>(tilesX) * tilesZ; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the tile counts and resolution are within the limits above and both sizes are finite and positive
+    //----------------------------------------------------------------------------------------------------------------------
+    bool valid() const;
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief fractal value noise heights for tile (_x, _z), computed from the global sample position so the edges
+  /// shared with the neighbouring tiles come out identical
+  /// @param [out] o_heights samples()^2 heights, row by row
+  //----------------------------------------------------------------------------------------------------------------------
+  void generateTerrainTile(const TerrainInfo &_info, uint32_t _x, uint32_t _z, uint16_t *o_heights);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write a procedural terrain as a .tht file a tile at a time, so it never holds more than one tile
+  //----------------------------------------------------------------------------------------------------------------------
+  bool writeTerrainFile(const std::string &_fname, const TerrainInfo &_info);
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a tile's heights as the loader hands them back
+  //----------------------------------------------------------------------------------------------------------------------
+  struct TerrainTile
+  {
+    uint32_t index = 0;
+    std::vector<uint16_t> heights;
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @class TerrainTileLoader
+  /// @brief reads (or generates) tiles on a thread of its own. request() replaces the queue with the tiles wanted
+  /// now, nearest first, so tiles the camera has moved away from are never read; a tile already being read is
+  /// finished and not queued again. Finished tiles wait in a list until collect() takes them, the caller decides
+  /// what to keep.
+  //----------------------------------------------------------------------------------------------------------------------
+  class TerrainTileLoader
+  {
+  public:
+    TerrainTileLoader() = default;
+    ~TerrainTileLoader();
+    TerrainTileLoader(const TerrainTileLoader &) = delete;
+    TerrainTileLoader &operator=(const TerrainTileLoader &) = delete;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief check _fname's header and size then start the thread
+    /// @param [in] _maxSamples the most samples a tile side may have (the GL_MAX_TEXTURE_SIZE of the viewer), 0 for
+    /// no limit beyond MaxTerrainResolution
+    //----------------------------------------------------------------------------------------------------------------------
+    bool open(const std::string &_fname, uint32_t _maxSamples = 0);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief generate the tiles of _info on the thread instead of reading them
+    //----------------------------------------------------------------------------------------------------------------------
+    void openProcedural(const TerrainInfo &_info);
+    const TerrainInfo &info() const { return m_info; }
+    bool procedural() const { return m_procedural; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief load _tiles (indices z * tilesX + x) in this order, dropping whatever was still queued
+    //----------------------------------------------------------------------------------------------------------------------
+    void request(const std::vector<uint32_t> &_tiles);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief append the tiles finished since the last call to o_tiles, never waits for the thread
+    //----------------------------------------------------------------------------------------------------------------------
+    void collect(std::vector<TerrainTile> &o_tiles);
+    size_t queued() const;
+    size_t tilesLoaded() const;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief average time the thread took per tile
+    //----------------------------------------------------------------------------------------------------------------------
+    float averageLoadMS() const;
+
+  private:
+    void start();
+    void stop();
+    void loaderLoop();
+    bool load(uint32_t _index, TerrainTile &o_tile);
+    TerrainInfo m_info;
+    bool m_procedural = false;
+    std::string m_fname;
+    uint64_t m_tilesOffset = 0;
+    /// @brief only used by the loader thread
+    std::ifstream m_file;
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<uint32_t> m_queue;
+    static constexpr uint32_t NoTile = ~uint32_t(0);
+    uint32_t m_loading = NoTile;
+    std::vector<TerrainTile> m_done;
+    bool m_quit = false;
+    size_t m_loaded = 0;
+    double m_loadMS = 0.0;
+  };
+} // end namespace tess
+
+#endif
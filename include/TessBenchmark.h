@@ -0,0 +1,95 @@
+#ifndef TESSBENCHMARK_H_
+#define TESSBENCHMARK_H_
+#include "AppOptions.h"
+#include "PatchMesh.h"
+#include "UniformRing.h"
+#include <ngl/AbstractVAO.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+class QOffscreenSurface;
+class QOpenGLContext;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TessBenchmark.h
+/// @brief headless benchmark for the Tess program, renders into an offscreen FBO at every inner / outer level
+/// combination and records the GPU time and primitive count of the patch draw. With --bench-encodings the sweep is
+/// repeated for the plain float / 32 bit index mesh and each compact encoding of it
+/// @class TessBenchmark
+/// @brief used by --bench instead of opening an NGLScene window, works with software GL (Mesa llvmpipe)
+//----------------------------------------------------------------------------------------------------------------------
+class TessBenchmark
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ctor
+  /// @param [in] _options the --bench* command line options
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit TessBenchmark(const AppOptions &_options);
+  ~TessBenchmark();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief run all the levels and write the results, returns the process exit code
+  //----------------------------------------------------------------------------------------------------------------------
+  int run();
+
+private:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the measurements for one level combination
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Result
+  {
+    /// @brief index into m_encodings
+    size_t encoding = 0;
+    int inner = 1;
+    int outer = 1;
+    double meanMS = 0.0;
+    double minMS = 0.0;
+    uint64_t primitives = 0;
+    uint64_t expectedPrimitives = 0;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a control mesh the levels were swept with
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Encoding
+  {
+    tess::PatchMeshSettings settings;
+    tess::IndexFormat indexFormat = tess::IndexFormat::UInt32;
+    size_t patches = 0;
+    size_t bytes = 0;
+    double acmr = 0.0;
+    float maxError = 0.0f;
+  };
+  bool createContext();
+  void createFramebuffer();
+  void deleteFramebuffer();
+  void loadMatricesToShader(float _inner, float _outer);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief build, upload and record the control mesh for the next sweep
+  //----------------------------------------------------------------------------------------------------------------------
+  void createPatchMesh(const tess::PatchMeshSettings &_settings);
+  Result measure(int _inner, int _outer);
+  bool writeCSV(const std::string &_fname) const;
+  bool writeJSON(const std::string &_fname) const;
+
+  AppOptions m_options;
+  std::unique_ptr<QOffscreenSurface> m_surface;
+  std::unique_ptr<QOpenGLContext> m_context;
+  std::unique_ptr<ngl::AbstractVAO> m_vao;
+  std::unique_ptr<UniformRing> m_uniforms;
+  GLuint m_fbo = 0;
+  GLuint m_colourBuffer = 0;
+  GLuint m_depthBuffer = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief one GL_TIME_ELAPSED and one GL_PRIMITIVES_GENERATED query per measured frame
+  //----------------------------------------------------------------------------------------------------------------------
+  std::vector<GLuint> m_timeQueries;
+  std::vector<GLuint> m_primitiveQueries;
+  std::string m_renderer;
+  std::vector<Result> m_results;
+  std::vector<Encoding> m_encodings;
+  tess::TrianglePatchMesh m_patchMesh;
+  tess::EncodedPatchMesh m_encodedMesh;
+};
+
+#endif
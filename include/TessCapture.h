@@ -0,0 +1,64 @@
+#ifndef TESSCAPTURE_H_
+#define TESSCAPTURE_H_
+#include <ngl/AbstractVAO.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TessCapture.h
+/// @brief records what the tessellator generates so it can be reused without running the tessellator again
+//----------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the outcome of one capture
+//----------------------------------------------------------------------------------------------------------------------
+struct CaptureResult
+{
+  uint64_t primitives = 0;
+  uint64_t expected = 0;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the tessellator generated more triangles than the buffer holds, only the first ones were written
+  //----------------------------------------------------------------------------------------------------------------------
+  bool overflow = false;
+  bool written = false;
+  double ms = 0.0;
+  bool valid() const { return written && !overflow && primitives == expected; }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class TessCapture
+/// @brief draws the patches once with the "TessCapture" program and GL_RASTERIZER_DISCARD, tePosition of every
+/// generated triangle goes to a transform feedback buffer. That buffer is then mapped and streamed to disk in
+/// chunks straight from the mapping. A .ply name gives a binary little endian PLY (one vertex per triangle
+/// corner, faces 0 1 2, 3 4 5 ...), anything else raw xyz floats, 9 per triangle.
+//----------------------------------------------------------------------------------------------------------------------
+class TessCapture
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief needs a current context
+  /// @param [in] _maxTriangles the most triangles one capture can hold
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit TessCapture(size_t _maxTriangles);
+  ~TessCapture();
+  TessCapture(const TessCapture &) = delete;
+  TessCapture &operator=(const TessCapture &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief capture one draw of _vao and write it to _fname, the "TessCapture" program must be active with its
+  /// uniform blocks bound
+  /// @param [in] _expected the triangle count the CPU model predicts for the current levels
+  //----------------------------------------------------------------------------------------------------------------------
+  CaptureResult capture(ngl::AbstractVAO &_vao, size_t _expected, const std::string &_fname);
+
+private:
+  bool write(const std::string &_fname, size_t _triangles) const;
+  static constexpr size_t ChunkBytes = 1 << 20;
+  static constexpr size_t BytesPerTriangle = 9 * sizeof(float);
+  size_t m_maxTriangles = 0;
+  GLuint m_buffer = 0;
+  GLuint m_generatedQuery = 0;
+  GLuint m_writtenQuery = 0;
+};
+
+#endif
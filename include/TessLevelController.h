@@ -0,0 +1,70 @@
+#ifndef TESSLEVELCONTROLLER_H_
+#define TESSLEVELCONTROLLER_H_
+#include "CPUTessellator.h"
+#include <cstddef>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TessLevelController.h
+/// @brief picks a uniform tessellation level that keeps the GPU frame time inside a budget
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief tuning for TessLevelController
+  //----------------------------------------------------------------------------------------------------------------------
+  struct LevelControllerParams
+  {
+    /// @brief the GPU frame time we aim for
+    float budgetMS = 8.0f;
+    /// @brief nothing changes while the average is within budget * (1 +/- hysteresis)
+    float hysteresis = 0.15f;
+    /// @brief frame times averaged before each decision
+    size_t window = 8;
+    /// @brief frame times ignored after a change, the GPU results lag the frame they were measured in
+    size_t settleFrames = 4;
+    /// @brief the most the level may grow in one step as a fraction of the current level (shrinking is unlimited)
+    float maxGrowth = 0.25f;
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @class TessLevelController
+  /// @brief fed one GPU frame time per frame. When the windowed average leaves the hysteresis band the level is
+  /// scaled by sqrt(budget / average), as the triangle count and so most of the cost grows with level squared.
+  /// Going down is immediate so an overloaded frame recovers quickly, going up is limited to maxGrowth per step so
+  /// the level creeps back towards the budget instead of overshooting it.
+  //----------------------------------------------------------------------------------------------------------------------
+  class TessLevelController
+  {
+  public:
+    explicit TessLevelController(const LevelControllerParams &_params = LevelControllerParams());
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief add the GPU time of a frame drawn at level()
+    /// @returns true if the level changed
+    //----------------------------------------------------------------------------------------------------------------------
+    bool update(float _gpuMS);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the level to draw with, always an integer in [1,MaxTessLevel]
+    //----------------------------------------------------------------------------------------------------------------------
+    float level() const { return m_level; }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start from _level (e.g. what the user had selected) and forget the samples taken so far
+    //----------------------------------------------------------------------------------------------------------------------
+    void setLevel(float _level);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the average of the last full window, 0 until one has filled
+    //----------------------------------------------------------------------------------------------------------------------
+    float averageMS() const { return m_averageMS; }
+    const LevelControllerParams &params() const { return m_params; }
+    void setBudget(float _ms) { m_params.budgetMS = _ms; }
+
+  private:
+    LevelControllerParams m_params;
+    float m_level = 1.0f;
+    float m_averageMS = 0.0f;
+    std::vector<float> m_samples;
+    size_t m_skip = 0;
+  };
+} // end namespace tess
+
+#endif
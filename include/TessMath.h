@@ -0,0 +1,109 @@
+#ifndef TESSMATH_H_
+#define TESSMATH_H_
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TessMath.h
+/// @brief the few matrix helpers TessCore needs. Matrices are 16 floats in the column major OpenGL layout so an
+/// ngl::Mat4 can be passed straight in as m_openGL.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief o_r = _m * vec4(_p, 1)
+  //----------------------------------------------------------------------------------------------------------------------
+  inline void transformPoint(const float *_m, const float *_p, float *o_r)
+  {
+    for (int r = 0; r < 4; ++r)
+    {
+      o_r[r] = _m[r] * _p[0] + _m[4 + r] * _p[1] + _m[8 + r] * _p[2] + _m[12 + r];
+    }
+  }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief o_r = _a * _b
+  //----------------------------------------------------------------------------------------------------------------------
+  inline void multiply(const float *_a, const float *_b, float *o_r)
+  {
+    for (int c = 0; c < 4; ++c)
+    {
+      for (int r = 0; r < 4; ++r)
+      {
+        o_r[c * 4 + r] = _a[r] * _b[c * 4] + _a[4 + r] * _b[c * 4 + 1] + _a[8 + r] * _b[c * 4 + 2] + _a[12 + r] * _b[c * 4 + 3];
+      }
+    }
+  }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the view matrix ngl::lookAt builds, for code that can't use NGL
+  //----------------------------------------------------------------------------------------------------------------------
+  inline void lookAt(const float *_eye, const float *_centre, const float *_up, float *o_m)
+  {
+    auto normalize = [](float *io_v)
+    {
+      const float len = std::sqrt(io_v[0] * io_v[0] + io_v[1] * io_v[1] + io_v[2] * io_v[2]);
+      io_v[0] /= len;
+      io_v[1] /= len;
+      io_v[2] /= len;
+    };
+    float f[3] = {_centre[0] - _eye[0], _centre[1] - _eye[1], _centre[2] - _eye[2]};
+    normalize(f);
+    float s[3] = {f[1] * _up[2] - f[2] * _up[1], f[2] * _up[0] - f[0] * _up[2], f[0] * _up[1] - f[1] * _up[0]};
+    normalize(s);
+    const float u[3] = {s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0]};
+    for (int c = 0; c < 3; ++c)
+    {
+      o_m[c * 4 + 0] = s[c];
+      o_m[c * 4 + 1] = u[c];
+      o_m[c * 4 + 2] = -f[c];
+      o_m[c * 4 + 3] = 0.0f;
+    }
+    o_m[12] = -(s[0] * _eye[0] + s[1] * _eye[1] + s[2] * _eye[2]);
+    o_m[13] = -(u[0] * _eye[0] + u[1] * _eye[1] + u[2] * _eye[2]);
+    o_m[14] = f[0] * _eye[0] + f[1] * _eye[1] + f[2] * _eye[2];
+    o_m[15] = 1.0f;
+  }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the projection ngl::perspective builds, _fovY in degrees and z mapped to [-1,1]
+  //----------------------------------------------------------------------------------------------------------------------
+  inline void perspective(float _fovY, float _aspect, float _near, float _far, float *o_m)
+  {
+    const float t = std::tan(_fovY * 3.14159265358979f / 360.0f);
+    for (int i = 0; i < 16; ++i)
+    {
+      o_m[i] = 0.0f;
+    }
+    o_m[0] = 1.0f / (_aspect * t);
+    o_m[5] = 1.0f / t;
+    o_m[10] = -(_far + _near) / (_far - _near);
+    o_m[11] = -1.0f;
+    o_m[14] = -(2.0f * _far * _near) / (_far - _near);
+  }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a rotation of _degrees about the x (_axis 0) or y (_axis 1) axis, as ngl::Mat4::rotateX / rotateY
+  //----------------------------------------------------------------------------------------------------------------------
+  inline void rotation(int _axis, float _degrees, float *o_m)
+  {
+    const float r = _degrees * 3.14159265358979f / 180.0f;
+    const float c = std::cos(r);
+    const float s = std::sin(r);
+    for (int i = 0; i < 16; ++i)
+    {
+      o_m[i] = i % 5 == 0 ? 1.0f : 0.0f;
+    }
+    if (_axis == 0)
+    {
+      o_m[5] = c;
+      o_m[6] = s;
+      o_m[9] = -s;
+      o_m[10] = c;
+    }
+    else
+    {
+      o_m[0] = c;
+      o_m[2] = -s;
+      o_m[8] = s;
+      o_m[10] = c;
+    }
+  }
+} // end namespace tess
+
+#endif
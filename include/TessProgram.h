@@ -0,0 +1,100 @@
+#ifndef TESSPROGRAM_H_
+#define TESSPROGRAM_H_
+#include "BezierPatch.h"
+#include "PatchMesh.h"
+#include "ProgramCache.h"
+#include <ngl/AbstractVAO.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TessProgram.h
+/// @brief builds the shader programs and patch mesh for the tessellated sphere so the window and the benchmark
+/// set them up the same way
+//----------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the two ways of getting the wireframe look on the tessellated sphere
+//----------------------------------------------------------------------------------------------------------------------
+enum class TessPipeline : int
+{
+  /// @brief tessgeom.glsl builds the facet normal and triangle distance per primitive
+  GeometryShader = 0,
+  /// @brief no geometry stage, the fragment shader uses derivatives and the patch coordinates instead
+  NoGeometryShader = 1
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the ShaderLib program name used for each pipeline
+//----------------------------------------------------------------------------------------------------------------------
+const char *tessProgramName(TessPipeline _pipeline);
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief create the program for _pipeline (from _cache if possible) and set the material uniforms, the program is
+/// left active. _positions must match the mesh it draws, tessvert.glsl is built to decode that format.
+/// tessProgramRequest is the same program for a ProgramBatch, as are the other *ProgramRequest functions
+//----------------------------------------------------------------------------------------------------------------------
+ProgramBuildInfo createTessProgram(TessPipeline _pipeline, ProgramCache &_cache,
+                                   tess::PositionFormat _positions = tess::PositionFormat::Float32);
+ProgramRequest tessProgramRequest(TessPipeline _pipeline, tess::PositionFormat _positions = tess::PositionFormat::Float32);
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the pieces of the "Tess" programs, TessVariantTable builds its permutations from the same ones
+/// @param [in] _program prefix for the stage names
+//----------------------------------------------------------------------------------------------------------------------
+std::vector<ShaderStageSource> tessProgramStages(TessPipeline _pipeline, const std::string &_program);
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the uniform blocks plus the define that picks the tessvert.glsl input format
+//----------------------------------------------------------------------------------------------------------------------
+std::string tessProgramDefines(tess::PositionFormat _positions);
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief block bindings, material and PatchHints sampler of a linked "Tess" program
+//----------------------------------------------------------------------------------------------------------------------
+void setTessProgramUniforms(GLuint _program);
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the program for the pre tessellated GeodesicLOD mesh, the same geometry / fragment stages as "Tess"
+/// behind a plain vertex shader
+//----------------------------------------------------------------------------------------------------------------------
+ProgramRequest lodProgramRequest();
+constexpr auto LODProgramName = "TessLOD";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief bicubic Bezier patches (beziercontrol.glsl / beziereval.glsl) drawn with the "Tess" vertex, geometry and
+/// fragment stages
+//----------------------------------------------------------------------------------------------------------------------
+ProgramRequest bezierProgramRequest();
+constexpr auto BezierProgramName = "Bezier";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the "Tess" vertex / control / evaluation stages with tePosition captured by transform feedback, there is
+/// no fragment stage so it must be drawn with GL_RASTERIZER_DISCARD
+//----------------------------------------------------------------------------------------------------------------------
+ProgramRequest captureProgramRequest(tess::PositionFormat _positions = tess::PositionFormat::Float32);
+constexpr auto CaptureProgramName = "TessCapture";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the InstancedScene programs (GL 4.3): instvert / instcontrol / insteval in front of the usual geometry and
+/// fragment stages, and the instcull.glsl compute pass that writes the indirect draw commands
+//----------------------------------------------------------------------------------------------------------------------
+ProgramRequest instancedProgramRequest();
+constexpr auto InstancedProgramName = "TessInstanced";
+ProgramRequest instanceCullProgramRequest();
+constexpr auto InstanceCullProgramName = "InstanceCull";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the TerrainScene quad patches: terrainvert / terraincontrol / terraineval in front of the usual geometry
+/// and fragment stages
+//----------------------------------------------------------------------------------------------------------------------
+ProgramRequest terrainProgramRequest();
+constexpr auto TerrainProgramName = "Terrain";
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief attach the FrameBlock / ObjectBlock of _program to the bindings in TessUniforms.h
+//----------------------------------------------------------------------------------------------------------------------
+void bindTessUniformBlocks(const std::string &_program);
+void bindTessUniformBlocks(GLuint _program);
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief an encoded sphere control mesh as 3 vertex GL_PATCHES, positions are attribute 0 in the layout
+/// tessvert.glsl expects for _mesh.positionFormat and the indices keep their 8, 16 or 32 bit size
+//----------------------------------------------------------------------------------------------------------------------
+std::unique_ptr<ngl::AbstractVAO> createPatchMeshVAO(const tess::EncodedPatchMesh &_mesh);
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the control cage of _patches as 16 vertex GL_PATCHES, set GL_PATCH_VERTICES to 16 before drawing it
+//----------------------------------------------------------------------------------------------------------------------
+std::unique_ptr<ngl::AbstractVAO> createBezierVAO(const tess::BezierPatchMesh &_patches);
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef TESSTRACE_H_
+#define TESSTRACE_H_
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TessTrace.h
+/// @brief scoped CPU trace zones written as a Chrome trace event JSON file (chrome://tracing or ui.perfetto.dev).
+/// The TESS_TRACE_ macros are compiled out unless TESS_ENABLE_TRACE is defined (the CMake option of the same name),
+/// when compiled in a zone costs one relaxed atomic load until Trace::start() is called.
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @class Trace
+  /// @brief every thread that records gets its own fixed size event buffer the first time it does, so recording
+  /// takes no lock: the owning thread fills the next event then publishes it with a release store of the count,
+  /// and write() only reads events below the count. A full buffer drops events (counted) rather than growing.
+  /// Tracks that aren't a CPU thread, like GpuTrace's GPU timeline, are buffers of their own written by one thread.
+  /// Zone names must outlive the trace, in practice they are string literals.
+  //----------------------------------------------------------------------------------------------------------------------
+  class Trace
+  {
+  public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief events per thread, 40 bytes each
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr size_t DefaultCapacity = 1 << 17;
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief true when the TESS_TRACE_ macros are built in
+    //----------------------------------------------------------------------------------------------------------------------
+    static constexpr bool compiledIn()
+    {
+#ifdef TESS_ENABLE_TRACE
+      return true;
+#else
+      return false;
+#endif
+    }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start recording, buffers are made as threads first record into them
+    //----------------------------------------------------------------------------------------------------------------------
+    static void start(size_t _capacity = DefaultCapacity);
+    static void stop();
+    static bool active();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief ns since the process started on the steady clock, the time base of every event
+    //----------------------------------------------------------------------------------------------------------------------
+    static uint64_t now();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief name the calling thread's track, can be called before start()
+    //----------------------------------------------------------------------------------------------------------------------
+    static void setThreadName(const std::string &_name);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief the frame number events are tagged with, bumped by the thread that draws
+    //----------------------------------------------------------------------------------------------------------------------
+    static void nextFrame();
+    static uint32_t frame();
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a finished zone on the calling thread's track
+    //----------------------------------------------------------------------------------------------------------------------
+    static void record(const char *_name, uint64_t _startNS, uint64_t _endNS);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a track of its own, e.g. the GPU timeline, only one thread may record into it
+    /// @return the track id for recordOnTrack
+    //----------------------------------------------------------------------------------------------------------------------
+    static uint32_t createTrack(const char *_name);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief a zone on _track, with a flow arrow from the point _fromNS on the calling thread's track
+    /// @param [in] _frame the frame the zone belongs to, it may arrive a few frames late
+    //----------------------------------------------------------------------------------------------------------------------
+    static void recordOnTrack(uint32_t _track, const char *_name, uint64_t _startNS, uint64_t _endNS, uint32_t _frame,
+                              uint64_t _fromNS);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief write everything recorded so far, safe while other threads record
+    //----------------------------------------------------------------------------------------------------------------------
+    static bool write(const std::string &_fname);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief events recorded and dropped over all tracks
+    //----------------------------------------------------------------------------------------------------------------------
+    static size_t events();
+    static size_t dropped();
+  };
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief records the scope it is declared in, use TESS_TRACE_ZONE rather than declaring one
+  //----------------------------------------------------------------------------------------------------------------------
+  class TraceZone
+  {
+  public:
+    explicit TraceZone(const char *_name) : m_name(_name), m_active(Trace::active()), m_start(m_active ? Trace::now() : 0) {}
+    ~TraceZone()
+    {
+      if (m_active)
+      {
+        Trace::record(m_name, m_start, Trace::now());
+      }
+    }
+    TraceZone(const TraceZone &) = delete;
+    TraceZone &operator=(const TraceZone &) = delete;
+
+  private:
+    const char *m_name;
+    bool m_active;
+    uint64_t m_start;
+  };
+} // end namespace tess
+
+#define TESS_TRACE_CONCAT_(_a, _b) _a##_b
+#define TESS_TRACE_CONCAT(_a, _b) TESS_TRACE_CONCAT_(_a, _b)
+#ifdef TESS_ENABLE_TRACE
+#define TESS_TRACE_ZONE(_name) tess::TraceZone TESS_TRACE_CONCAT(tessTraceZone, __LINE__)(_name)
+#define TESS_TRACE_THREAD(_name) tess::Trace::setThreadName(_name)
+#else
+#define TESS_TRACE_ZONE(_name) static_cast<void>(0)
+#define TESS_TRACE_THREAD(_name) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef TESSUNIFORMS_H_
+#define TESSUNIFORMS_H_
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TessUniforms.h
+/// @brief CPU side copies of the std140 blocks declared in shaders/tessblocks.glsl, they are written straight into
+/// a UniformRing so the member order and padding must follow the std140 rules
+//----------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief binding points the Tess programs' blocks are attached to
+//----------------------------------------------------------------------------------------------------------------------
+constexpr unsigned int FrameBlockBinding = 0;
+constexpr unsigned int ObjectBlockBinding = 1;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief texture unit of the PatchHints buffer texture read by tesscontrol.glsl, unit 0 is the HUD's font atlas
+//----------------------------------------------------------------------------------------------------------------------
+constexpr int PatchHintsTextureUnit = 1;
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief texture unit of the terrain's height tile array read by terraineval.glsl
+//----------------------------------------------------------------------------------------------------------------------
+constexpr int TerrainHeightTextureUnit = 2;
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief "FrameBlock", values that are the same for everything drawn in a frame
+//----------------------------------------------------------------------------------------------------------------------
+struct FrameUniforms
+{
+  float tessLevelInner = 1.0f;
+  float tessLevelOuter = 1.0f;
+  float projectionScale = 1.0f;
+  float targetEdgePixels = 20.0f;
+  int32_t adaptive = 0;
+  int32_t cullPatches = 0;
+  int32_t usePatchHints = 0;
+  // std140 rounds the block size up to a vec4
+  float padding[1] = {0.0f};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief "ObjectBlock", one per draw. Matrices are column major, a std140 mat3 is 3 columns padded to vec4
+//----------------------------------------------------------------------------------------------------------------------
+struct ObjectUniforms
+{
+  float MVP[16];
+  float modelview[16];
+  float normalMatrix[12];
+  float eyePosition[3];
+  /// @brief PositionFormat::Snorm16 meshes are decoded with this, see tess::EncodedPatchMesh
+  float positionScale = 1.0f;
+};
+
+static_assert(sizeof(FrameUniforms) == 32, "FrameUniforms must match FrameBlock");
+static_assert(offsetof(ObjectUniforms, modelview) == 64 && offsetof(ObjectUniforms, normalMatrix) == 128 &&
+                  offsetof(ObjectUniforms, eyePosition) == 176 &&
+                  offsetof(ObjectUniforms, positionScale) == 188 && sizeof(ObjectUniforms) == 192,
+              "ObjectUniforms must match ObjectBlock");
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief fill in an ObjectBlock from the modelview and MVP. Everything in the demo only rotates and translates
+/// so the normal matrix is the upper 3x3 of the modelview and the object space eye is -R^T t, no inverse needed.
+//----------------------------------------------------------------------------------------------------------------------
+inline void setObjectUniforms(const float *_modelview, const float *_MVP, ObjectUniforms &o_object)
+{
+  for (int i = 0; i < 16; ++i)
+  {
+    o_object.MVP[i] = _MVP[i];
+    o_object.modelview[i] = _modelview[i];
+  }
+  const float *t = &_modelview[12];
+  for (int c = 0; c < 3; ++c)
+  {
+    for (int r = 0; r < 3; ++r)
+    {
+      o_object.normalMatrix[c * 4 + r] = _modelview[c * 4 + r];
+    }
+    o_object.normalMatrix[c * 4 + 3] = 0.0f;
+    // column c of R is row c of R^T
+    o_object.eyePosition[c] = -(_modelview[c * 4 + 0] * t[0] + _modelview[c * 4 + 1] * t[1] + _modelview[c * 4 + 2] * t[2]);
+  }
+}
+
+#endif
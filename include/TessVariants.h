@@ -0,0 +1,142 @@
+#ifndef TESSVARIANTS_H_
+#define TESSVARIANTS_H_
+#include "TessProgram.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file TessVariants.h
+/// @brief permutations of the "Tess" program picked by defines injected into tesseval.glsl / tessevalnogeom.glsl
+//----------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the tessellator's vertex spacing, the fractional modes morph smoothly between levels instead of popping
+//----------------------------------------------------------------------------------------------------------------------
+enum class TessSpacing : int
+{
+  Equal = 0,
+  FractionalOdd = 1,
+  FractionalEven = 2
+};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the order the generated triangles are wound in
+//----------------------------------------------------------------------------------------------------------------------
+enum class TessWinding : int
+{
+  CW = 0,
+  CCW = 1
+};
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief triangles, or point_mode which emits each generated vertex once. Points have no geometry stage variant
+//----------------------------------------------------------------------------------------------------------------------
+enum class TessPrimitive : int
+{
+  Triangles = 0,
+  Points = 1
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief one permutation, the default values are the "Tess" / "TessNoGeom" programs built at start up
+//----------------------------------------------------------------------------------------------------------------------
+struct TessVariant
+{
+  TessPipeline pipeline = TessPipeline::GeometryShader;
+  TessSpacing spacing = TessSpacing::Equal;
+  TessWinding winding = TessWinding::CW;
+  TessPrimitive primitive = TessPrimitive::Triangles;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief tessgeom.glsl takes triangles so point mode always uses the pipeline without a geometry stage
+  //----------------------------------------------------------------------------------------------------------------------
+  TessVariant normalized() const;
+  bool isDefault() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the table key, every field packed into a byte each
+  //----------------------------------------------------------------------------------------------------------------------
+  uint32_t key() const;
+  std::string defines() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief e.g. "fractional_odd_spacing ccw triangles"
+  //----------------------------------------------------------------------------------------------------------------------
+  std::string name() const;
+};
+
+const char *tessSpacingName(TessSpacing _spacing);
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class TessVariantTable
+/// @brief builds each non default TessVariant once the first time it is asked for and keeps it keyed by
+/// TessVariant::key. Builds never block the frame that asks: the program is compiled and linked (or loaded from the
+/// ProgramCache binary) and only queried for its status once GL_COMPLETION_STATUS_KHR says it is done when
+/// KHR_parallel_shader_compile is there (the driver then compiles on its own threads), or PollFrames frames
+/// later when it isn't. Until then program() returns 0 and the caller keeps drawing with what it had.
+/// The programs are plain GL objects, not ShaderLib ones, because ShaderLib checks every compile as it goes.
+//----------------------------------------------------------------------------------------------------------------------
+class TessVariantTable
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief frames to wait before checking a link without KHR_parallel_shader_compile
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr int PollFrames = 2;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief needs a current context
+  /// @param [in] _programCache load / store the variants in the on disk binary cache
+  /// @param [in] _positions the control point format the variants' vertex shader decodes
+  //----------------------------------------------------------------------------------------------------------------------
+  TessVariantTable(bool _programCache, tess::PositionFormat _positions);
+  ~TessVariantTable();
+  TessVariantTable(const TessVariantTable &) = delete;
+  TessVariantTable &operator=(const TessVariantTable &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the linked program for _variant or 0 if it is still building (or failed), the first call starts the build
+  //----------------------------------------------------------------------------------------------------------------------
+  GLuint program(const TessVariant &_variant);
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief finish any builds the driver is done with, call once a frame
+  //----------------------------------------------------------------------------------------------------------------------
+  void poll();
+  bool parallelCompile() const { return m_parallelCompile; }
+  bool failed(const TessVariant &_variant) const;
+  size_t size() const { return m_entries.size(); }
+  size_t pending() const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief ms from the request to a usable program for the last variant that finished
+  //----------------------------------------------------------------------------------------------------------------------
+  double lastBuildMS() const { return m_lastBuildMS; }
+
+private:
+  enum class State
+  {
+    Building,
+    Ready,
+    Failed
+  };
+  struct Entry
+  {
+    TessVariant variant;
+    GLuint program = 0;
+    std::vector<GLuint> shaders;
+    State state = State::Building;
+    bool cacheHit = false;
+    uint64_t cacheKey = 0;
+    int frames = 0;
+    std::chrono::steady_clock::time_point start;
+  };
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief attach, compile and link from source without checking anything
+  //----------------------------------------------------------------------------------------------------------------------
+  void submitCompile(const std::vector<ShaderStageSource> &_stages, const std::string &_defines, Entry &io_entry) const;
+  bool finished(const Entry &_entry) const;
+  void finish(Entry &io_entry);
+
+  ProgramCache m_cache;
+  tess::PositionFormat m_positions;
+  bool m_parallelCompile = false;
+  std::map<uint32_t, Entry> m_entries;
+  double m_lastBuildMS = 0.0;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ThreadPool.h
+/// @brief a small work stealing pool for the CPU tessellation code
+//----------------------------------------------------------------------------------------------------------------------
+namespace tess
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @class ThreadPool
+  /// @brief every worker has its own deque of tasks. A worker takes from the back of its own deque and when that
+  /// is empty steals from the front of the others, so uneven tasks (e.g. patches with very different levels) still
+  /// keep every core busy. parallelFor is meant to be called from one thread at a time and not from inside a task.
+  //----------------------------------------------------------------------------------------------------------------------
+  class ThreadPool
+  {
+  public:
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief start _threads workers, 0 means one per hardware thread
+    //----------------------------------------------------------------------------------------------------------------------
+    explicit ThreadPool(size_t _threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    size_t size() const { return m_threads.size(); }
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief run _func over [0,_count) in chunks of _grain and wait for all of them
+    /// @param [in] _func called as _func(begin, end, worker) where worker is in [0,size()) and no two calls with the
+    /// same worker run at once, so it can index per thread storage
+    //----------------------------------------------------------------------------------------------------------------------
+    void parallelFor(size_t _count, size_t _grain, const std::function<void(size_t, size_t, size_t)> &_func);
+    //----------------------------------------------------------------------------------------------------------------------
+    /// @brief how many tasks were taken from another worker's deque so far
+    //----------------------------------------------------------------------------------------------------------------------
+    size_t steals() const { return m_steals; }
+
+  private:
+    using Task = std::function<void(size_t)>;
+    struct Queue
+    {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+    };
+    void workerLoop(size_t _index);
+    bool popTask(size_t _index, Task &o_task);
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    /// @brief tasks sitting in a deque
+    std::atomic<size_t> m_queued{0};
+    /// @brief tasks queued or running
+    std::atomic<size_t> m_pending{0};
+    std::atomic<size_t> m_steals{0};
+    bool m_stop = false;
+  };
+} // end namespace tess
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef UNIFORMRING_H_
+#define UNIFORMRING_H_
+#include <ngl/Types.h>
+#include <array>
+#include <cstddef>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file UniformRing.h
+/// @brief per frame uniform block data
+/// @class UniformRing
+/// @brief one GL_UNIFORM_BUFFER split into Frames regions. Each frame writes its blocks into the next region and
+/// binds them with glBindBufferRange, a fence placed at the end of the frame tells us when the GPU has finished
+/// reading a region so it is only waited on when the CPU gets Frames frames ahead.
+/// With GL 4.4 the buffer is created with glBufferStorage and stays persistently mapped (coherent) so a write is
+/// just a memcpy, older contexts (macOS 4.1) fall back to glBufferSubData into the same regions.
+//----------------------------------------------------------------------------------------------------------------------
+class UniformRing
+{
+public:
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief frames in flight, one region each
+  //----------------------------------------------------------------------------------------------------------------------
+  static constexpr size_t Frames = 3;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief create and map the buffer, needs a current context
+  /// @param [in] _frameBytes the most one frame will write, including alignment padding between blocks
+  //----------------------------------------------------------------------------------------------------------------------
+  explicit UniformRing(size_t _frameBytes);
+  ~UniformRing();
+  UniformRing(const UniformRing &) = delete;
+  UniformRing &operator=(const UniformRing &) = delete;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief move to the next region, waiting for the GPU only if it is still reading it
+  //----------------------------------------------------------------------------------------------------------------------
+  void beginFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief fence the region used this frame, call after the last draw that reads it
+  //----------------------------------------------------------------------------------------------------------------------
+  void endFrame();
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief copy a block into the current region
+  /// @returns the offset of the block in the buffer, aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+  //----------------------------------------------------------------------------------------------------------------------
+  GLintptr write(const void *_data, size_t _size);
+  template <typename T>
+  GLintptr write(const T &_block) { return write(&_block, sizeof(T)); }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief attach a written block to a binding point
+  //----------------------------------------------------------------------------------------------------------------------
+  void bind(GLuint _binding, GLintptr _offset, size_t _size) const;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief write _block and bind it to _binding
+  //----------------------------------------------------------------------------------------------------------------------
+  template <typename T>
+  void writeAndBind(GLuint _binding, const T &_block) { bind(_binding, write(_block), sizeof(T)); }
+  bool persistent() const { return m_mapped != nullptr; }
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how many times beginFrame had to wait for the GPU
+  //----------------------------------------------------------------------------------------------------------------------
+  size_t stalls() const { return m_stalls; }
+
+private:
+  GLuint m_buffer = 0;
+  char *m_mapped = nullptr;
+  size_t m_alignment = 256;
+  size_t m_regionBytes = 0;
+  size_t m_region = 0;
+  size_t m_cursor = 0;
+  size_t m_stalls = 0;
+  bool m_overflowReported = false;
+  std::array<GLsync, Frames> m_fences = {};
+};
+
+#endif
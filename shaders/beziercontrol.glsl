@@ -0,0 +1,21 @@
+#version 400
+
+// bicubic Bezier patches, 16 control points per patch
+layout(vertices = 16) out;
+in vec3 vPosition[];
+out vec3 tcPosition[];
+// the uniforms are in FrameBlock / ObjectBlock from tessblocks.glsl
+
+void main()
+{
+		tcPosition[gl_InvocationID] = vPosition[gl_InvocationID];
+		if (gl_InvocationID == 0)
+		{
+				gl_TessLevelInner[0] = TessLevelInner;
+				gl_TessLevelInner[1] = TessLevelInner;
+				gl_TessLevelOuter[0] = TessLevelOuter;
+				gl_TessLevelOuter[1] = TessLevelOuter;
+				gl_TessLevelOuter[2] = TessLevelOuter;
+				gl_TessLevelOuter[3] = TessLevelOuter;
+		}
+}
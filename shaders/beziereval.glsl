@@ -0,0 +1,31 @@
+#version 400
+
+layout(quads, equal_spacing, cw) in;
+in vec3 tcPosition[];
+out vec3 tePosition;
+out vec3 tePatchDistance;
+
+// cubic Bernstein basis at t
+vec4 bernstein(float t)
+{
+		float s = 1.0 - t;
+		return vec4(s * s * s, 3.0 * s * s * t, 3.0 * s * t * t, t * t * t);
+}
+
+void main()
+{
+		float u = gl_TessCoord.x;
+		float v = gl_TessCoord.y;
+		vec4 bu = bernstein(u);
+		vec4 bv = bernstein(v);
+		// control point (i,j) is tcPosition[j * 4 + i], the same order as BezierPatch.h
+		vec3 p = vec3(0.0);
+		for (int j = 0; j < 4; ++j)
+		{
+				p += bv[j] * (bu.x * tcPosition[j * 4] + bu.y * tcPosition[j * 4 + 1] + bu.z * tcPosition[j * 4 + 2] + bu.w * tcPosition[j * 4 + 3]);
+		}
+		tePosition = p;
+		// distance to the nearest patch edge, what tessfrag.glsl expects from the triangle barycentrics
+		tePatchDistance = vec3(min(u, 1.0 - u), min(v, 1.0 - v), 1.0);
+		gl_Position = MVP * vec4(p, 1);
+}
@@ -0,0 +1,10 @@
+#version 400
+in vec2 vUV;
+uniform sampler2D Atlas;
+uniform vec3 Colour;
+out vec4 FragColor;
+
+void main()
+{
+		FragColor = vec4(Colour, texture(Atlas, vUV).a);
+}
@@ -0,0 +1,12 @@
+#version 400
+layout (location = 0) in vec2 inPosition;
+layout (location = 1) in vec2 inUV;
+// viewport size in pixels, positions are in pixels from the top left
+uniform vec2 ScreenSize;
+out vec2 vUV;
+
+void main()
+{
+		vUV = inUV;
+		gl_Position = vec4(inPosition.x / ScreenSize.x * 2.0 - 1.0, 1.0 - inPosition.y / ScreenSize.y * 2.0, 0.0, 1.0);
+}
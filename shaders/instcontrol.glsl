@@ -0,0 +1,21 @@
+#version 430
+
+layout(vertices = 3) out;
+in vec3 vPosition[];
+in uint vInstance[];
+out vec3 tcPosition[];
+patch out uint tcInstance;
+// the levels come from FrameBlock, adaptive levels and patch culling are left to the per object path
+
+void main()
+{
+		tcPosition[gl_InvocationID] = vPosition[gl_InvocationID];
+		if (gl_InvocationID == 0)
+		{
+				tcInstance = vInstance[0];
+				gl_TessLevelInner[0] = TessLevelInner;
+				gl_TessLevelOuter[0] = TessLevelOuter;
+				gl_TessLevelOuter[1] = TessLevelOuter;
+				gl_TessLevelOuter[2] = TessLevelOuter;
+		}
+}
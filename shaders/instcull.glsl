@@ -0,0 +1,57 @@
+#version 430
+// one thread per instance, visible instances are appended to the part of the visible list belonging to their LOD
+// and counted in that LOD's DrawElementsIndirect command, the CPU resets the counts to 0 every frame
+layout(local_size_x = 64) in;
+
+struct Instance
+{
+	mat4 model;
+	vec4 sphere;
+};
+layout(std430, binding = 0) readonly buffer InstanceBuffer
+{
+	Instance instances[];
+};
+layout(std430, binding = 1) writeonly buffer VisibleBuffer
+{
+	uint visible[];
+};
+// the layout of a GL DrawElementsIndirectCommand
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+layout(std430, binding = 2) buffer CommandBuffer
+{
+	DrawCommand commands[];
+};
+uniform uint InstanceCount;
+// instances further than this from the eye use the next coarser control mesh
+uniform float LODDistance;
+
+void main()
+{
+		uint i = gl_GlobalInvocationID.x;
+		if (i >= InstanceCount)
+		{
+				return;
+		}
+		vec4 s = instances[i].sphere;
+		// the same sphere test as patchCulled in tesscontrol.glsl
+		vec4 planes[6];
+		frustumPlanes(planes);
+		for (int p = 0; p < 6; ++p)
+		{
+				if (dot(planes[p].xyz, s.xyz) + planes[p].w < -s.w * length(planes[p].xyz))
+				{
+						return;
+				}
+		}
+		uint lod = min(uint(distance(s.xyz, EyePosition) / LODDistance), uint(commands.length()) - 1u);
+		uint slot = atomicAdd(commands[lod].instanceCount, 1u);
+		visible[commands[lod].baseInstance + slot] = i;
+}
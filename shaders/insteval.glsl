@@ -0,0 +1,29 @@
+#version 430
+
+layout(triangles, equal_spacing, cw) in;
+// must match InstanceData in InstancedScene.h
+struct Instance
+{
+	mat4 model;
+	// bounding sphere, centre and radius
+	vec4 sphere;
+};
+layout(std430, binding = 0) readonly buffer InstanceBuffer
+{
+	Instance instances[];
+};
+in vec3 tcPosition[];
+patch in uint tcInstance;
+out vec3 tePosition;
+out vec3 tePatchDistance;
+
+void main()
+{
+		vec3 p0 = gl_TessCoord.x * tcPosition[0];
+		vec3 p1 = gl_TessCoord.y * tcPosition[1];
+		vec3 p2 = gl_TessCoord.z * tcPosition[2];
+		tePatchDistance = gl_TessCoord;
+		// tePosition is in scene space so tessgeom.glsl's facet normals include the instance rotation
+		tePosition = (instances[tcInstance].model * vec4(normalize(p0 + p1 + p2), 1)).xyz;
+		gl_Position = MVP * vec4(tePosition, 1);
+}
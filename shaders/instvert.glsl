@@ -0,0 +1,14 @@
+#version 430
+// instanced sphere patches, inInstance is the instance this copy of the mesh belongs to, read from the visible
+// list instcull.glsl wrote (the draw's baseInstance picks the LOD's part of the list)
+layout (location = 0) in vec3 inVert;
+layout (location = 1) in uint inInstance;
+
+out vec3 vPosition;
+out uint vInstance;
+
+void main()
+{
+		vPosition = inVert;
+		vInstance = inInstance;
+}
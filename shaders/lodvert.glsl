@@ -0,0 +1,13 @@
+#version 400
+// pre tessellated sphere, outputs the same values as tesseval.glsl so tessgeom.glsl / tessfrag.glsl can be reused
+layout (location = 0) in vec3 inVert;
+layout (location = 1) in vec3 inPatchDistance;
+out vec3 tePosition;
+out vec3 tePatchDistance;
+
+void main()
+{
+		tePosition = inVert;
+		tePatchDistance = inPatchDistance;
+		gl_Position = MVP * vec4(inVert, 1);
+}
@@ -0,0 +1,93 @@
+#version 400
+
+layout(vertices = 4) out;
+in vec2 vCorner[];
+in vec3 vTile[];
+out vec2 tcCorner[];
+patch out vec3 tcTile;
+// set by TerrainScene, the blocks are in FrameBlock / ObjectBlock from tessblocks.glsl
+uniform float TileSize;
+uniform float HeightScale;
+// height samples along a patch edge, more segments than that add nothing the heightmap can show
+uniform float PatchSamples;
+// the levels always come from the distance to the eye and patches outside the frustum are always dropped, the
+// Adaptive / CullPatches switches are for the sphere
+
+vec3 cornerPosition(int i)
+{
+		// half way up, the heights aren't known until the evaluation stage
+		return vec3((vTile[i].x + vCorner[i].x) * TileSize, 0.5 * HeightScale, (vTile[i].y + vCorner[i].y) * TileSize);
+}
+
+float edgeLevel(vec3 a, vec3 b)
+{
+		// order the end points so both patches sharing this edge, in the same tile or not, do the same arithmetic
+		if (a.x > b.x || (a.x == b.x && a.z > b.z))
+		{
+				vec3 t = a;
+				a = b;
+				b = t;
+		}
+		// the edge's projected length, so the level falls off with the distance of its middle from the eye
+		vec3 va = (Modelview * vec4(a, 1)).xyz;
+		vec3 vb = (Modelview * vec4(b, 1)).xyz;
+		float dist = max(length(0.5 * (va + vb)), 0.0001);
+		float pixels = distance(va, vb) * ProjectionScale / dist;
+		return clamp(pixels / TargetEdgePixels, 1.0, PatchSamples);
+}
+
+bool patchCulled(vec3 lo, vec3 hi)
+{
+		// the box from the patch's corners spanning every height, against the frustum planes
+		lo.y = 0.0;
+		hi.y = HeightScale;
+		vec4 planes[6];
+		frustumPlanes(planes);
+		for (int i = 0; i < 6; ++i)
+		{
+				// the corner of the box furthest along the plane normal
+				vec3 p = mix(lo, hi, step(vec3(0.0), planes[i].xyz));
+				if (dot(planes[i].xyz, p) + planes[i].w < 0.0)
+				{
+						return true;
+				}
+		}
+		return false;
+}
+
+void main()
+{
+		tcCorner[gl_InvocationID] = vCorner[gl_InvocationID];
+		if (gl_InvocationID == 0)
+		{
+				tcTile = vTile[0];
+				// corners 0 1 2 3 are (0,0) (1,0) (1,1) (0,1) of the patch
+				vec3 p0 = cornerPosition(0);
+				vec3 p1 = cornerPosition(1);
+				vec3 p2 = cornerPosition(2);
+				vec3 p3 = cornerPosition(3);
+				if (patchCulled(p0, p2))
+				{
+						gl_TessLevelInner[0] = 0.0;
+						gl_TessLevelInner[1] = 0.0;
+						gl_TessLevelOuter[0] = 0.0;
+						gl_TessLevelOuter[1] = 0.0;
+						gl_TessLevelOuter[2] = 0.0;
+						gl_TessLevelOuter[3] = 0.0;
+				}
+				else
+				{
+						// outer levels 0 to 3 are the u = 0, v = 0, u = 1 and v = 1 edges
+						float e0 = edgeLevel(p3, p0);
+						float e1 = edgeLevel(p0, p1);
+						float e2 = edgeLevel(p1, p2);
+						float e3 = edgeLevel(p2, p3);
+						gl_TessLevelOuter[0] = e0;
+						gl_TessLevelOuter[1] = e1;
+						gl_TessLevelOuter[2] = e2;
+						gl_TessLevelOuter[3] = e3;
+						gl_TessLevelInner[0] = max(e1, e3);
+						gl_TessLevelInner[1] = max(e0, e2);
+				}
+		}
+}
@@ -0,0 +1,26 @@
+#version 400
+
+// fractional spacing so the levels change smoothly as the camera flies, without popping
+layout(quads, fractional_even_spacing, ccw) in;
+in vec2 tcCorner[];
+patch in vec3 tcTile;
+out vec3 tePosition;
+out vec3 tePatchDistance;
+// TerrainScene's tile pool, one uint16 (GL_R16) height tile per layer
+uniform sampler2DArray HeightTiles;
+uniform float TileSize;
+uniform float HeightScale;
+// samples along a tile side
+uniform float TileSamples;
+
+void main()
+{
+		vec2 uv = mix(mix(tcCorner[0], tcCorner[1], gl_TessCoord.x), mix(tcCorner[3], tcCorner[2], gl_TessCoord.x), gl_TessCoord.y);
+		// uv 0 and 1 land on the centres of the border texels, which the neighbouring tiles repeat
+		vec2 st = (uv * (TileSamples - 1.0) + 0.5) / TileSamples;
+		float height = textureLod(HeightTiles, vec3(st, tcTile.z), 0.0).r * HeightScale;
+		tePosition = vec3((tcTile.x + uv.x) * TileSize, height, (tcTile.y + uv.y) * TileSize);
+		// the nearest patch edge is the smallest of these, for tessfrag.glsl's outlines
+		tePatchDistance = vec3(gl_TessCoord.xy, min(1.0 - gl_TessCoord.x, 1.0 - gl_TessCoord.y));
+		gl_Position = MVP * vec4(tePosition, 1);
+}
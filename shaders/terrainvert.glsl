@@ -0,0 +1,14 @@
+#version 400
+// a terrain patch corner in tile space (0..1) and the tile this copy of the patch grid is drawn for, x, z and its
+// layer in the height tile array (TerrainScene's per instance attribute)
+layout (location = 0) in vec2 inCorner;
+layout (location = 1) in vec3 inTile;
+
+out vec2 vCorner;
+out vec3 vTile;
+
+void main()
+{
+		vCorner = inCorner;
+		vTile = inTile;
+}
@@ -0,0 +1,38 @@
+// std140 uniform blocks shared by every stage of the Tess programs, injected after the #version line.
+// The layout must match FrameUniforms / ObjectUniforms in TessUniforms.h
+layout(std140) uniform FrameBlock
+{
+	float TessLevelInner;
+	float TessLevelOuter;
+	// Projection[1][1] * viewport height / 2, converts view space size / distance to pixels
+	float ProjectionScale;
+	float TargetEdgePixels;
+	// adaptive mode, levels come from the projected size of each edge
+	int Adaptive;
+	// patch culling, a patch with an outer level of 0 is discarded before the tessellator runs
+	int CullPatches;
+	// multiply each patch's inner level by its PatchHints texel (streamed .tpm meshes)
+	int UsePatchHints;
+};
+
+layout(std140) uniform ObjectBlock
+{
+	mat4 MVP;
+	mat4 Modelview;
+	mat3 NormalMatrix;
+	// the eye in object space
+	vec3 EyePosition;
+	// snorm16 control points are stored divided by this (fills the padding after EyePosition)
+	float PositionScale;
+};
+
+// the six clip planes in object space straight from the rows of the MVP (left, right, bottom, top, near, far), a
+// point is inside when dot(plane.xyz, p) + plane.w >= 0. Not normalised, scale a distance by length(plane.xyz)
+void frustumPlanes(out vec4 planes[6])
+{
+	vec4 rowX = vec4(MVP[0][0], MVP[1][0], MVP[2][0], MVP[3][0]);
+	vec4 rowY = vec4(MVP[0][1], MVP[1][1], MVP[2][1], MVP[3][1]);
+	vec4 rowZ = vec4(MVP[0][2], MVP[1][2], MVP[2][2], MVP[3][2]);
+	vec4 rowW = vec4(MVP[0][3], MVP[1][3], MVP[2][3], MVP[3][3]);
+	planes = vec4[6](rowW + rowX, rowW - rowX, rowW + rowY, rowW - rowY, rowW + rowZ, rowW - rowZ);
+}
@@ -3,18 +3,98 @@
 layout(vertices = 3) out;
 in vec3 vPosition[];
 out vec3 tcPosition[];
-uniform float TessLevelInner;
-uniform float TessLevelOuter;
+// the uniforms are in FrameBlock / ObjectBlock from tessblocks.glsl
+// one inner level multiplier per patch, only read when UsePatchHints is set
+uniform samplerBuffer PatchHints;
 
+float edgeLevel(vec3 a, vec3 b)
+{
+		// order the end points so both patches sharing this edge do exactly the same arithmetic
+		if (a.x > b.x || (a.x == b.x && (a.y > b.y || (a.y == b.y && a.z > b.z))))
+		{
+				vec3 t = a;
+				a = b;
+				b = t;
+		}
+		// project the sphere around the edge, this stays sane for edges crossing the near plane
+		vec3 va = (Modelview * vec4(a, 1)).xyz;
+		vec3 vb = (Modelview * vec4(b, 1)).xyz;
+		float diameter = distance(va, vb);
+		float dist = max(length(0.5 * (va + vb)), 0.0001);
+		float pixels = diameter * ProjectionScale / dist;
+		return clamp(pixels / TargetEdgePixels, 1.0, 64.0);
+}
+
+bool patchCulled()
+{
+		vec3 p0 = vPosition[0];
+		vec3 p1 = vPosition[1];
+		vec3 p2 = vPosition[2];
+		// bounding sphere of the flat triangle grown by how far the surface bulges out to the unit sphere
+		vec3 c = (p0 + p1 + p2) / 3.0;
+		float r = max(distance(c, p0), max(distance(c, p1), distance(c, p2)));
+		vec3 n = normalize(cross(p1 - p0, p2 - p0));
+		r += 1.0 - abs(dot(n, p0));
+		// the sphere against the frustum planes
+		vec4 planes[6];
+		frustumPlanes(planes);
+		for (int i = 0; i < 6; ++i)
+		{
+				if (dot(planes[i].xyz, c) + planes[i].w < -r * length(planes[i].xyz))
+				{
+						return true;
+				}
+		}
+		// the normals of the sphere patch are its points, they all lie in the cone around the centre direction
+		// that holds the corners. The patch faces away if even the best point in that cone does.
+		float eyeDist = length(EyePosition);
+		if (eyeDist > 1.0)
+		{
+				vec3 axis = normalize(c);
+				float alpha = acos(clamp(min(dot(axis, normalize(p0)), min(dot(axis, normalize(p1)), dot(axis, normalize(p2)))), -1.0, 1.0));
+				float theta = acos(clamp(dot(axis, EyePosition / eyeDist), -1.0, 1.0));
+				if (eyeDist * cos(max(0.0, theta - alpha)) < 1.0)
+				{
+						return true;
+				}
+		}
+		return false;
+}
 
 void main()
 {
 		tcPosition[gl_InvocationID] = vPosition[gl_InvocationID];
 		if (gl_InvocationID == 0)
 		{
-				gl_TessLevelInner[0] = TessLevelInner;
-				gl_TessLevelOuter[0] = TessLevelOuter;
-				gl_TessLevelOuter[1] = TessLevelOuter;
-				gl_TessLevelOuter[2] = TessLevelOuter;
+				if (CullPatches != 0 && patchCulled())
+				{
+						gl_TessLevelInner[0] = 0.0;
+						gl_TessLevelOuter[0] = 0.0;
+						gl_TessLevelOuter[1] = 0.0;
+						gl_TessLevelOuter[2] = 0.0;
+				}
+				else if (Adaptive != 0)
+				{
+						// outer level i is the edge opposite vertex i
+						float e0 = edgeLevel(vPosition[1], vPosition[2]);
+						float e1 = edgeLevel(vPosition[2], vPosition[0]);
+						float e2 = edgeLevel(vPosition[0], vPosition[1]);
+						gl_TessLevelOuter[0] = e0;
+						gl_TessLevelOuter[1] = e1;
+						gl_TessLevelOuter[2] = e2;
+						gl_TessLevelInner[0] = (e0 + e1 + e2) / 3.0;
+				}
+				else
+				{
+						gl_TessLevelInner[0] = TessLevelInner;
+						gl_TessLevelOuter[0] = TessLevelOuter;
+						gl_TessLevelOuter[1] = TessLevelOuter;
+						gl_TessLevelOuter[2] = TessLevelOuter;
+				}
+				// scaling only the inner level keeps the shared edges matching, so hinted patches never crack
+				if (UsePatchHints != 0)
+				{
+						gl_TessLevelInner[0] = clamp(gl_TessLevelInner[0] * texelFetch(PatchHints, gl_PrimitiveID).r, 1.0, 64.0);
+				}
 		}
 }
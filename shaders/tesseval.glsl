@@ -1,10 +1,20 @@
 #version 400
 
-layout(triangles, equal_spacing, cw) in;
+// the Tess permutations (TessVariant) pick the spacing, winding and point mode through these defines
+#ifndef TESS_SPACING
+#define TESS_SPACING equal_spacing
+#endif
+#ifndef TESS_WINDING
+#define TESS_WINDING cw
+#endif
+#ifdef TESS_POINT_MODE
+layout(triangles, TESS_SPACING, TESS_WINDING, point_mode) in;
+#else
+layout(triangles, TESS_SPACING, TESS_WINDING) in;
+#endif
 in vec3 tcPosition[];
 out vec3 tePosition;
 out vec3 tePatchDistance;
-uniform mat4 MVP;
 
 void main()
 {
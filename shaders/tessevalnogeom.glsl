@@ -0,0 +1,32 @@
+#version 400
+
+// the Tess permutations (TessVariant) pick the spacing, winding and point mode through these defines
+#ifndef TESS_SPACING
+#define TESS_SPACING equal_spacing
+#endif
+#ifndef TESS_WINDING
+#define TESS_WINDING cw
+#endif
+#ifdef TESS_POINT_MODE
+layout(triangles, TESS_SPACING, TESS_WINDING, point_mode) in;
+#else
+layout(triangles, TESS_SPACING, TESS_WINDING) in;
+#endif
+in vec3 tcPosition[];
+out vec3 tePosition;
+out vec3 tePatchDistance;
+flat out float teInnerLevel;
+
+void main()
+{
+		vec3 p0 = gl_TessCoord.x * tcPosition[0];
+		vec3 p1 = gl_TessCoord.y * tcPosition[1];
+		vec3 p2 = gl_TessCoord.z * tcPosition[2];
+		tePatchDistance = gl_TessCoord;
+		// the fragment stage rebuilds the triangle edges from the patch coordinates so it needs the inner level,
+		// an inner level of 1 with any outer level above 1 is generated as 2
+		float outer = max(gl_TessLevelOuter[0], max(gl_TessLevelOuter[1], gl_TessLevelOuter[2]));
+		teInnerLevel = (gl_TessLevelInner[0] <= 1.0 && outer > 1.0) ? 2.0 : gl_TessLevelInner[0];
+		tePosition = normalize(p0 + p1 + p2);
+		gl_Position =   MVP * vec4(tePosition, 1);
+}
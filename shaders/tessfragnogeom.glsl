@@ -0,0 +1,70 @@
+#version 400
+
+out vec4 FragColor;
+in vec3 tePosition;
+in vec3 tePatchDistance;
+flat in float teInnerLevel;
+uniform vec3 LightPosition;
+uniform vec3 DiffuseMaterial;
+uniform vec3 AmbientMaterial;
+
+float amplify(float d, float scale, float offset)
+{
+		d = scale * d + offset;
+		d = clamp(d, 0, 1);
+		d = 1 - exp2(-2*d*d);
+		return d;
+}
+
+// distance to the nearest integer
+float gridDistance(float x)
+{
+		return abs(x - round(x));
+}
+
+// Without a geometry shader we don't know where we are inside the generated triangle, but with equal_spacing
+// the tessellator lays the triangles out on concentric rings we can rebuild from gl_TessCoord. Each ring side
+// lies on a line u, v or w = 2r/3n, neighbouring rings are joined by rungs at k/m along the side and one
+// diagonal per quad. This is exact for uniform inner / outer levels and close enough otherwise.
+float triangleEdgeDistance(vec3 b)
+{
+		float n = ceil(clamp(teInnerLevel, 1.0, 64.0));
+		if (n <= 1.0)
+		{
+				return min(min(b.x, b.y), b.z);
+		}
+		float c = min(min(b.x, b.y), b.z);
+		// how far in we are counted in rings
+		float ring = c * 1.5 * n;
+		float R = min(floor(ring), floor(n * 0.5) - 1.0);
+		float h = ring - R;
+		float m = n - 2.0 * R;
+		// the other two coordinates give the position along the side of the ring in segments
+		vec2 o = c == b.x ? b.yz : (c == b.y ? b.zx : b.xy);
+		float t = 0.5 * m + 0.5 * n * (o.y - o.x);
+		float dRing = gridDistance(ring);
+		float dRung = gridDistance(t);
+		float dDiagonal = gridDistance(t - h) * 0.7071;
+		return min(dRing, min(dRung, dDiagonal));
+}
+
+void main()
+{
+#ifdef TESS_POINT_MODE
+		// a point has no screen space derivatives or edges, light it with the sphere's normal
+		vec3 N = normalize(NormalMatrix * tePosition);
+		FragColor = vec4(AmbientMaterial + abs(dot(N, LightPosition)) * DiffuseMaterial, 1.0);
+#else
+		// facet normal from the screen space derivatives of the position
+		vec3 N = normalize(NormalMatrix * cross(dFdx(tePosition), dFdy(tePosition)));
+		vec3 L = LightPosition;
+		float df = abs(dot(N, L));
+		vec3 color = AmbientMaterial + df * DiffuseMaterial;
+
+		float d1 = triangleEdgeDistance(tePatchDistance);
+		float d2 = min(min(tePatchDistance.x, tePatchDistance.y), tePatchDistance.z);
+		color = amplify(d1, 40, -0.5) * amplify(d2, 60, -0.5) * color;
+
+		FragColor = vec4(color,1.0);
+#endif
+}
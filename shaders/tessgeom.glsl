@@ -1,8 +1,5 @@
 #version 400
 
-uniform mat4 Modelview;
-uniform mat3 NormalMatrix;
-
 layout(triangles) in;
 layout(triangle_strip, max_vertices = 3) out;
 in vec3 tePosition[3];
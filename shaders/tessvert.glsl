@@ -1,10 +1,32 @@
 #version 400
+// the control points come in as whatever tess::PositionFormat the mesh was encoded with, TessProgram adds the
+// POSITION_* define to match
+#if defined(POSITION_OCTAHEDRAL)
+layout (location = 0) in vec2 inVert;
+#else
 layout (location = 0) in vec3 inVert;
-uniform mat4 MVP;
+#endif
 
 out vec3 vPosition;
 
+#if defined(POSITION_OCTAHEDRAL)
+// unfold a unit vector stored on the octahedron, the reverse of tess::encodePatchMesh
+vec3 octahedralDecode(vec2 e)
+{
+		vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+		float t = max(-v.z, 0.0);
+		v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+		return normalize(v);
+}
+#endif
+
 void main()
 {
+#if defined(POSITION_OCTAHEDRAL)
+		vPosition = octahedralDecode(inVert);
+#elif defined(POSITION_SNORM16)
+		vPosition = inVert * PositionScale;
+#else
 		vPosition = inVert;
+#endif
 }
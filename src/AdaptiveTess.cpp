@@ -0,0 +1,42 @@
+#include "AdaptiveTess.h"
+#include "TessMath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tess
+{
+
+float adaptiveEdgeLevel(const float *_a, const float *_b, const ScreenSpaceParams &_params)
+{
+  // same ordering as edgeLevel in tesscontrol.glsl so both patches do the same arithmetic
+  if (_a[0] > _b[0] || (_a[0] == _b[0] && (_a[1] > _b[1] || (_a[1] == _b[1] && _a[2] > _b[2]))))
+  {
+    std::swap(_a, _b);
+  }
+  float va[4];
+  float vb[4];
+  transformPoint(_params.modelView, _a, va);
+  transformPoint(_params.modelView, _b, vb);
+  float dx = va[0] - vb[0];
+  float dy = va[1] - vb[1];
+  float dz = va[2] - vb[2];
+  float diameter = std::sqrt(dx * dx + dy * dy + dz * dz);
+  float cx = 0.5f * (va[0] + vb[0]);
+  float cy = 0.5f * (va[1] + vb[1]);
+  float cz = 0.5f * (va[2] + vb[2]);
+  float dist = std::max(std::sqrt(cx * cx + cy * cy + cz * cz), 0.0001f);
+  float pixels = diameter * _params.projectionScale / dist;
+  return std::min(static_cast<float>(MaxTessLevel), std::max(1.0f, pixels / _params.targetEdgePixels));
+}
+
+TessLevels adaptivePatchLevels(const float *_p0, const float *_p1, const float *_p2, const ScreenSpaceParams &_params)
+{
+  TessLevels levels;
+  levels.outer[0] = adaptiveEdgeLevel(_p1, _p2, _params);
+  levels.outer[1] = adaptiveEdgeLevel(_p2, _p0, _params);
+  levels.outer[2] = adaptiveEdgeLevel(_p0, _p1, _params);
+  levels.inner = (levels.outer[0] + levels.outer[1] + levels.outer[2]) / 3.0f;
+  return levels;
+}
+
+} // end namespace tess
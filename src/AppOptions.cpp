@@ -0,0 +1,110 @@
+#include "AppOptions.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <algorithm>
+
+AppOptions parseAppOptions(const QCoreApplication &_app)
+{
+  QCommandLineParser parser;
+  parser.setApplicationDescription("GLSL tessellation shader demo");
+  parser.addHelpOption();
+  QCommandLineOption noGeometry("no-geometry-shader", "Start with the Tess program variant that has no geometry shader.");
+  parser.addOption(noGeometry);
+  QCommandLineOption noProgramCache("no-program-cache", "Always compile the shaders, don't use the program binary cache.");
+  parser.addOption(noProgramCache);
+  QCommandLineOption subdivisions("subdivisions", "Split the icosahedron's faces into 4 this many times for the sphere's patches (0..8).", "n", "0");
+  parser.addOption(subdivisions);
+  QCommandLineOption positions("positions", "Control point encoding, float, snorm16 or octahedral.", "format", "float");
+  parser.addOption(positions);
+  QCommandLineOption indices("indices", "Patch index size in bits (8, 16 or 32), 0 uses the smallest that fits.", "bits", "0");
+  parser.addOption(indices);
+  QCommandLineOption reorder("reorder", "Reorder the patches and vertices for the post transform cache.");
+  parser.addOption(reorder);
+  QCommandLineOption mesh("mesh", "Stream a .tpm control mesh (written by TessMeshTool) in and draw it instead of the sphere.", "file");
+  parser.addOption(mesh);
+  QCommandLineOption lodLevels("lod-levels", "Highest level pre tessellated for the precomputed LOD mode (1..64).", "level", "64");
+  parser.addOption(lodLevels);
+  QCommandLineOption budget("budget", "GPU frame time in ms the automatic level controller (key T) aims for.", "ms", "8");
+  parser.addOption(budget);
+  QCommandLineOption patches("patches", "Bicubic Bezier patches (.bpt) for the patch mode (key B), e.g. the Utah teapot.", "file");
+  parser.addOption(patches);
+  QCommandLineOption capture("capture", "Capture the tessellated sphere of the first frame to a .ply (or raw float) file.", "file");
+  parser.addOption(capture);
+  QCommandLineOption screenshot("screenshot", "Save the first frame, without the HUD, to a .ppm for comparing with TessRender.", "file");
+  parser.addOption(screenshot);
+  QCommandLineOption level("level", "Inner and outer tessellation level to start at (1..64).", "level", "1");
+  parser.addOption(level);
+  QCommandLineOption trace("trace", "Record CPU and GPU trace zones and write them as Chrome trace JSON (Perfetto) on exit.", "file");
+  parser.addOption(trace);
+  QCommandLineOption record("record", "Record the mouse and key input to a file for --replay.", "file");
+  parser.addOption(record);
+  QCommandLineOption replay("replay", "Play recorded input back one frame at a time, print the frame times and exit.", "file");
+  parser.addOption(replay);
+  QCommandLineOption headless("headless", "Don't show a window (Qt's offscreen platform), for --replay runs without a display.");
+  parser.addOption(headless);
+  QCommandLineOption instances("instances", "Number of spheres drawn by the instanced mode (key I).", "count", "20000");
+  parser.addOption(instances);
+  QCommandLineOption terrain("terrain", "Height tiles (.tht, written by TessMeshTool) streamed by the terrain mode (key E).", "file");
+  parser.addOption(terrain);
+  QCommandLineOption bench("bench", "Run the headless benchmark over all tessellation levels and exit.");
+  parser.addOption(bench);
+  QCommandLineOption benchFrames("bench-frames", "Frames measured per level combination.", "frames", "10");
+  parser.addOption(benchFrames);
+  QCommandLineOption benchStep("bench-step", "Step between the levels measured (1 measures all of 1..64, 64 is always measured).", "step", "1");
+  parser.addOption(benchStep);
+  QCommandLineOption benchSize("bench-size", "Size of the offscreen framebuffer.", "WxH", "1024x720");
+  parser.addOption(benchSize);
+  QCommandLineOption benchEncodings("bench-encodings", "Benchmark the plain float / 32 bit mesh and every compact encoding.");
+  parser.addOption(benchEncodings);
+  QCommandLineOption benchOutput("bench-output", "Results are written to <name>.csv and <name>.json.", "name", "bench_results");
+  parser.addOption(benchOutput);
+  parser.process(_app);
+
+  AppOptions options;
+  if (parser.isSet(noGeometry))
+  {
+    options.pipeline = TessPipeline::NoGeometryShader;
+  }
+  options.programCache = !parser.isSet(noProgramCache);
+  options.patchMesh.subdivisions = std::min(8, std::max(0, parser.value(subdivisions).toInt()));
+  if (parser.value(positions) == "snorm16")
+  {
+    options.patchMesh.positions = tess::PositionFormat::Snorm16;
+  }
+  else if (parser.value(positions) == "octahedral")
+  {
+    options.patchMesh.positions = tess::PositionFormat::Octahedral;
+  }
+  options.patchMesh.indexBits = parser.value(indices).toInt();
+  options.patchMesh.reorder = parser.isSet(reorder);
+  options.meshFile = parser.value(mesh).toStdString();
+  if (!options.meshFile.empty())
+  {
+    // .tpm positions are always floats and the Tess programs are built for one format
+    options.patchMesh.positions = tess::PositionFormat::Float32;
+  }
+  options.lodLevels = std::min(64, std::max(1, parser.value(lodLevels).toInt()));
+  options.budgetMS = std::max(0.1f, parser.value(budget).toFloat());
+  options.patchFile = parser.value(patches).toStdString();
+  options.captureFile = parser.value(capture).toStdString();
+  options.screenshotFile = parser.value(screenshot).toStdString();
+  options.level = std::min(64.0f, std::max(1.0f, parser.value(level).toFloat()));
+  options.traceFile = parser.value(trace).toStdString();
+  options.recordFile = parser.value(record).toStdString();
+  options.replayFile = parser.value(replay).toStdString();
+  options.headless = parser.isSet(headless);
+  options.instances = std::max(1, parser.value(instances).toInt());
+  options.terrainFile = parser.value(terrain).toStdString();
+  options.bench = parser.isSet(bench);
+  options.benchFrames = std::max(1, parser.value(benchFrames).toInt());
+  options.benchStep = std::max(1, parser.value(benchStep).toInt());
+  auto size = parser.value(benchSize).split('x');
+  if (size.size() == 2)
+  {
+    options.benchWidth = std::max(1, size[0].toInt());
+    options.benchHeight = std::max(1, size[1].toInt());
+  }
+  options.benchEncodings = parser.isSet(benchEncodings);
+  options.benchOutput = parser.value(benchOutput).toStdString();
+  return options;
+}
@@ -0,0 +1,304 @@
+#include "BezierPatch.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define TESS_USE_SSE 1
+#endif
+
+namespace tess
+{
+
+bool loadBezierPatches(const std::string &_fname, BezierPatchMesh &o_mesh)
+{
+  std::ifstream in(_fname);
+  if (!in)
+  {
+    std::cerr << "Unable to open " << _fname << '\n';
+    return false;
+  }
+  size_t count = 0;
+  if (!(in >> count))
+  {
+    std::cerr << _fname << " doesn't start with a patch count\n";
+    return false;
+  }
+  o_mesh = BezierPatchMesh();
+  // .bpt repeats shared control points in every patch, weld exact copies so the cage is only uploaded once
+  std::map<std::array<float, 3>, uint32_t> welded;
+  for (size_t patch = 0; patch < count; ++patch)
+  {
+    int degreeU = 0;
+    int degreeV = 0;
+    in >> degreeU >> degreeV;
+    if (!in || degreeU != 3 || degreeV != 3)
+    {
+      std::cerr << _fname << " patch " << patch << " is not bicubic, only 3 3 patches are supported\n";
+      return false;
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+      std::array<float, 3> p;
+      in >> p[0] >> p[1] >> p[2];
+      if (!in)
+      {
+        std::cerr << _fname << " ends in the middle of patch " << patch << '\n';
+        return false;
+      }
+      auto it = welded.find(p);
+      if (it == welded.end())
+      {
+        it = welded.emplace(p, static_cast<uint32_t>(o_mesh.numControlPoints())).first;
+        o_mesh.controlPoints.insert(o_mesh.controlPoints.end(), p.begin(), p.end());
+      }
+      o_mesh.patchIndices.push_back(it->second);
+    }
+  }
+  return true;
+}
+
+void makeWaveGrid(int _patchesX, int _patchesZ, float _size, BezierPatchMesh &o_mesh)
+{
+  o_mesh = BezierPatchMesh();
+  _patchesX = std::max(1, _patchesX);
+  _patchesZ = std::max(1, _patchesZ);
+  // one shared lattice of control points, each patch takes a 4x4 window that overlaps its neighbours by one
+  const int pointsX = _patchesX * 3 + 1;
+  const int pointsZ = _patchesZ * 3 + 1;
+  const float twoPi = 6.28318530718f;
+  for (int z = 0; z < pointsZ; ++z)
+  {
+    for (int x = 0; x < pointsX; ++x)
+    {
+      float s = static_cast<float>(x) / (pointsX - 1);
+      float t = static_cast<float>(z) / (pointsZ - 1);
+      o_mesh.controlPoints.push_back((s - 0.5f) * _size);
+      o_mesh.controlPoints.push_back(0.1f * _size * std::sin(twoPi * s * 1.5f) * std::cos(twoPi * t));
+      // v runs towards -z so dP/du x dP/dv points up
+      o_mesh.controlPoints.push_back((0.5f - t) * _size);
+    }
+  }
+  for (int pz = 0; pz < _patchesZ; ++pz)
+  {
+    for (int px = 0; px < _patchesX; ++px)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        for (int i = 0; i < 4; ++i)
+        {
+          o_mesh.patchIndices.push_back(static_cast<uint32_t>((pz * 3 + j) * pointsX + px * 3 + i));
+        }
+      }
+    }
+  }
+}
+
+size_t expectedQuadTriangleCount(float _inner, float _outer)
+{
+  if (!(_outer > 0.0f))
+  {
+    return 0;
+  }
+  const int outer = static_cast<int>(std::ceil(std::min(static_cast<float>(MaxTessLevel), std::max(1.0f, _outer))));
+  int inner = static_cast<int>(std::ceil(std::min(static_cast<float>(MaxTessLevel), std::max(1.0f, _inner))));
+  if (inner == 1 && outer == 1)
+  {
+    return 2;
+  }
+  // an inner level of 1 is treated as 2 once any outer level is above 1
+  inner = std::max(inner, 2);
+  // concentric rings of inner - 2, inner - 4 ... segments a side, the strip between a ring of a and one of b
+  // segments a side holds 4a + 4b triangles. The innermost ring is either a point or a single quad
+  size_t count = static_cast<size_t>(4 * outer + 4 * (inner - 2));
+  for (int ring = inner - 2; ring > 0; ring -= 2)
+  {
+    count += ring == 1 ? 2 : static_cast<size_t>(4 * ring + 4 * (ring - 2));
+  }
+  return count;
+}
+
+namespace
+{
+  // cubic Bernstein basis and its derivative at t
+  void bernstein(float _t, float *o_b, float *o_d)
+  {
+    float s = 1.0f - _t;
+    o_b[0] = s * s * s;
+    o_b[1] = 3.0f * s * s * _t;
+    o_b[2] = 3.0f * s * _t * _t;
+    o_b[3] = _t * _t * _t;
+    o_d[0] = -3.0f * s * s;
+    o_d[1] = 3.0f * s * s - 6.0f * s * _t;
+    o_d[2] = 6.0f * s * _t - 3.0f * _t * _t;
+    o_d[3] = 3.0f * _t * _t;
+  }
+} // end anonymous namespace
+
+void evaluateBezierPatch(const float *_positions, const uint32_t *_patch, int _level, float *o_xyz, float *o_normals)
+{
+  const int n = std::min(MaxTessLevel, std::max(1, _level));
+  const int rowLength = n + 1;
+  const float *cp[16];
+  for (int i = 0; i < 16; ++i)
+  {
+    cp[i] = &_positions[_patch[i] * 3];
+  }
+  for (int row = 0; row <= n; ++row)
+  {
+    // collapse the v direction first, Q is the curve along u at this v and R its v derivative
+    float bv[4];
+    float dbv[4];
+    bernstein(static_cast<float>(row) / n, bv, dbv);
+    float q[4][3];
+    float r[4][3];
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int k = 0; k < 3; ++k)
+      {
+        q[i][k] = bv[0] * cp[i][k] + bv[1] * cp[4 + i][k] + bv[2] * cp[8 + i][k] + bv[3] * cp[12 + i][k];
+        r[i][k] = dbv[0] * cp[i][k] + dbv[1] * cp[4 + i][k] + dbv[2] * cp[8 + i][k] + dbv[3] * cp[12 + i][k];
+      }
+    }
+    float *rowXYZ = o_xyz + static_cast<size_t>(row) * rowLength * 3;
+    float *rowNormals = o_normals ? o_normals + static_cast<size_t>(row) * rowLength * 3 : nullptr;
+    int col = 0;
+#ifdef TESS_USE_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 three = _mm_set1_ps(3.0f);
+    const __m128 six = _mm_set1_ps(6.0f);
+    const __m128 invN = _mm_set1_ps(1.0f / n);
+    for (; col <= n; col += 4)
+    {
+      __m128 u = _mm_mul_ps(_mm_setr_ps(col + 0.0f, col + 1.0f, col + 2.0f, col + 3.0f), invN);
+      u = _mm_min_ps(u, one);
+      __m128 s = _mm_sub_ps(one, u);
+      __m128 ss = _mm_mul_ps(s, s);
+      __m128 uu = _mm_mul_ps(u, u);
+      __m128 b[4] = {_mm_mul_ps(ss, s), _mm_mul_ps(three, _mm_mul_ps(ss, u)), _mm_mul_ps(three, _mm_mul_ps(s, uu)),
+                     _mm_mul_ps(uu, u)};
+      __m128 su6 = _mm_mul_ps(six, _mm_mul_ps(s, u));
+      __m128 d[4] = {_mm_mul_ps(three, _mm_sub_ps(_mm_setzero_ps(), ss)), _mm_sub_ps(_mm_mul_ps(three, ss), su6),
+                     _mm_sub_ps(su6, _mm_mul_ps(three, uu)), _mm_mul_ps(three, uu)};
+      __m128 p[3];
+      __m128 du[3];
+      __m128 dv[3];
+      for (int k = 0; k < 3; ++k)
+      {
+        p[k] = du[k] = dv[k] = _mm_setzero_ps();
+        for (int i = 0; i < 4; ++i)
+        {
+          p[k] = _mm_add_ps(p[k], _mm_mul_ps(b[i], _mm_set1_ps(q[i][k])));
+          du[k] = _mm_add_ps(du[k], _mm_mul_ps(d[i], _mm_set1_ps(q[i][k])));
+          dv[k] = _mm_add_ps(dv[k], _mm_mul_ps(b[i], _mm_set1_ps(r[i][k])));
+        }
+      }
+      const int count = std::min(4, rowLength - col);
+      alignas(16) float out[3][4];
+      for (int k = 0; k < 3; ++k)
+      {
+        _mm_store_ps(out[k], p[k]);
+      }
+      for (int c = 0; c < count; ++c)
+      {
+        for (int k = 0; k < 3; ++k)
+        {
+          rowXYZ[(col + c) * 3 + k] = out[k][c];
+        }
+      }
+      if (rowNormals)
+      {
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(du[1], dv[2]), _mm_mul_ps(du[2], dv[1]));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(du[2], dv[0]), _mm_mul_ps(du[0], dv[2]));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(du[0], dv[1]), _mm_mul_ps(du[1], dv[0]));
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+        // degenerate points get a zero normal rather than a NaN
+        __m128 valid = _mm_cmpgt_ps(len2, _mm_set1_ps(1.0e-20f));
+        __m128 inv = _mm_and_ps(valid, _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(len2, _mm_set1_ps(1.0e-20f)))));
+        _mm_store_ps(out[0], _mm_mul_ps(nx, inv));
+        _mm_store_ps(out[1], _mm_mul_ps(ny, inv));
+        _mm_store_ps(out[2], _mm_mul_ps(nz, inv));
+        for (int c = 0; c < count; ++c)
+        {
+          for (int k = 0; k < 3; ++k)
+          {
+            rowNormals[(col + c) * 3 + k] = out[k][c];
+          }
+        }
+      }
+    }
+#endif
+    for (; col <= n; ++col)
+    {
+      float bu[4];
+      float dbu[4];
+      bernstein(static_cast<float>(col) / n, bu, dbu);
+      float du[3];
+      float dv[3];
+      for (int k = 0; k < 3; ++k)
+      {
+        rowXYZ[col * 3 + k] = bu[0] * q[0][k] + bu[1] * q[1][k] + bu[2] * q[2][k] + bu[3] * q[3][k];
+        du[k] = dbu[0] * q[0][k] + dbu[1] * q[1][k] + dbu[2] * q[2][k] + dbu[3] * q[3][k];
+        dv[k] = bu[0] * r[0][k] + bu[1] * r[1][k] + bu[2] * r[2][k] + bu[3] * r[3][k];
+      }
+      if (rowNormals)
+      {
+        float nx = du[1] * dv[2] - du[2] * dv[1];
+        float ny = du[2] * dv[0] - du[0] * dv[2];
+        float nz = du[0] * dv[1] - du[1] * dv[0];
+        float len2 = nx * nx + ny * ny + nz * nz;
+        float inv = len2 > 1.0e-20f ? 1.0f / std::sqrt(len2) : 0.0f;
+        rowNormals[col * 3 + 0] = nx * inv;
+        rowNormals[col * 3 + 1] = ny * inv;
+        rowNormals[col * 3 + 2] = nz * inv;
+      }
+    }
+  }
+}
+
+void tessellateBezierPatches(const BezierPatchMesh &_mesh, int _level, TessMesh &o_mesh)
+{
+  const int n = std::min(MaxTessLevel, std::max(1, _level));
+  const size_t nv = static_cast<size_t>(n + 1) * (n + 1);
+  const size_t ni = static_cast<size_t>(n) * n * 6;
+  const size_t numPatches = _mesh.numPatches();
+  o_mesh.positions.resize(numPatches * nv * 3);
+  o_mesh.normals.resize(numPatches * nv * 3);
+  o_mesh.patchCoords.resize(numPatches * nv * 3);
+  o_mesh.indices.resize(numPatches * ni);
+  for (size_t patch = 0; patch < numPatches; ++patch)
+  {
+    evaluateBezierPatch(_mesh.controlPoints.data(), &_mesh.patchIndices[patch * 16], n, &o_mesh.positions[patch * nv * 3],
+                        &o_mesh.normals[patch * nv * 3]);
+    float *pc = &o_mesh.patchCoords[patch * nv * 3];
+    uint32_t *out = &o_mesh.indices[patch * ni];
+    const uint32_t base = static_cast<uint32_t>(patch * nv);
+    for (int row = 0; row <= n; ++row)
+    {
+      for (int col = 0; col <= n; ++col)
+      {
+        *pc++ = static_cast<float>(col) / n;
+        *pc++ = static_cast<float>(row) / n;
+        *pc++ = 0.0f;
+        if (row < n && col < n)
+        {
+          uint32_t a = base + row * (n + 1) + col;
+          uint32_t b = a + 1;
+          uint32_t c = a + n + 1;
+          uint32_t d = c + 1;
+          *out++ = a;
+          *out++ = b;
+          *out++ = d;
+          *out++ = a;
+          *out++ = d;
+          *out++ = c;
+        }
+      }
+    }
+  }
+}
+
+} // end namespace tess
@@ -0,0 +1,319 @@
+#include "CPUTessellator.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define TESS_USE_SSE 1
+#endif
+
+namespace tess
+{
+
+IntLevels roundLevels(const TessLevels &_levels)
+{
+  IntLevels r;
+  auto roundLevel = [](float _l)
+  {
+    // equal_spacing : clamp to [1,max] then round up to the next integer
+    _l = std::min(static_cast<float>(MaxTessLevel), std::max(1.0f, _l));
+    return static_cast<int>(std::ceil(_l));
+  };
+  for (int i = 0; i < 3; ++i)
+  {
+    // note !(x>0) so NaN also discards the patch
+    if (!(_levels.outer[i] > 0.0f))
+    {
+      r.discarded = true;
+    }
+    r.outer[i] = roundLevel(_levels.outer[i]);
+  }
+  r.inner = roundLevel(_levels.inner);
+  bool anyOuter = r.outer[0] > 1 || r.outer[1] > 1 || r.outer[2] > 1;
+  // an inner level of 1 is treated as 1+e if any outer level is > 1 which equal_spacing rounds to 2
+  if (r.inner == 1 && anyOuter)
+  {
+    r.inner = 2;
+  }
+  return r;
+}
+
+size_t expectedVertexCount(const TessLevels &_levels)
+{
+  IntLevels l = roundLevels(_levels);
+  if (l.discarded)
+  {
+    return 0;
+  }
+  if (l.inner == 1)
+  {
+    return 3;
+  }
+  size_t count = l.outer[0] + l.outer[1] + l.outer[2];
+  // each concentric ring has 2 fewer segments per side than the one outside it, a ring of 0 is the centre point
+  for (int m = l.inner - 2; m >= 0; m -= 2)
+  {
+    count += m == 0 ? 1 : 3 * m;
+  }
+  return count;
+}
+
+size_t expectedTriangleCount(const TessLevels &_levels)
+{
+  IntLevels l = roundLevels(_levels);
+  if (l.discarded)
+  {
+    return 0;
+  }
+  if (l.inner == 1)
+  {
+    return 1;
+  }
+  // a strip between a side of p segments and one of q segments holds p+q triangles
+  size_t count = 0;
+  for (int i = 0; i < 3; ++i)
+  {
+    count += l.outer[i] + l.inner - 2;
+  }
+  for (int m = l.inner - 2; m > 0; m -= 2)
+  {
+    count += m == 1 ? 1 : 3 * (m + m - 2);
+  }
+  return count;
+}
+
+TessPattern::TessPattern(const TessLevels &_levels)
+{
+  m_levels = roundLevels(_levels);
+  if (m_levels.discarded)
+  {
+    return;
+  }
+  const int n = m_levels.inner;
+  const auto &o = m_levels.outer;
+  // corners u=1, v=1, w=1
+  addVertex(1.0f, 0.0f, 0.0f);
+  addVertex(0.0f, 1.0f, 0.0f);
+  addVertex(0.0f, 0.0f, 1.0f);
+  if (n == 1)
+  {
+    // no edge or interior points, keep the ranges valid (and empty) for callers that walk them
+    m_edgeStart = {{3, 3, 3}};
+    m_interiorStart = 3;
+    addTriangle(0, 1, 2);
+  }
+  else
+  {
+    auto corner = [](int _c, float _weight, float _rest)
+    {
+      std::array<float, 3> b = {{_rest, _rest, _rest}};
+      b[_c] = _weight;
+      return b;
+    };
+    // outer edges, edge e runs from corner (e+1)%3 to corner (e+2)%3
+    for (int e = 0; e < 3; ++e)
+    {
+      m_edgeStart[e] = static_cast<uint32_t>(m_u.size());
+      auto a = corner((e + 1) % 3, 1.0f, 0.0f);
+      auto b = corner((e + 2) % 3, 1.0f, 0.0f);
+      for (int k = 1; k < o[e]; ++k)
+      {
+        float t = static_cast<float>(k) / o[e];
+        addVertex(a[0] + (b[0] - a[0]) * t, a[1] + (b[1] - a[1]) * t, a[2] + (b[2] - a[2]) * t);
+      }
+    }
+    m_interiorStart = static_cast<uint32_t>(m_u.size());
+    // side s runs corner s -> corner s+1 so it is outer edge (s+2)%3
+    std::array<std::vector<uint32_t>, 3> outerSides;
+    for (int s = 0; s < 3; ++s)
+    {
+      int e = (s + 2) % 3;
+      outerSides[s].push_back(s);
+      for (int k = 0; k < o[e] - 1; ++k)
+      {
+        outerSides[s].push_back(m_edgeStart[e] + k);
+      }
+      outerSides[s].push_back((s + 1) % 3);
+    }
+    int ringSegments = n;
+    for (int r = 1; n - 2 * r >= 0; ++r)
+    {
+      const int m = n - 2 * r;
+      std::array<std::vector<uint32_t>, 3> innerSides;
+      if (m == 0)
+      {
+        uint32_t centre = addVertex(1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f);
+        innerSides[0] = innerSides[1] = innerSides[2] = {centre};
+      }
+      else
+      {
+        // the ring corners sit where the perpendiculars through the points r/n along each side meet
+        float weight = 1.0f - 4.0f * r / (3.0f * n);
+        float rest = 2.0f * r / (3.0f * n);
+        std::array<uint32_t, 3> ringCorner;
+        for (int s = 0; s < 3; ++s)
+        {
+          auto a = corner(s, weight, rest);
+          auto b = corner((s + 1) % 3, weight, rest);
+          ringCorner[s] = addVertex(a[0], a[1], a[2]);
+          innerSides[s].push_back(ringCorner[s]);
+          for (int k = 1; k < m; ++k)
+          {
+            float t = static_cast<float>(k) / m;
+            innerSides[s].push_back(addVertex(a[0] + (b[0] - a[0]) * t, a[1] + (b[1] - a[1]) * t, a[2] + (b[2] - a[2]) * t));
+          }
+        }
+        for (int s = 0; s < 3; ++s)
+        {
+          innerSides[s].push_back(ringCorner[(s + 1) % 3]);
+        }
+      }
+      for (int s = 0; s < 3; ++s)
+      {
+        stitch(outerSides[s], innerSides[s], ringSegments);
+      }
+      if (m == 1)
+      {
+        addTriangle(innerSides[0][0], innerSides[1][0], innerSides[2][0]);
+      }
+      outerSides = std::move(innerSides);
+      ringSegments = m;
+    }
+  }
+  m_numVertices = m_u.size();
+  // pad with a valid point so the SIMD tail never normalizes a zero vector
+  while (m_u.size() % 4)
+  {
+    m_u.push_back(1.0f);
+    m_v.push_back(0.0f);
+    m_w.push_back(0.0f);
+  }
+}
+
+uint32_t TessPattern::addVertex(float _u, float _v, float _w)
+{
+  m_u.push_back(_u);
+  m_v.push_back(_v);
+  m_w.push_back(_w);
+  return static_cast<uint32_t>(m_u.size() - 1);
+}
+
+void TessPattern::addTriangle(uint32_t _a, uint32_t _b, uint32_t _c)
+{
+  // embed the domain in 2D (u corner at the origin) and make every triangle wind like the patch itself
+  auto x = [this](uint32_t _i) { return m_v[_i] + 0.5f * m_w[_i]; };
+  auto y = [this](uint32_t _i) { return m_w[_i]; };
+  float area = (x(_b) - x(_a)) * (y(_c) - y(_a)) - (x(_c) - x(_a)) * (y(_b) - y(_a));
+  if (area < 0.0f)
+  {
+    std::swap(_b, _c);
+  }
+  m_indices.push_back(_a);
+  m_indices.push_back(_b);
+  m_indices.push_back(_c);
+}
+
+void TessPattern::stitch(const std::vector<uint32_t> &_outer, const std::vector<uint32_t> &_inner, int _ringSegments)
+{
+  // _outer has p segments spanning the whole side, _inner has q segments spanning [1/N, (N-1)/N] of it where
+  // N is the nominal segment count of the outer ring. Advance whichever side has the nearer next midpoint.
+  const int p = static_cast<int>(_outer.size()) - 1;
+  const int q = static_cast<int>(_inner.size()) - 1;
+  const int N = _ringSegments;
+  int i = 0;
+  int j = 0;
+  while (i < p || j < q)
+  {
+    if (j == q || (i < p && (2 * i + 1) * N < (2 * j + 3) * p))
+    {
+      addTriangle(_outer[i], _outer[i + 1], _inner[j]);
+      ++i;
+    }
+    else
+    {
+      addTriangle(_outer[i], _inner[j + 1], _inner[j]);
+      ++j;
+    }
+  }
+}
+
+namespace
+{
+  // u*p0 + v*p1 + w*p2 for every point of the pattern, normalized onto the unit sphere when Project is set
+  template <bool Project>
+  void evaluatePatch(const TessPattern &_pattern, const float *_p0, const float *_p1, const float *_p2, float *o_xyz)
+  {
+    const size_t nv = _pattern.numVertices();
+    const float *u = _pattern.u().data();
+    const float *v = _pattern.v().data();
+    const float *w = _pattern.w().data();
+    size_t i = 0;
+#ifdef TESS_USE_SSE
+    const __m128 p0x = _mm_set1_ps(_p0[0]), p0y = _mm_set1_ps(_p0[1]), p0z = _mm_set1_ps(_p0[2]);
+    const __m128 p1x = _mm_set1_ps(_p1[0]), p1y = _mm_set1_ps(_p1[1]), p1z = _mm_set1_ps(_p1[2]);
+    const __m128 p2x = _mm_set1_ps(_p2[0]), p2y = _mm_set1_ps(_p2[1]), p2z = _mm_set1_ps(_p2[2]);
+    const __m128 one = _mm_set1_ps(1.0f);
+    // the pattern arrays are padded to a multiple of 4 so full loads are always safe
+    for (; i < nv; i += 4)
+    {
+      __m128 bu = _mm_loadu_ps(u + i);
+      __m128 bv = _mm_loadu_ps(v + i);
+      __m128 bw = _mm_loadu_ps(w + i);
+      __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bu, p0x), _mm_mul_ps(bv, p1x)), _mm_mul_ps(bw, p2x));
+      __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bu, p0y), _mm_mul_ps(bv, p1y)), _mm_mul_ps(bw, p2y));
+      __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bu, p0z), _mm_mul_ps(bv, p1z)), _mm_mul_ps(bw, p2z));
+      if (Project)
+      {
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len2));
+        x = _mm_mul_ps(x, inv);
+        y = _mm_mul_ps(y, inv);
+        z = _mm_mul_ps(z, inv);
+      }
+      __m128 pad = _mm_setzero_ps();
+      _MM_TRANSPOSE4_PS(x, y, z, pad);
+      // rows are now xyz0 for each point, write 3 floats of each and only the points that exist
+      const __m128 rows[4] = {x, y, z, pad};
+      const size_t count = std::min<size_t>(4, nv - i);
+      for (size_t r = 0; r < count; ++r)
+      {
+        float *out = o_xyz + (i + r) * 3;
+        _mm_storel_pi(reinterpret_cast<__m64 *>(out), rows[r]);
+        _mm_store_ss(out + 2, _mm_movehl_ps(rows[r], rows[r]));
+      }
+    }
+#endif
+    for (; i < nv; ++i)
+    {
+      float x = u[i] * _p0[0] + v[i] * _p1[0] + w[i] * _p2[0];
+      float y = u[i] * _p0[1] + v[i] * _p1[1] + w[i] * _p2[1];
+      float z = u[i] * _p0[2] + v[i] * _p1[2] + w[i] * _p2[2];
+      float inv = Project ? 1.0f / std::sqrt(x * x + y * y + z * z) : 1.0f;
+      o_xyz[i * 3 + 0] = x * inv;
+      o_xyz[i * 3 + 1] = y * inv;
+      o_xyz[i * 3 + 2] = z * inv;
+    }
+  }
+} // end anonymous namespace
+
+void evaluateSpherePatch(const TessPattern &_pattern, const float *_p0, const float *_p1, const float *_p2, float *o_xyz)
+{
+  evaluatePatch<true>(_pattern, _p0, _p1, _p2, o_xyz);
+}
+
+void evaluateLinearPatch(const TessPattern &_pattern, const float *_p0, const float *_p1, const float *_p2, float *o_xyz)
+{
+  evaluatePatch<false>(_pattern, _p0, _p1, _p2, o_xyz);
+}
+
+const TessPattern &CPUTessellator::pattern(const TessLevels &_levels)
+{
+  IntLevels key = roundLevels(_levels);
+  auto it = m_patterns.find(key);
+  if (it == m_patterns.end())
+  {
+    it = m_patterns.emplace(key, std::make_unique<TessPattern>(_levels)).first;
+  }
+  return *it->second;
+}
+
+} // end namespace tess
@@ -0,0 +1,117 @@
+#include "FrameStats.h"
+
+void FrameStats::init()
+{
+  for (auto &slot : m_slots)
+  {
+    glGenQueries(1, &slot.time);
+    glGenQueries(1, &slot.primitives);
+  }
+}
+
+void FrameStats::release()
+{
+  for (auto &slot : m_slots)
+  {
+    glDeleteQueries(1, &slot.time);
+    glDeleteQueries(1, &slot.primitives);
+    slot = Slot();
+  }
+}
+
+void FrameStats::begin(size_t _tag)
+{
+  ++m_frame;
+  Slot &slot = m_slots[m_next];
+  // still waiting on this one, skip the frame rather than stall
+  if (slot.pending)
+  {
+    m_active = false;
+    return;
+  }
+  slot.tag = _tag;
+  slot.frame = m_frame;
+  glBeginQuery(GL_TIME_ELAPSED, slot.time);
+  glBeginQuery(GL_PRIMITIVES_GENERATED, slot.primitives);
+  m_active = true;
+}
+
+void FrameStats::end()
+{
+  if (!m_active)
+  {
+    return;
+  }
+  glEndQuery(GL_PRIMITIVES_GENERATED);
+  glEndQuery(GL_TIME_ELAPSED);
+  m_slots[m_next].pending = true;
+  m_next = (m_next + 1) % Latency;
+  m_active = false;
+}
+
+void FrameStats::collect()
+{
+  // the slots complete in submission order so start at the oldest and stop at the first one not ready
+  for (size_t i = 0; i < Latency; ++i)
+  {
+    Slot &slot = m_slots[(m_next + i) % Latency];
+    if (!slot.pending)
+    {
+      continue;
+    }
+    GLint available = 0;
+    glGetQueryObjectiv(slot.primitives, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available)
+    {
+      glGetQueryObjectiv(slot.time, GL_QUERY_RESULT_AVAILABLE, &available);
+    }
+    if (!available)
+    {
+      break;
+    }
+    GLuint64 ns = 0;
+    GLuint64 primitives = 0;
+    glGetQueryObjectui64v(slot.time, GL_QUERY_RESULT, &ns);
+    glGetQueryObjectui64v(slot.primitives, GL_QUERY_RESULT, &primitives);
+    m_gpuMS = ns / 1.0e6f;
+    m_gpuMSByTag[slot.tag % MaxTags] = m_gpuMS;
+    m_gpuSum += m_gpuMS;
+    ++m_gpuFrames;
+    m_gpuSumByTag[slot.tag % MaxTags] += m_gpuMS;
+    ++m_gpuFramesByTag[slot.tag % MaxTags];
+    m_primitives = primitives;
+    m_primitivesByTag[slot.tag % MaxTags] = primitives;
+    ++m_framesCollected;
+    slot.pending = false;
+  }
+}
+
+void FrameStats::setCPUTime(float _ms)
+{
+  m_cpuMS = _ms;
+  m_cpuSum += _ms;
+  ++m_cpuFrames;
+  auto now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<float, std::milli>(now - m_lastShown).count() < ShowIntervalMS)
+  {
+    return;
+  }
+  m_shownCPUMS = static_cast<float>(m_cpuSum / m_cpuFrames);
+  if (m_gpuFrames > 0)
+  {
+    m_shownGPUMS = static_cast<float>(m_gpuSum / m_gpuFrames);
+  }
+  for (size_t tag = 0; tag < MaxTags; ++tag)
+  {
+    if (m_gpuFramesByTag[tag] > 0)
+    {
+      m_shownGPUMSByTag[tag] = static_cast<float>(m_gpuSumByTag[tag] / m_gpuFramesByTag[tag]);
+    }
+  }
+  m_cpuSum = m_gpuSum = 0.0;
+  m_cpuFrames = m_gpuFrames = 0;
+  m_gpuSumByTag.fill(0.0);
+  m_gpuFramesByTag.fill(0);
+  m_lastShown = now;
+  ++m_shownUpdates;
+}
@@ -0,0 +1,77 @@
+#include "GeodesicLOD.h"
+#include "CPUTessellator.h"
+#include "Icosahedron.h"
+#include <algorithm>
+#include <chrono>
+
+GeodesicLOD::GeodesicLOD(int _maxLevel)
+{
+  auto start = std::chrono::steady_clock::now();
+  _maxLevel = std::min(tess::MaxTessLevel, std::max(1, _maxLevel));
+  tess::CPUTessellator tessellator;
+  tess::TessMesh mesh;
+  // position then patch coordinate, the same values the evaluation stage outputs
+  std::vector<float> verts;
+  std::vector<uint32_t> indices;
+  for (int level = 1; level <= _maxLevel; ++level)
+  {
+    tess::TessLevels levels;
+    levels.inner = static_cast<float>(level);
+    levels.outer = {{levels.inner, levels.inner, levels.inner}};
+    tessellator.tessellate(tess::IcosahedronVerts.data(), tess::IcosahedronFaces.data(), tess::IcosahedronPatchCount,
+                           levels, mesh, true);
+    Level l;
+    l.firstIndex = indices.size();
+    l.indexCount = static_cast<GLsizei>(mesh.indices.size());
+    l.baseVertex = static_cast<GLint>(verts.size() / 6);
+    m_levels.push_back(l);
+    for (size_t i = 0; i < mesh.numVertices(); ++i)
+    {
+      verts.insert(verts.end(), &mesh.positions[i * 3], &mesh.positions[i * 3] + 3);
+      verts.insert(verts.end(), &mesh.patchCoords[i * 3], &mesh.patchCoords[i * 3] + 3);
+    }
+    indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+  }
+
+  glGenVertexArrays(1, &m_vao);
+  glBindVertexArray(m_vao);
+  glGenBuffers(1, &m_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(float), verts.data(), GL_STATIC_DRAW);
+  glGenBuffers(1, &m_ibo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), nullptr);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), reinterpret_cast<void *>(3 * sizeof(float)));
+  glBindVertexArray(0);
+  m_bytes = verts.size() * sizeof(float) + indices.size() * sizeof(uint32_t);
+  m_buildMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+GeodesicLOD::~GeodesicLOD()
+{
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteBuffers(1, &m_ibo);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+int GeodesicLOD::clampLevel(int _level) const
+{
+  return std::min(maxLevel(), std::max(1, _level));
+}
+
+size_t GeodesicLOD::numTriangles(int _level) const
+{
+  return m_levels[clampLevel(_level) - 1].indexCount / 3;
+}
+
+void GeodesicLOD::draw(int _level) const
+{
+  const Level &l = m_levels[clampLevel(_level) - 1];
+  glBindVertexArray(m_vao);
+  glDrawElementsBaseVertex(GL_TRIANGLES, l.indexCount, GL_UNSIGNED_INT,
+                           reinterpret_cast<void *>(l.firstIndex * sizeof(uint32_t)), l.baseVertex);
+  glBindVertexArray(0);
+}
@@ -0,0 +1,122 @@
+#include "GpuTrace.h"
+
+void GpuTrace::init()
+{
+  // without the zones compiled in nothing would ever read the queries, begin() and collect() see no zones
+  if (!tess::Trace::compiledIn())
+  {
+    return;
+  }
+  m_zones.resize(MaxZones);
+  for (auto &zone : m_zones)
+  {
+    glGenQueries(1, &zone.start);
+    glGenQueries(1, &zone.end);
+  }
+  m_track = tess::Trace::createTrack("GPU");
+  calibrate();
+}
+
+void GpuTrace::release()
+{
+  for (auto &zone : m_zones)
+  {
+    glDeleteQueries(1, &zone.start);
+    glDeleteQueries(1, &zone.end);
+  }
+  m_zones.clear();
+  m_oldest = 0;
+  m_used = 0;
+  m_open.clear();
+}
+
+void GpuTrace::calibrate()
+{
+  GLint64 gpu = 0;
+  glGetInteger64v(GL_TIMESTAMP, &gpu);
+  m_offset = static_cast<int64_t>(tess::Trace::now()) - gpu;
+  m_framesSinceCalibrate = 0;
+}
+
+void GpuTrace::begin(const char *_name)
+{
+  if (m_zones.empty() || !tess::Trace::active() || m_used == m_zones.size())
+  {
+    if (!m_zones.empty() && tess::Trace::active())
+    {
+      // the GPU is MaxZones behind, leave this one out rather than wait
+      ++m_skipped;
+    }
+    m_open.push_back(NoZone);
+    return;
+  }
+  const size_t index = (m_oldest + m_used++) % m_zones.size();
+  Zone &zone = m_zones[index];
+  zone.name = _name;
+  zone.submitNS = tess::Trace::now();
+  zone.frame = tess::Trace::frame();
+  zone.open = true;
+  glQueryCounter(zone.start, GL_TIMESTAMP);
+  m_open.push_back(index);
+}
+
+void GpuTrace::end()
+{
+  if (m_open.empty())
+  {
+    return;
+  }
+  const size_t index = m_open.back();
+  m_open.pop_back();
+  if (index != NoZone)
+  {
+    glQueryCounter(m_zones[index].end, GL_TIMESTAMP);
+    m_zones[index].open = false;
+  }
+}
+
+void GpuTrace::collect()
+{
+  if (m_zones.empty())
+  {
+    return;
+  }
+  if (tess::Trace::active() && ++m_framesSinceCalibrate >= CalibrateFrames)
+  {
+    calibrate();
+  }
+  // zones are in submission order, the end timestamp of a zone being ready means its start is too
+  while (m_used > 0)
+  {
+    Zone &zone = m_zones[m_oldest];
+    if (zone.open)
+    {
+      break;
+    }
+    GLint available = 0;
+    glGetQueryObjectiv(zone.end, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+      break;
+    }
+    GLuint64 start = 0;
+    GLuint64 end = 0;
+    glGetQueryObjectui64v(zone.start, GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(zone.end, GL_QUERY_RESULT, &end);
+    const int64_t traceStart = static_cast<int64_t>(start) + m_offset;
+    const int64_t traceEnd = static_cast<int64_t>(end) + m_offset;
+    if (traceStart >= 0 && traceEnd >= traceStart)
+    {
+      tess::Trace::recordOnTrack(m_track, zone.name, static_cast<uint64_t>(traceStart), static_cast<uint64_t>(traceEnd),
+                                 zone.frame, zone.submitNS);
+    }
+    m_oldest = (m_oldest + 1) % m_zones.size();
+    --m_used;
+  }
+}
+
+void GpuTrace::finish()
+{
+  glFinish();
+  collect();
+}
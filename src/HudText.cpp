@@ -0,0 +1,198 @@
+#include "HudText.h"
+#include "TessTrace.h"
+#include <ngl/ShaderLib.h>
+#include <QFont>
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QPainter>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+HudText::Atlas HudText::buildAtlas(const std::string &_font, int _pixelSize)
+{
+  TESS_TRACE_ZONE("HudText::buildAtlas");
+  auto start = std::chrono::steady_clock::now();
+  Atlas result;
+  QFont font;
+  int id = QFontDatabase::addApplicationFont(QString::fromStdString(_font));
+  if (id >= 0 && !QFontDatabase::applicationFontFamilies(id).isEmpty())
+  {
+    font.setFamily(QFontDatabase::applicationFontFamilies(id).first());
+  }
+  else
+  {
+    std::cerr << "Unable to load font " << _font << " using the default font\n";
+  }
+  font.setPixelSize(_pixelSize);
+  QFontMetrics metrics(font);
+  int maxAdvance = 0;
+  for (char c = FirstGlyph; c <= LastGlyph; ++c)
+  {
+    maxAdvance = std::max(maxAdvance, metrics.horizontalAdvance(QChar(c)));
+  }
+  // a pixel of padding each side so glyphs with a negative bearing are not clipped
+  const int cellWidth = maxAdvance + 2;
+  const int cellHeight = metrics.height();
+  const int columns = 16;
+  const int rows = (static_cast<int>(result.glyphs.size()) + columns - 1) / columns;
+  QImage atlas(columns * cellWidth, rows * cellHeight, QImage::Format_RGBA8888);
+  atlas.fill(Qt::transparent);
+  QPainter painter(&atlas);
+  painter.setFont(font);
+  painter.setPen(Qt::white);
+  for (size_t i = 0; i < result.glyphs.size(); ++i)
+  {
+    char c = static_cast<char>(FirstGlyph + i);
+    int x = static_cast<int>(i % columns) * cellWidth;
+    int y = static_cast<int>(i / columns) * cellHeight;
+    painter.drawText(x + 1, y + metrics.ascent(), QString(QChar(c)));
+    Glyph &g = result.glyphs[i];
+    g.u0 = static_cast<float>(x) / atlas.width();
+    g.v0 = static_cast<float>(y) / atlas.height();
+    g.u1 = static_cast<float>(x + cellWidth) / atlas.width();
+    g.v1 = static_cast<float>(y + cellHeight) / atlas.height();
+    g.advance = static_cast<float>(metrics.horizontalAdvance(QChar(c)));
+  }
+  painter.end();
+  result.image = atlas;
+  result.cellWidth = static_cast<float>(cellWidth);
+  result.lineHeight = static_cast<float>(cellHeight);
+  result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+ProgramRequest HudText::programRequest()
+{
+  return {"HudText",
+          {{"HudTextVertex", ngl::ShaderType::VERTEX, ProgramCache::readFile("shaders/hudvert.glsl")},
+           {"HudTextFragment", ngl::ShaderType::FRAGMENT, ProgramCache::readFile("shaders/hudfrag.glsl")}},
+          "",
+          {},
+          {}};
+}
+
+HudText::HudText(const Atlas &_atlas)
+    : m_glyphs(_atlas.glyphs), m_cellWidth(_atlas.cellWidth), m_lineHeight(_atlas.lineHeight)
+{
+  const QImage &atlas = _atlas.image;
+  glGenTextures(1, &m_texture);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlas.width(), atlas.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas.constBits());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  // x,y,u,v per vertex
+  glGenVertexArrays(1, &m_vao);
+  glBindVertexArray(m_vao);
+  glGenBuffers(1, &m_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<void *>(2 * sizeof(float)));
+  glBindVertexArray(0);
+}
+
+HudText::~HudText()
+{
+  glDeleteTextures(1, &m_texture);
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void HudText::setScreenSize(int _w, int _h)
+{
+  m_width = std::max(1, _w);
+  m_height = std::max(1, _h);
+}
+
+void HudText::setColour(float _r, float _g, float _b)
+{
+  m_colour = {{_r, _g, _b}};
+}
+
+void HudText::setLine(size_t _line, const std::string &_text)
+{
+  if (_line >= m_lines.size())
+  {
+    m_lines.resize(_line + 1);
+  }
+  if (m_lines[_line] != _text)
+  {
+    m_lines[_line] = _text;
+    m_dirty = true;
+  }
+}
+
+void HudText::rebuild()
+{
+  std::vector<float> verts;
+  for (size_t line = 0; line < m_lines.size(); ++line)
+  {
+    float x = 10.0f;
+    float y = 10.0f + line * m_lineHeight;
+    for (char c : m_lines[line])
+    {
+      if (c < FirstGlyph || c > LastGlyph)
+      {
+        continue;
+      }
+      const Glyph &g = m_glyphs[c - FirstGlyph];
+      float x0 = x - 1.0f;
+      float x1 = x0 + m_cellWidth;
+      float y0 = y;
+      float y1 = y + m_lineHeight;
+      const float quad[] = {x0, y0, g.u0, g.v0, x1, y0, g.u1, g.v0, x1, y1, g.u1, g.v1,
+                            x0, y0, g.u0, g.v0, x1, y1, g.u1, g.v1, x0, y1, g.u0, g.v1};
+      verts.insert(verts.end(), std::begin(quad), std::end(quad));
+      x += g.advance;
+    }
+  }
+  m_numVerts = static_cast<GLsizei>(verts.size() / 4);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(float), verts.data(), GL_DYNAMIC_DRAW);
+  m_dirty = false;
+  ++m_rebuilds;
+}
+
+void HudText::draw()
+{
+  TESS_TRACE_ZONE("HudText::draw");
+  if (m_dirty)
+  {
+    rebuild();
+  }
+  if (m_numVerts == 0)
+  {
+    return;
+  }
+  GLboolean depth = glIsEnabled(GL_DEPTH_TEST);
+  GLboolean blend = glIsEnabled(GL_BLEND);
+  GLint polygonMode[2];
+  glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  ngl::ShaderLib::use("HudText");
+  ngl::ShaderLib::setUniform("ScreenSize", static_cast<float>(m_width), static_cast<float>(m_height));
+  ngl::ShaderLib::setUniform("Colour", m_colour[0], m_colour[1], m_colour[2]);
+  ngl::ShaderLib::setUniform("Atlas", 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  glBindVertexArray(m_vao);
+  glDrawArrays(GL_TRIANGLES, 0, m_numVerts);
+  glBindVertexArray(0);
+  glPolygonMode(GL_FRONT_AND_BACK, static_cast<GLenum>(polygonMode[0]));
+  if (depth)
+  {
+    glEnable(GL_DEPTH_TEST);
+  }
+  if (!blend)
+  {
+    glDisable(GL_BLEND);
+  }
+}
@@ -0,0 +1,235 @@
+#include "InputRecorder.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+
+namespace
+{
+  const char *typeName(InputEvent::Type _type)
+  {
+    switch (_type)
+    {
+    case InputEvent::Type::MousePress:
+      return "press";
+    case InputEvent::Type::MouseRelease:
+      return "release";
+    case InputEvent::Type::MouseMove:
+      return "move";
+    case InputEvent::Type::Wheel:
+      return "wheel";
+    case InputEvent::Type::Key:
+      return "key";
+    }
+    return "key";
+  }
+
+  bool typeFromName(const std::string &_name, InputEvent::Type &o_type)
+  {
+    for (auto type : {InputEvent::Type::MousePress, InputEvent::Type::MouseRelease, InputEvent::Type::MouseMove,
+                      InputEvent::Type::Wheel, InputEvent::Type::Key})
+    {
+      if (_name == typeName(type))
+      {
+        o_type = type;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // mean and 95th percentile
+  void frameTimes(std::vector<float> _ms, float &o_mean, float &o_p95)
+  {
+    o_mean = 0.0f;
+    o_p95 = 0.0f;
+    if (_ms.empty())
+    {
+      return;
+    }
+    o_mean = std::accumulate(_ms.begin(), _ms.end(), 0.0f) / _ms.size();
+    std::sort(_ms.begin(), _ms.end());
+    o_p95 = _ms[static_cast<size_t>(std::ceil(0.95 * _ms.size())) - 1];
+  }
+} // end anonymous namespace
+
+InputRecorder::~InputRecorder()
+{
+  if (m_file.is_open())
+  {
+    m_file << m_frame << ' ' << std::fixed << std::setprecision(3) << msSinceOpen() << " end\n";
+  }
+}
+
+bool InputRecorder::open(const std::string &_fname, const InputSession &_session)
+{
+  m_file.open(_fname);
+  if (!m_file)
+  {
+    std::cerr << "Unable to write " << _fname << '\n';
+    return false;
+  }
+  m_file << "tessinput 1\nsize " << _session.width << ' ' << _session.height << "\nlevel " << _session.innerLevel << ' '
+         << _session.outerLevel << '\n';
+  m_start = std::chrono::steady_clock::now();
+  m_frame = 0;
+  m_events = 0;
+  return true;
+}
+
+double InputRecorder::msSinceOpen() const
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+void InputRecorder::record(InputEvent _event)
+{
+  if (!m_file.is_open())
+  {
+    return;
+  }
+  _event.frame = m_frame;
+  _event.ms = msSinceOpen();
+  m_file << _event.frame << ' ' << std::fixed << std::setprecision(3) << _event.ms << ' ' << typeName(_event.type);
+  // positions are doubles in Qt 6, keep all of them so the replay moves by exactly the same amounts
+  m_file << std::defaultfloat << std::setprecision(17);
+  switch (_event.type)
+  {
+  case InputEvent::Type::MousePress:
+  case InputEvent::Type::MouseRelease:
+  case InputEvent::Type::MouseMove:
+    m_file << ' ' << _event.x << ' ' << _event.y << ' ' << _event.buttons;
+    break;
+  case InputEvent::Type::Wheel:
+    m_file << ' ' << _event.deltaX << ' ' << _event.deltaY;
+    break;
+  case InputEvent::Type::Key:
+    m_file << ' ' << _event.key;
+    break;
+  }
+  m_file << '\n';
+  ++m_events;
+}
+
+bool InputReplay::load(const std::string &_fname)
+{
+  std::ifstream in(_fname);
+  if (!in)
+  {
+    std::cerr << "Unable to open " << _fname << '\n';
+    return false;
+  }
+  std::string magic;
+  int version = 0;
+  std::string sizeTag;
+  std::string levelTag;
+  in >> magic >> version >> sizeTag >> m_session.width >> m_session.height >> levelTag >> m_session.innerLevel >>
+      m_session.outerLevel;
+  if (!in || magic != "tessinput" || version != 1 || sizeTag != "size" || levelTag != "level")
+  {
+    std::cerr << _fname << " is not a tessinput 1 file\n";
+    return false;
+  }
+  m_events.clear();
+  bool ended = false;
+  std::string line;
+  size_t lineNumber = 3;
+  std::getline(in, line);
+  while (std::getline(in, line))
+  {
+    ++lineNumber;
+    if (line.empty())
+    {
+      continue;
+    }
+    std::istringstream fields(line);
+    InputEvent event;
+    std::string name;
+    fields >> event.frame >> event.ms >> name;
+    if (fields && name == "end")
+    {
+      m_endFrame = event.frame;
+      ended = true;
+      break;
+    }
+    if (!fields || !typeFromName(name, event.type))
+    {
+      std::cerr << _fname << ':' << lineNumber << " unknown event " << line << '\n';
+      return false;
+    }
+    if (event.type == InputEvent::Type::Wheel)
+    {
+      fields >> event.deltaX >> event.deltaY;
+    }
+    else if (event.type == InputEvent::Type::Key)
+    {
+      fields >> event.key;
+    }
+    else
+    {
+      fields >> event.x >> event.y >> event.buttons;
+    }
+    if (!fields || (!m_events.empty() && event.frame < m_events.back().frame))
+    {
+      std::cerr << _fname << ':' << lineNumber << " bad event " << line << '\n';
+      return false;
+    }
+    m_events.push_back(event);
+  }
+  if (!ended)
+  {
+    // the recording didn't close cleanly, play up to the last event
+    m_endFrame = m_events.empty() ? 0 : m_events.back().frame;
+  }
+  m_next = 0;
+  m_frame = 0;
+  m_cpuMS.clear();
+  m_gpuMS.clear();
+  return true;
+}
+
+std::vector<InputEvent> InputReplay::due() const
+{
+  std::vector<InputEvent> events;
+  for (size_t i = m_next; i < m_events.size() && m_events[i].frame <= m_frame; ++i)
+  {
+    events.push_back(m_events[i]);
+  }
+  return events;
+}
+
+void InputReplay::endFrame(float _cpuMS, float _gpuMS)
+{
+  if (m_frame == 0)
+  {
+    m_start = std::chrono::steady_clock::now();
+  }
+  while (m_next < m_events.size() && m_events[m_next].frame <= m_frame)
+  {
+    ++m_next;
+  }
+  m_cpuMS.push_back(_cpuMS);
+  if (_gpuMS >= 0.0f)
+  {
+    m_gpuMS.push_back(_gpuMS);
+  }
+  ++m_frame;
+}
+
+std::string InputReplay::summary() const
+{
+  float cpuMean;
+  float cpuP95;
+  float gpuMean;
+  float gpuP95;
+  frameTimes(m_cpuMS, cpuMean, cpuP95);
+  frameTimes(m_gpuMS, gpuMean, gpuP95);
+  const double wallMS = m_frame > 1 ? std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count() : 0.0;
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3) << "Replayed " << m_events.size() << " events over " << m_frame << " frames in "
+      << wallMS << " ms\n  CPU ms mean " << cpuMean << " p95 " << cpuP95 << "\n  GPU ms mean " << gpuMean << " p95 " << gpuP95
+      << " (" << m_gpuMS.size() << " frames measured)\n";
+  return out.str();
+}
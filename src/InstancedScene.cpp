@@ -0,0 +1,140 @@
+#include "InstancedScene.h"
+#include "PatchMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+bool InstancedScene::supported()
+{
+  GLint major = 0;
+  GLint minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  return major > 4 || (major == 4 && minor >= 3);
+}
+
+InstancedScene::InstancedScene(size_t _instances, float _spacing) : m_numInstances(std::max<size_t>(1, _instances))
+{
+  // every LOD in one vertex / index buffer, each command draws its own range
+  std::vector<float> verts;
+  std::vector<uint16_t> indices;
+  for (int lod = 0; lod < LODCount; ++lod)
+  {
+    tess::TrianglePatchMesh mesh;
+    tess::makeIcosphere(LODCount - 1 - lod, mesh);
+    tess::reorderPatches(mesh);
+    DrawCommand &command = m_commands[lod];
+    command.count = static_cast<GLuint>(mesh.patchIndices.size());
+    command.firstIndex = static_cast<GLuint>(indices.size());
+    command.baseVertex = static_cast<GLint>(verts.size() / 3);
+    // each LOD has room for every instance in the visible list
+    command.baseInstance = static_cast<GLuint>(lod * m_numInstances);
+    verts.insert(verts.end(), mesh.positions.begin(), mesh.positions.end());
+    indices.insert(indices.end(), mesh.patchIndices.begin(), mesh.patchIndices.end());
+  }
+
+  std::vector<InstanceData> instances(m_numInstances);
+  const size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(m_numInstances))));
+  const float origin = -0.5f * _spacing * (side - 1);
+  // fixed seed so every run (and every benchmark) sees the same field
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> scale(0.4f, 1.0f);
+  std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+  for (size_t i = 0; i < m_numInstances; ++i)
+  {
+    InstanceData &instance = instances[i];
+    const float s = scale(rng);
+    const float a = angle(rng);
+    const float x = origin + _spacing * (i % side);
+    const float z = origin + _spacing * (i / side);
+    // uniform scale and a rotation about y, column major
+    std::fill(std::begin(instance.model), std::end(instance.model), 0.0f);
+    instance.model[0] = s * std::cos(a);
+    instance.model[2] = -s * std::sin(a);
+    instance.model[5] = s;
+    instance.model[8] = s * std::sin(a);
+    instance.model[10] = s * std::cos(a);
+    instance.model[12] = x;
+    instance.model[13] = 0.0f;
+    instance.model[14] = z;
+    instance.model[15] = 1.0f;
+    instance.sphere[0] = x;
+    instance.sphere[1] = 0.0f;
+    instance.sphere[2] = z;
+    instance.sphere[3] = s;
+  }
+
+  glGenVertexArrays(1, &m_vao);
+  glBindVertexArray(m_vao);
+  glGenBuffers(1, &m_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(float), verts.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+  glGenBuffers(1, &m_ibo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+  // the visible list is written by the cull pass and read as a per instance attribute, so each command's
+  // baseInstance selects where its instances start
+  const size_t visibleBytes = LODCount * m_numInstances * sizeof(GLuint);
+  glGenBuffers(1, &m_visibleBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_visibleBuffer);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(visibleBytes), nullptr, GL_DYNAMIC_COPY);
+  glEnableVertexAttribArray(1);
+  glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+  glVertexAttribDivisor(1, 1);
+  glBindVertexArray(0);
+
+  glGenBuffers(1, &m_instanceBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(instances.size() * sizeof(InstanceData)), instances.data(), GL_STATIC_DRAW);
+  glGenBuffers(1, &m_commandBuffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(m_commands), m_commands.data(), GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  m_bytes = verts.size() * sizeof(float) + indices.size() * sizeof(uint16_t) + visibleBytes +
+            instances.size() * sizeof(InstanceData) + sizeof(m_commands);
+}
+
+InstancedScene::~InstancedScene()
+{
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteBuffers(1, &m_ibo);
+  glDeleteBuffers(1, &m_visibleBuffer);
+  glDeleteBuffers(1, &m_instanceBuffer);
+  glDeleteBuffers(1, &m_commandBuffer);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void InstancedScene::setCullProgram(GLuint _program)
+{
+  m_instanceCountLocation = glGetUniformLocation(_program, "InstanceCount");
+  m_lodDistanceLocation = glGetUniformLocation(_program, "LODDistance");
+}
+
+void InstancedScene::cull(float _lodDistance)
+{
+  // m_commands always has instanceCount 0, writing it back is the per frame reset
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(m_commands), m_commands.data());
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  glUniform1ui(m_instanceCountLocation, static_cast<GLuint>(m_numInstances));
+  glUniform1f(m_lodDistanceLocation, _lodDistance);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, InstanceBufferBinding, m_instanceBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VisibleBufferBinding, m_visibleBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CommandBufferBinding, m_commandBuffer);
+  glDispatchCompute(static_cast<GLuint>((m_numInstances + 63) / 64), 1, 1);
+  // the commands are read by the draw and the visible list as a vertex attribute
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void InstancedScene::draw() const
+{
+  glBindVertexArray(m_vao);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, InstanceBufferBinding, m_instanceBuffer);
+  glMultiDrawElementsIndirect(GL_PATCHES, GL_UNSIGNED_SHORT, nullptr, LODCount, 0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+}
@@ -0,0 +1,209 @@
+#include "MeshStreamer.h"
+#include "TessTrace.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+MeshStreamer::~MeshStreamer()
+{
+  release();
+}
+
+void MeshStreamer::release()
+{
+  for (auto &fence : m_fences)
+  {
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+  if (m_mapped)
+  {
+    glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    m_mapped = nullptr;
+  }
+  glDeleteBuffers(1, &m_staging);
+  glDeleteTextures(1, &m_hintTexture);
+  glDeleteBuffers(1, &m_hintBuffer);
+  glDeleteBuffers(1, &m_ibo);
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteVertexArrays(1, &m_vao);
+  m_staging = m_hintTexture = m_hintBuffer = m_ibo = m_vbo = m_vao = 0;
+  m_file.close();
+}
+
+bool MeshStreamer::open(const std::string &_fname)
+{
+  release();
+  m_openTime = std::chrono::steady_clock::now();
+  if (!m_file.open(_fname))
+  {
+    return false;
+  }
+  m_numPatches = m_file.numPatches();
+  m_numVertices = m_file.numVertices();
+  m_hasHints = m_file.hasHints();
+  m_indexType = m_file.indexSize() == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+  m_block = m_vertexBytes = m_indexBytes = m_hintBytes = 0;
+  m_residentPatches = m_bytesUploaded = m_stalls = 0;
+  m_firstBlockMS = m_loadMS = 0.0f;
+  const size_t vertexBytes = m_numVertices * 3 * sizeof(float);
+  const size_t indexBytes = m_numPatches * 3 * m_file.indexSize();
+  const size_t hintBytes = m_hasHints ? m_numPatches * sizeof(float) : 0;
+  m_totalBytes = vertexBytes + indexBytes + hintBytes;
+
+  // the destinations are only ever written by glCopyBufferSubData
+  glGenVertexArrays(1, &m_vao);
+  glBindVertexArray(m_vao);
+  glGenBuffers(1, &m_vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertexBytes), nullptr, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+  glGenBuffers(1, &m_ibo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indexBytes), nullptr, GL_STATIC_DRAW);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  if (m_hasHints)
+  {
+    glGenBuffers(1, &m_hintBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_hintBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(hintBytes), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glGenTextures(1, &m_hintTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_hintTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, m_hintBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+  }
+
+  const GLsizeiptr stagingBytes = static_cast<GLsizeiptr>(ChunkBytes * Slots);
+  GLint major = 0;
+  GLint minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  glGenBuffers(1, &m_staging);
+  glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+  if (major > 4 || (major == 4 && minor >= 4))
+  {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_COPY_READ_BUFFER, stagingBytes, nullptr, flags);
+    m_mapped = static_cast<uint8_t *>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, stagingBytes, flags));
+  }
+  if (!m_mapped)
+  {
+    glBufferData(GL_COPY_READ_BUFFER, stagingBytes, nullptr, GL_STREAM_DRAW);
+  }
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  return true;
+}
+
+bool MeshStreamer::acquireSlot()
+{
+  GLsync &fence = m_fences[m_slot];
+  if (!fence)
+  {
+    return true;
+  }
+  // never wait, the rest of the mesh can come next frame
+  if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+  {
+    ++m_stalls;
+    return false;
+  }
+  glDeleteSync(fence);
+  fence = nullptr;
+  return true;
+}
+
+bool MeshStreamer::upload(GLuint _buffer, const uint8_t *_src, size_t &io_done, size_t _end, size_t &io_chunks, size_t _maxChunks)
+{
+  while (io_done < _end)
+  {
+    if (io_chunks >= _maxChunks || !acquireSlot())
+    {
+      return false;
+    }
+    const size_t bytes = std::min(ChunkBytes, _end - io_done);
+    const GLintptr offset = static_cast<GLintptr>(m_slot * ChunkBytes);
+    // reading the mapping is what pages this part of the file in
+    glBindBuffer(GL_COPY_READ_BUFFER, m_staging);
+    if (m_mapped)
+    {
+      std::memcpy(m_mapped + offset, _src + io_done, bytes);
+    }
+    else
+    {
+      glBufferSubData(GL_COPY_READ_BUFFER, offset, static_cast<GLsizeiptr>(bytes), _src + io_done);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, static_cast<GLintptr>(io_done),
+                        static_cast<GLsizeiptr>(bytes));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    m_fences[m_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_slot = (m_slot + 1) % Slots;
+    io_done += bytes;
+    m_bytesUploaded += bytes;
+    ++io_chunks;
+  }
+  return true;
+}
+
+size_t MeshStreamer::update(size_t _maxChunks)
+{
+  TESS_TRACE_ZONE("MeshStreamer::update");
+  size_t chunks = 0;
+  if (!m_file.isOpen())
+  {
+    return chunks;
+  }
+  const size_t indexSize = m_file.indexSize();
+  while (m_block < m_file.numBlocks())
+  {
+    // a block is drawable once everything its patches read is resident
+    const size_t patchEnd = m_file.blockPatchEnd(m_block);
+    const bool resident =
+        upload(m_vbo, m_file.positions(), m_vertexBytes, m_file.blockVertexEnd(m_block) * 3 * sizeof(float), chunks, _maxChunks) &&
+        upload(m_ibo, m_file.indices(), m_indexBytes, patchEnd * 3 * indexSize, chunks, _maxChunks) &&
+        (!m_hasHints || upload(m_hintBuffer, m_file.hints(), m_hintBytes, patchEnd * sizeof(float), chunks, _maxChunks));
+    if (!resident)
+    {
+      break;
+    }
+    if (m_residentPatches == 0)
+    {
+      m_firstBlockMS = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_openTime).count();
+    }
+    m_residentPatches = patchEnd;
+    ++m_block;
+  }
+  if (m_block == m_file.numBlocks())
+  {
+    // the last copies are queued ahead of any draw that reads them, the staging slots are left to their fences
+    m_loadMS = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_openTime).count();
+    m_file.close();
+    std::cout << "Streamed " << m_numPatches << " patches (" << m_bytesUploaded / (1024 * 1024) << " MB) in " << m_loadMS
+              << " ms, first block after " << m_firstBlockMS << " ms, " << m_stalls << " staging stalls\n";
+  }
+  return chunks;
+}
+
+void MeshStreamer::draw() const
+{
+  if (m_residentPatches == 0)
+  {
+    return;
+  }
+  glBindVertexArray(m_vao);
+  glDrawElements(GL_PATCHES, static_cast<GLsizei>(m_residentPatches * 3), m_indexType, nullptr);
+  glBindVertexArray(0);
+}
+
+void MeshStreamer::bindHints(GLuint _unit) const
+{
+  glActiveTexture(GL_TEXTURE0 + _unit);
+  glBindTexture(GL_TEXTURE_BUFFER, m_hintTexture);
+  glActiveTexture(GL_TEXTURE0);
+}
@@ -2,11 +2,16 @@
 #include <QGuiApplication>
 
 #include "NGLScene.h"
+#include "AdaptiveTess.h"
+#include "PatchCulling.h"
+#include "SoftRasterizer.h"
+#include "TessTrace.h"
+#include "TessUniforms.h"
 #include <ngl/NGLInit.h>
-#include <ngl/VAOFactory.h>
-#include <ngl/SimpleIndexVAO.h>
 #include <ngl/ShaderLib.h>
-#include <QFont>
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -18,8 +23,36 @@ const static float INCREMENT = 0.01f;
 //----------------------------------------------------------------------------------------------------------------------
 const static float ZOOM = 0.1f;
 
-NGLScene::NGLScene()
+NGLScene::NGLScene(const AppOptions &_options, std::unique_ptr<InputReplay> _replay) : m_replay(std::move(_replay))
 {
+  m_startTime = std::chrono::steady_clock::now();
+  // the glyphs need no context, draw them while the window and context are created
+  m_hudAtlas = std::async(std::launch::async, []
+                          {
+                            TESS_TRACE_THREAD("HUD atlas");
+                            return HudText::buildAtlas("fonts/Arial.ttf", 16);
+                          });
+  m_pipeline = _options.pipeline;
+  m_programCache = _options.programCache;
+  m_patchMeshSettings = _options.patchMesh;
+  m_meshFile = _options.meshFile;
+  m_lodLevels = _options.lodLevels;
+  m_levelController.setBudget(_options.budgetMS);
+  m_patchFile = _options.patchFile;
+  m_captureFile = _options.captureFile;
+  m_screenshotFile = _options.screenshotFile;
+  m_startInnerLevel = _options.level;
+  m_startOuterLevel = _options.level;
+  m_numInstances = _options.instances;
+  m_terrainFile = _options.terrainFile;
+  m_traceFile = _options.traceFile;
+  m_recordFile = _options.recordFile;
+  if (m_replay)
+  {
+    // a replay starts from the levels the recording did, which needn't be equal
+    m_startInnerLevel = m_replay->session().innerLevel;
+    m_startOuterLevel = m_replay->session().outerLevel;
+  }
   // re-size the widget to that of the parent (in this case the GLFrame passed in on construction)
   m_rotate = false;
   // mouse rotation values set to 0
@@ -31,6 +64,30 @@ NGLScene::NGLScene()
 NGLScene::~NGLScene()
 {
   std::cout << "Shutting down NGL, removing VAO's and Shaders\n";
+  makeCurrent();
+  if (!m_traceFile.empty() && tess::Trace::compiledIn())
+  {
+    // the last few frames are still on the GPU
+    m_gpuTrace.finish();
+    tess::Trace::stop();
+    if (tess::Trace::write(m_traceFile))
+    {
+      std::cout << "Wrote " << tess::Trace::events() << " trace events to " << m_traceFile << " (" << tess::Trace::dropped()
+                << " dropped, " << m_gpuTrace.skipped() << " GPU zones skipped)\n";
+    }
+  }
+  m_gpuTrace.release();
+  m_stats.release();
+  m_hud.reset();
+  m_lod.reset();
+  m_bezierVAO.reset();
+  m_capture.reset();
+  m_instanced.reset();
+  m_terrain.reset();
+  m_streamer.reset();
+  m_uniforms.reset();
+  m_variants.reset();
+  doneCurrent();
 }
 
 void NGLScene::resizeGL(int _w, int _h)
@@ -38,16 +95,37 @@ void NGLScene::resizeGL(int _w, int _h)
   m_project = ngl::perspective(45.0f, (float)width() / height(), 0.05f, 350.0f);
   m_width = _w * devicePixelRatio();
   m_height = _h * devicePixelRatio();
+  if (m_hud)
+  {
+    m_hud->setScreenSize(m_width, m_height);
+  }
 }
 
 void NGLScene::initializeGL()
 {
+  TESS_TRACE_ZONE("NGLScene::initializeGL");
+  auto initStart = std::chrono::steady_clock::now();
+  m_contextMS = std::chrono::duration<double, std::milli>(initStart - m_startTime).count();
   ngl::NGLInit::initialize();
   std::cerr << "OpenGL Version : " << glGetString(GL_VERSION) << std::endl;
 
-  m_text = std::make_unique<ngl::Text>("fonts/Arial.ttf", 16);
-  m_text->setColour(1, 1, 1);
-  m_text->setScreenSize(width(), height());
+  // hand every program to the driver first so they compile while the meshes below are built, with
+  // KHR_parallel_shader_compile they all compile at once on the driver's threads
+  m_startupPrograms = std::make_unique<ProgramBatch>(m_programCache);
+  for (auto pipeline : {TessPipeline::NoGeometryShader, TessPipeline::GeometryShader})
+  {
+    m_startupPrograms->add(tessProgramRequest(pipeline, m_patchMeshSettings.positions));
+  }
+  m_startupPrograms->add(lodProgramRequest());
+  m_startupPrograms->add(bezierProgramRequest());
+  m_startupPrograms->add(captureProgramRequest(m_patchMeshSettings.positions));
+  m_startupPrograms->add(HudText::programRequest());
+  if (InstancedScene::supported())
+  {
+    m_startupPrograms->add(instancedProgramRequest());
+    m_startupPrograms->add(instanceCullProgramRequest());
+  }
+  m_startupPrograms->add(terrainProgramRequest());
 
   glClearColor(0.4f, 0.4f, 0.4f, 1.0f); // Grey Background
   // enable depth testing for drawing
@@ -64,71 +142,191 @@ void NGLScene::initializeGL()
   // The final two are near and far clipping planes of 0.5 and 10
   m_project = ngl::perspective(50, 720.0f / 576.0f, 0.05f, 350);
 
-  ngl::ShaderLib::createShaderProgram("Tess");
-  // now we are going to create empty shaders for Frag and Vert
-  ngl::ShaderLib::attachShader("TessVertex", ngl::ShaderType::VERTEX);
-  ngl::ShaderLib::attachShader("TessFragment", ngl::ShaderType::FRAGMENT);
-  ngl::ShaderLib::attachShader("TessGeom", ngl::ShaderType::GEOMETRY);
-  ngl::ShaderLib::attachShader("TessControl", ngl::ShaderType::TESSCONTROL);
-  ngl::ShaderLib::attachShader("TessEval", ngl::ShaderType::TESSEVAL);
-  // attach the source
-  ngl::ShaderLib::loadShaderSource("TessVertex", "shaders/tessvert.glsl");
-  ngl::ShaderLib::loadShaderSource("TessFragment", "shaders/tessfrag.glsl");
-  ngl::ShaderLib::loadShaderSource("TessGeom", "shaders/tessgeom.glsl");
-  ngl::ShaderLib::loadShaderSource("TessControl", "shaders/tesscontrol.glsl");
-  ngl::ShaderLib::loadShaderSource("TessEval", "shaders/tesseval.glsl");
-  // add them to the program
-  ngl::ShaderLib::attachShaderToProgram("Tess", "TessVertex");
-  ngl::ShaderLib::attachShaderToProgram("Tess", "TessFragment");
-  ngl::ShaderLib::attachShaderToProgram("Tess", "TessGeom");
-  ngl::ShaderLib::attachShaderToProgram("Tess", "TessEval");
-  ngl::ShaderLib::attachShaderToProgram("Tess", "TessControl");
-
-  // compile the shaders
-  ngl::ShaderLib::compileShader("TessVertex");
-  ngl::ShaderLib::compileShader("TessFragment");
-  ngl::ShaderLib::compileShader("TessGeom");
-  ngl::ShaderLib::compileShader("TessEval");
-  ngl::ShaderLib::compileShader("TessControl");
-
-  // now we have associated this data we can link the shader
-  ngl::ShaderLib::linkProgramObject("Tess");
-  ngl::ShaderLib::use("Tess");
-  ngl::ShaderLib::autoRegisterUniforms("Tess");
-  ngl::ShaderLib::printRegisteredUniforms("Tess");
-  ngl::ShaderLib::setUniform("AmbientMaterial", 0.1f, 0.1f, 0.1f);
-  ngl::ShaderLib::setUniform("DiffuseMaterial", 0.8f, 0.0f, 0.0f);
-  ngl::ShaderLib::setUniform("LightPosition", 1.0f, 1.0f, 1.0f);
-  // glPatchParameteri(GL_PATCH_VERTICES, 16);
-  createIcosahedron();
-  m_innerLevel = 1.0;
-  m_outerLevel = 1.0;
+  // the other spacing / winding / point mode permutations are only built when first picked
+  m_variants = std::make_unique<TessVariantTable>(m_programCache, m_patchMeshSettings.positions);
+  std::cout << "Tess variants build " << (m_variants->parallelCompile() ? "on the driver's compiler threads" : "in the background of later frames") << '\n';
+  createPatchMesh();
+  if (!m_meshFile.empty())
+  {
+    // only maps the file, the upload happens a few chunks at a time in paintGL
+    m_streamer = std::make_unique<MeshStreamer>();
+    if (m_streamer->open(m_meshFile))
+    {
+      std::cout << "Streaming " << m_meshFile << ' ' << m_streamer->numPatches() << " patches "
+                << m_streamer->numVertices() << " vertices (" << m_streamer->totalBytes() / (1024 * 1024) << " MB) through "
+                << (m_streamer->persistent() ? "a persistently mapped" : "a glBufferSubData") << " staging ring\n";
+    }
+    else
+    {
+      std::cerr << "Drawing the sphere instead of " << m_meshFile << '\n';
+      m_streamer.reset();
+    }
+  }
+  // every patch at the highest levels is the most a capture can produce, within reason for the subdivided meshes
+  tess::TessLevels maxLevels;
+  maxLevels.inner = static_cast<float>(tess::MaxTessLevel);
+  maxLevels.outer.fill(maxLevels.inner);
+  m_capture = std::make_unique<TessCapture>(std::min(tess::expectedTriangleCount(maxLevels) * m_patchMesh.numPatches(), MaxCaptureTriangles));
+  loadBezierPatches();
+  if (InstancedScene::supported())
+  {
+    m_instanced = std::make_unique<InstancedScene>(static_cast<size_t>(m_numInstances));
+    std::cout << "Instanced field of " << m_instanced->numInstances() << " spheres (" << m_instanced->bytes() / 1024
+              << " KB)\n";
+  }
+  else
+  {
+    std::cout << "GL 4.3 is needed for the instanced mode\n";
+  }
+  m_lod = std::make_unique<GeodesicLOD>(m_lodLevels);
+  std::cout << "Pre tessellated " << m_lod->maxLevel() << " levels (" << m_lod->bytes() / (1024 * 1024) << " MB) in "
+            << m_lod->buildMS() << " ms\n";
+  m_uniforms = std::make_unique<UniformRing>(UniformRingFrameBytes);
+  std::cout << "Uniform blocks " << (m_uniforms->persistent() ? "persistently mapped" : "updated with glBufferSubData") << '\n';
+  m_stats.init();
+  m_gpuTrace.init();
+  m_innerLevel = m_startInnerLevel;
+  m_outerLevel = m_startOuterLevel;
+  m_initMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - initStart).count();
+}
+
+void NGLScene::createHud()
+{
+  if (m_hud || !m_hudAtlas.valid() || m_hudAtlas.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+  {
+    return;
+  }
+  TESS_TRACE_ZONE("NGLScene::createHud");
+  const HudText::Atlas atlas = m_hudAtlas.get();
+  m_hudAtlasMS = atlas.ms;
+  m_hud = std::make_unique<HudText>(atlas);
+  m_hud->setColour(1.0f, 1.0f, 1.0f);
+  m_hud->setScreenSize(width() * devicePixelRatio(), height() * devicePixelRatio());
+}
+
+void NGLScene::reportStartup()
+{
+  const double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime).count();
+  std::cout << "Time to first frame " << total << " ms\n"
+            << "  window and context  " << m_contextMS << " ms\n"
+            << "  initializeGL        " << m_initMS << " ms\n"
+            << "  programs            " << m_startupPrograms->ms() << " ms for " << m_startupPrograms->size() << " ("
+            << m_startupPrograms->cacheHits() << " from the cache, "
+            << (m_startupPrograms->parallelCompile() ? "parallel compile" : "no parallel compile") << ")\n"
+            << "  placeholder frames  " << m_placeholderFrames << '\n'
+            << "  font atlas          ";
+  if (m_hud)
+  {
+    std::cout << m_hudAtlasMS << " ms on a worker thread\n";
+  }
+  else
+  {
+    std::cout << "still building on a worker thread, the HUD follows in a later frame\n";
+  }
 }
 
 void NGLScene::loadMatricesToShader()
 {
+  TESS_TRACE_ZONE("NGLScene::loadMatricesToShader");
+  // one write per block, the programs read them through the bindings set up in bindTessUniformBlocks
+  FrameUniforms frame;
+  frame.tessLevelInner = m_innerLevel;
+  frame.tessLevelOuter = m_outerLevel;
+  frame.projectionScale = projectionScale();
+  frame.targetEdgePixels = m_targetEdgePixels;
+  frame.adaptive = m_adaptive ? 1 : 0;
+  frame.cullPatches = m_cullPatches ? 1 : 0;
+  frame.usePatchHints = m_streamer && m_streamer->hasHints() ? 1 : 0;
+  m_uniforms->writeAndBind(FrameBlockBinding, frame);
+
   ngl::Mat4 MV;
   ngl::Mat4 MVP;
-  ngl::Mat3 normalMatrix;
   ngl::Mat4 M;
-  M = m_mouseGlobalTX * m_transform.getMatrix();
-  MV = m_view * M;
+  if (m_terrainMode && m_terrain)
+  {
+    // the terrain has its own camera, the mouse turns it rather than the model
+    std::copy(m_terrain->view(), m_terrain->view() + 16, &MV.m_openGL[0]);
+  }
+  else
+  {
+    M = m_mouseGlobalTX * m_transform.getMatrix();
+    MV = m_view * M;
+  }
   MVP = m_project * MV;
-  normalMatrix = MV;
-  normalMatrix.inverse().transpose();
-  ngl::ShaderLib::setUniform("MVP", MVP);
-  ngl::ShaderLib::setUniform("TessLevelInner", m_innerLevel);
-  ngl::ShaderLib::setUniform("TessLevelOuter", m_outerLevel);
-  ngl::ShaderLib::setUniform("NormalMatrix", normalMatrix);
+  ObjectUniforms object;
+  setObjectUniforms(MV.m_openGL, MVP.m_openGL, object);
+  object.positionScale = m_encodedMesh.positionScale;
+  m_uniforms->writeAndBind(ObjectBlockBinding, object);
+  // run the same test as the control shader so we can see how much work was saved
+  m_culledPatches = 0;
+  if (m_cullPatches && !m_lodMode && !m_bezierMode && !m_instancedMode && !m_terrainMode && !m_streamer)
+  {
+    tess::CullParams params;
+    params.MVP = MVP.m_openGL;
+    params.eye[0] = object.eyePosition[0];
+    params.eye[1] = object.eyePosition[1];
+    params.eye[2] = object.eyePosition[2];
+    m_culledPatches = tess::countCulledPatches(m_patchMesh.positions.data(), m_patchMesh.patchIndices.data(),
+                                               m_patchMesh.numPatches(), params);
+  }
 }
 
 void NGLScene::paintGL()
 {
+  auto frameStart = std::chrono::steady_clock::now();
+  tess::Trace::nextFrame();
+  TESS_TRACE_ZONE("NGLScene::paintGL");
+  m_gpuTrace.collect();
+  TESS_TRACE_GPU_ZONE(m_gpuTrace, "frame");
+  createHud();
+  if (m_startupPrograms && !m_startupPrograms->poll())
+  {
+    // nothing can be drawn until the programs link, show the background and check again next frame
+    glViewport(0, 0, m_width, m_height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    ++m_placeholderFrames;
+    update();
+    return;
+  }
+  // recorded and replayed frames are counted from the first real one, the placeholders vary from run to run
+  if (m_startupPrograms)
+  {
+    if (m_instanced)
+    {
+      m_instanced->setCullProgram(ngl::ShaderLib::getProgramID(InstanceCullProgramName));
+    }
+    startInput();
+  }
+  if (m_replay)
+  {
+    for (const auto &event : m_replay->due())
+    {
+      input(event, true);
+    }
+  }
+  // pick up whatever GPU results have arrived since the last frame, never waits
+  m_stats.collect();
+  updateAutoLevels();
+  m_variants->poll();
+  m_uniforms->beginFrame();
+  if (m_streamer && !m_streamer->complete())
+  {
+    // the copies go ahead of this frame's draw, which shows every block that is now resident
+    TESS_TRACE_GPU_ZONE(m_gpuTrace, "stream upload");
+    m_streamer->update();
+    update();
+  }
   // clear the screen and depth buffer
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glViewport(0, 0, m_width, m_height);
   // grab an instance of the shader manager
-  ngl::ShaderLib::use("Tess");
+  if (m_terrainMode && !m_terrain)
+  {
+    createTerrain();
+  }
+  const bool instanced = m_instancedMode && m_instanced;
+  ngl::ShaderLib::use(m_terrainMode ? TerrainProgramName : m_bezierMode ? BezierProgramName : m_lodMode ? LODProgramName
+                                                         : instanced ? InstanceCullProgramName : tessProgramName(m_pipeline));
 
   // Rotation based on the mouse position for our global transform
   ngl::Mat4 rotX = ngl::Mat4::rotateX(m_spinXFace);
@@ -139,66 +337,391 @@ void NGLScene::paintGL()
   m_mouseGlobalTX.m_m[3][0] = m_modelPos.m_x;
   m_mouseGlobalTX.m_m[3][1] = m_modelPos.m_y;
   m_mouseGlobalTX.m_m[3][2] = m_modelPos.m_z;
+  if (m_terrainMode)
+  {
+    // the tiles that arrived are copied in ahead of the draw
+    TESS_TRACE_GPU_ZONE(m_gpuTrace, "terrain tiles");
+    m_terrain->update(static_cast<float>(m_spinYFace), static_cast<float>(m_spinXFace));
+  }
   // set this in the TX stack
   loadMatricesToShader();
-  m_vao->bind();
-  m_vao->draw();
-  m_vao->unbind();
-
-  m_text->setColour(1.0f, 1.0f, 1.0f);
-  m_text->renderText(10, 700, fmt::format("1 2 change inner tesselation level  current value {}", m_innerLevel));
-  m_text->renderText(10, 680, fmt::format("3 4 change outer tesselation level  current value {}", m_outerLevel));
-}
-
-void NGLScene::createIcosahedron()
-{
-  const static GLubyte Faces[] = {
-      2, 1, 0,
-      3, 2, 0,
-      4, 3, 0,
-      5, 4, 0,
-      1, 5, 0,
-
-      11, 6, 7,
-      11, 7, 8,
-      11, 8, 9,
-      11, 9, 10,
-      11, 10, 6,
-
-      1, 2, 6,
-      2, 3, 7,
-      3, 4, 8,
-      4, 5, 9,
-      5, 1, 10,
-
-      2, 7, 6,
-      3, 8, 7,
-      4, 9, 8,
-      5, 10, 9,
-      1, 6, 10};
-
-  float Verts[] = {
-      0.000f, 0.000f, 1.000f,
-      0.894f, 0.000f, 0.447f,
-      0.276f, 0.851f, 0.447f,
-      -0.724f, 0.526f, 0.447f,
-      -0.724f, -0.526f, 0.447f,
-      0.276f, -0.851f, 0.447f,
-      0.724f, 0.526f, -0.447f,
-      -0.276f, 0.851f, -0.447f,
-      -0.894f, 0.000f, -0.447f,
-      -0.276f, -0.851f, -0.447f,
-      0.724f, -0.526f, -0.447f,
-      0.000f, 0.000f, -1.000f};
-
-  auto IndexCount = sizeof(Faces) / sizeof(Faces[0]);
-  m_vao = ngl::VAOFactory::createVAO(ngl::simpleIndexVAO, GL_PATCHES);
-  m_vao->bind();
-  m_vao->setData(ngl::SimpleIndexVAO::VertexData(sizeof(Verts), Verts[0], sizeof(Faces), &Faces[0], GL_UNSIGNED_BYTE, GL_STATIC_DRAW));
-  m_vao->setVertexAttributePointer(0, 3, GL_FLOAT, 0, 0);
-  m_vao->setNumIndices(IndexCount);
-
-  m_vao->unbind();
+  if (!m_captureFile.empty())
+  {
+    captureFrame();
+  }
+  if (m_terrainMode)
+  {
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+    TESS_TRACE_GPU_ZONE(m_gpuTrace, "terrain");
+    m_stats.begin(TerrainStatsTag);
+    m_terrain->draw();
+    m_stats.end();
+  }
+  else if (m_bezierMode)
+  {
+    glPatchParameteri(GL_PATCH_VERTICES, 16);
+    TESS_TRACE_GPU_ZONE(m_gpuTrace, "Bezier patches");
+    m_stats.begin(BezierStatsTag);
+    m_bezierVAO->bind();
+    m_bezierVAO->draw();
+    m_bezierVAO->unbind();
+    m_stats.end();
+  }
+  else if (m_lodMode)
+  {
+    TESS_TRACE_GPU_ZONE(m_gpuTrace, "precomputed LOD");
+    m_stats.begin(LODStatsTag);
+    m_lod->draw(lodLevel());
+    m_stats.end();
+  }
+  else if (instanced)
+  {
+    // the cull pass and the draw are timed together, that is the cost of the whole field
+    TESS_TRACE_GPU_ZONE(m_gpuTrace, "instanced cull + draw");
+    m_stats.begin(InstancedStatsTag);
+    m_instanced->cull(InstanceLODDistance);
+    ngl::ShaderLib::use(InstancedProgramName);
+    m_instanced->draw();
+    m_stats.end();
+  }
+  else
+  {
+    useTessProgram();
+    TESS_TRACE_GPU_ZONE(m_gpuTrace, "tessellated sphere");
+    m_stats.begin(static_cast<size_t>(m_drawnVariant.pipeline));
+    if (m_streamer)
+    {
+      if (m_streamer->hasHints())
+      {
+        m_streamer->bindHints(PatchHintsTextureUnit);
+      }
+      m_streamer->draw();
+    }
+    else
+    {
+      m_vao->bind();
+      m_vao->draw();
+      m_vao->unbind();
+    }
+    m_stats.end();
+  }
+  // GL_PATCH_VERTICES is context state, the terrain and Bezier draws change it so put it back to 3 for everything
+  // else that draws triangle patches
+  glPatchParameteri(GL_PATCH_VERTICES, 3);
+
+  m_uniforms->endFrame();
+  if (!m_screenshotFile.empty())
+  {
+    saveScreenshot();
+  }
+
+  if (m_hud)
+  {
+    TESS_TRACE_GPU_ZONE(m_gpuTrace, "HUD");
+    updateHud();
+    m_hud->draw();
+  }
+  else
+  {
+    // pick the atlas up as soon as the worker is done
+    update();
+  }
+  if (m_startupPrograms)
+  {
+    reportStartup();
+    m_startupPrograms.reset();
+  }
+  m_stats.setCPUTime(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+  endInputFrame();
+  // the controller needs a steady stream of frames to measure, and the terrain camera keeps flying
+  if (m_autoLevels || m_terrainMode)
+  {
+    update();
+  }
+}
+
+void NGLScene::useTessProgram()
+{
+  TessVariant wanted = m_variant;
+  wanted.pipeline = m_pipeline;
+  wanted = wanted.normalized();
+  if (wanted.isDefault() || m_variants->program(wanted) != 0)
+  {
+    m_drawnVariant = wanted;
+  }
+  else if (!m_variants->failed(wanted))
+  {
+    // keep frames coming so the switch happens as soon as the build is done
+    update();
+  }
+  if (m_drawnVariant.isDefault())
+  {
+    ngl::ShaderLib::use(tessProgramName(m_drawnVariant.pipeline));
+  }
+  else
+  {
+    glUseProgram(m_variants->program(m_drawnVariant));
+  }
+}
+
+void NGLScene::createTerrain()
+{
+  // the Terrain program has linked by the time any frame is drawn, so its uniforms can be set straight away
+  m_terrain = std::make_unique<TerrainScene>(m_terrainFile);
+  m_terrain->setProgramUniforms(ngl::ShaderLib::getProgramID(TerrainProgramName));
+  std::cout << "Terrain " << m_terrain->info().tilesX << " x " << m_terrain->info().tilesZ << " tiles "
+            << (m_terrain->procedural() ? "generated" : "streamed from " + m_terrainFile) << ", "
+            << TerrainScene::PoolLayers << " tile pool (" << m_terrain->bytes() / 1024 << " KB)\n";
+}
+
+void NGLScene::loadBezierPatches()
+{
+  if (m_patchFile.empty() || !tess::loadBezierPatches(m_patchFile, m_bezierPatches))
+  {
+    tess::makeWaveGrid(8, 8, 2.0f, m_bezierPatches);
+  }
+  std::cout << "Bezier cage " << m_bezierPatches.numPatches() << " patches " << m_bezierPatches.numControlPoints()
+            << " control points\n";
+  m_bezierVAO = createBezierVAO(m_bezierPatches);
+}
+
+void NGLScene::updateBezierReference()
+{
+  // CPU evaluation only handles every level equal, so use the larger as GeodesicLOD does
+  int level = lodLevel();
+  if (level == m_bezierReferenceLevel)
+  {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  tess::tessellateBezierPatches(m_bezierPatches, level, m_bezierReference);
+  m_bezierReferenceMS = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+  m_bezierReferenceLevel = level;
+}
+
+void NGLScene::captureFrame()
+{
+  TESS_TRACE_ZONE("NGLScene::captureFrame");
+  std::string fname;
+  std::swap(fname, m_captureFile);
+  if (m_bezierMode || m_lodMode || m_instancedMode || m_terrainMode || m_streamer)
+  {
+    std::cerr << "Capture only records the tessellated sphere, turn off the Bezier / LOD / instanced / terrain modes and --mesh\n";
+    return;
+  }
+  // the capture program reads the same uniform blocks as the one we are about to draw with
+  auto program = ngl::ShaderLib::getCurrentShaderName();
+  ngl::ShaderLib::use(CaptureProgramName);
+  auto result = m_capture->capture(*m_vao, expectedTriangles(), fname);
+  ngl::ShaderLib::use(program);
+  std::cout << "Captured " << result.primitives << " triangles to " << fname << " in " << result.ms << " ms, expected "
+            << result.expected << (result.overflow ? " (buffer overflow)" : "") << (result.valid() ? " OK\n" : " MISMATCH\n");
+}
+
+void NGLScene::saveScreenshot()
+{
+  TESS_TRACE_ZONE("NGLScene::saveScreenshot");
+  std::string fname;
+  std::swap(fname, m_screenshotFile);
+  tess::RasterImage image;
+  image.resize(m_width, m_height);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, defaultFramebufferObject());
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, image.rgb.data());
+  // GL rows are bottom up, PPM top down
+  const size_t rowBytes = static_cast<size_t>(m_width) * 3;
+  for (int y = 0; y < m_height / 2; ++y)
+  {
+    std::swap_ranges(image.rgb.begin() + y * rowBytes, image.rgb.begin() + (y + 1) * rowBytes,
+                     image.rgb.begin() + (m_height - 1 - y) * rowBytes);
+  }
+  if (tess::writePPM(fname, image))
+  {
+    std::cout << "Saved " << m_width << 'x' << m_height << " screenshot to " << fname << '\n';
+  }
+}
+
+size_t NGLScene::expectedTriangles()
+{
+  ngl::Mat4 MV = m_view * m_mouseGlobalTX * m_transform.getMatrix();
+  ngl::Mat4 MVP = m_project * MV;
+  ObjectUniforms object;
+  setObjectUniforms(MV.m_openGL, MVP.m_openGL, object);
+  tess::CullParams cull;
+  cull.MVP = MVP.m_openGL;
+  std::copy(object.eyePosition, object.eyePosition + 3, cull.eye);
+  tess::ScreenSpaceParams screen;
+  screen.modelView = MV.m_openGL;
+  screen.projectionScale = projectionScale();
+  screen.targetEdgePixels = m_targetEdgePixels;
+  tess::TessLevels levels;
+  levels.inner = m_innerLevel;
+  levels.outer.fill(m_outerLevel);
+  size_t count = 0;
+  for (size_t patch = 0; patch < m_patchMesh.numPatches(); ++patch)
+  {
+    const float *p0 = &m_patchMesh.positions[m_patchMesh.patchIndices[patch * 3 + 0] * 3];
+    const float *p1 = &m_patchMesh.positions[m_patchMesh.patchIndices[patch * 3 + 1] * 3];
+    const float *p2 = &m_patchMesh.positions[m_patchMesh.patchIndices[patch * 3 + 2] * 3];
+    if (m_cullPatches && tess::patchCulled(p0, p1, p2, cull))
+    {
+      continue;
+    }
+    count += tess::expectedTriangleCount(m_adaptive ? tess::adaptivePatchLevels(p0, p1, p2, screen) : levels);
+  }
+  return count;
+}
+
+void NGLScene::updateAutoLevels()
+{
+  if (!m_autoLevels || m_stats.framesCollected() == m_controllerFrames)
+  {
+    return;
+  }
+  m_controllerFrames = m_stats.framesCollected();
+  if (m_levelController.update(m_stats.gpuMS()))
+  {
+    m_innerLevel = m_outerLevel = m_levelController.level();
+  }
+}
+
+void NGLScene::setAutoLevels(bool _on)
+{
+  m_autoLevels = _on;
+  if (m_autoLevels)
+  {
+    // start from what is on screen now
+    m_levelController.setLevel(std::max(m_innerLevel, m_outerLevel));
+    m_innerLevel = m_outerLevel = m_levelController.level();
+    m_controllerFrames = m_stats.framesCollected();
+  }
+}
+
+void NGLScene::updateHud()
+{
+  TESS_TRACE_ZONE("NGLScene::updateHud");
+  // lines only cause a rebuild of the text geometry when their text actually changes, so every time shown is a
+  // mean republished on FrameStats' cadence rather than this frame's value
+  if (m_stats.shownUpdates() != m_hudTimesUpdate)
+  {
+    m_hudTimesUpdate = m_stats.shownUpdates();
+    m_hudControllerMS = m_levelController.averageMS();
+    m_hudTerrainLoadMS = m_terrain ? m_terrain->averageLoadMS() : 0.0f;
+  }
+  m_hud->setLine(0, fmt::format("1 2 change inner tesselation level  current value {}", m_innerLevel));
+  m_hud->setLine(1, fmt::format("3 4 change outer tesselation level  current value {}", m_outerLevel));
+  if (m_adaptive && m_streamer)
+  {
+    m_hud->setLine(2, fmt::format("A adaptive on  5 6 change target edge pixels {}", m_targetEdgePixels));
+  }
+  else if (m_adaptive)
+  {
+    // estimate on the CPU what the adaptive control shader will generate for this camera
+    ngl::Mat4 MV = m_view * m_mouseGlobalTX * m_transform.getMatrix();
+    tess::ScreenSpaceParams params;
+    params.modelView = MV.m_openGL;
+    params.projectionScale = projectionScale();
+    params.targetEdgePixels = m_targetEdgePixels;
+    auto triangles = tess::estimateAdaptiveTriangles(m_patchMesh.positions.data(), m_patchMesh.patchIndices.data(),
+                                                     m_patchMesh.numPatches(), params);
+    m_hud->setLine(2, fmt::format("A adaptive on  5 6 change target edge pixels {}  estimated triangles {}", m_targetEdgePixels, triangles));
+  }
+  else
+  {
+    m_hud->setLine(2, "A adaptive off");
+  }
+  m_hud->setLine(3, fmt::format("C patch culling {}  submitted {} culled {}", m_cullPatches ? "on" : "off",
+                                m_streamer ? m_streamer->residentPatches() : m_patchMesh.numPatches(), m_culledPatches));
+  m_hud->setLine(4, fmt::format("G pipeline {}  GPU time geometry shader {:.3f} ms  no geometry shader {:.3f} ms",
+                                m_pipeline == TessPipeline::GeometryShader ? "geometry shader" : "no geometry shader",
+                                m_stats.shownGPUMS(static_cast<size_t>(TessPipeline::GeometryShader)),
+                                m_stats.shownGPUMS(static_cast<size_t>(TessPipeline::NoGeometryShader))));
+  m_hud->setLine(5, fmt::format("CPU {:.2f} ms  GPU {:.3f} ms  primitives {}  uniform ring stalls {}", m_stats.shownCPUMS(),
+                                m_stats.shownGPUMS(), m_stats.primitives(), m_uniforms->stalls()));
+  m_hud->setLine(6, fmt::format("L precomputed LOD {}  level {} triangles {}  {} MB  GPU time {:.3f} ms", m_lodMode ? "on" : "off",
+                                lodLevel(), m_lod->numTriangles(lodLevel()), m_lod->bytes() / (1024 * 1024),
+                                m_stats.shownGPUMS(LODStatsTag)));
+  m_hud->setLine(7, fmt::format("T automatic levels {}  budget {} ms  average {:.2f} ms", m_autoLevels ? "on" : "off",
+                                m_levelController.params().budgetMS, m_hudControllerMS));
+  if (m_bezierMode)
+  {
+    updateBezierReference();
+    const auto &mesh = m_bezierReference;
+    size_t denseBytes = (mesh.positions.size() + mesh.normals.size()) * sizeof(float) + mesh.indices.size() * sizeof(uint32_t);
+    // GL_PRIMITIVES_GENERATED of the Bezier draw against what the quad domain should give at these levels
+    const size_t expected = tess::expectedQuadTriangleCount(m_innerLevel, m_outerLevel) * m_bezierPatches.numPatches();
+    m_hud->setLine(8, fmt::format("B Bezier patches on  {} patches  cage {} KB  CPU level {} {} triangles {} KB in {:.2f} ms  GPU {:.3f} ms {} triangles (expected {})",
+                                  m_bezierPatches.numPatches(), m_bezierPatches.bytes() / 1024, m_bezierReferenceLevel,
+                                  mesh.numTriangles(), denseBytes / 1024, m_bezierReferenceMS, m_stats.shownGPUMS(BezierStatsTag),
+                                  m_stats.primitives(BezierStatsTag), expected));
+  }
+  else
+  {
+    m_hud->setLine(8, "B Bezier patches off");
+  }
+  if (m_streamer)
+  {
+    const float MB = 1.0f / (1024 * 1024);
+    m_hud->setLine(9, m_streamer->complete()
+                          ? fmt::format("{} {} patches {} vertices  {:.1f} MB streamed in {:.0f} ms (first block {:.0f} ms)  hints {}",
+                                        m_meshFile, m_streamer->numPatches(), m_streamer->numVertices(), m_streamer->totalBytes() * MB,
+                                        m_streamer->loadMS(), m_streamer->firstBlockMS(), m_streamer->hasHints() ? "on" : "none")
+                          : fmt::format("{} streaming {} / {} patches  {:.1f} / {:.1f} MB  staging stalls {}", m_meshFile,
+                                        m_streamer->residentPatches(), m_streamer->numPatches(), m_streamer->bytesUploaded() * MB,
+                                        m_streamer->totalBytes() * MB, m_streamer->stalls()));
+  }
+  else
+  {
+    m_hud->setLine(9, fmt::format("sphere mesh {} patches {} vertices  {} positions {} indices {:.1f} KB  ACMR {:.2f}",
+                                  m_patchMesh.numPatches(), m_patchMesh.numVertices(),
+                                  tess::positionFormatName(m_encodedMesh.positionFormat),
+                                  tess::indexFormatName(m_encodedMesh.indexFormat), m_encodedMesh.bytes() / 1024.0f, m_patchACMR));
+  }
+  TessVariant wanted = m_variant;
+  wanted.pipeline = m_pipeline;
+  const bool building = wanted.normalized().key() != m_drawnVariant.key();
+  m_hud->setLine(11, fmt::format("V O M variant {}{}  {} built  last build {:.1f} ms", m_variant.name(),
+                                 building ? (m_variants->failed(wanted) ? "  (failed)" : "  (building)") : "",
+                                 m_variants->size(), m_variants->lastBuildMS()));
+  if (m_instanced)
+  {
+    m_hud->setLine(10, fmt::format("I instanced {}  {} spheres  patches near {} mid {} far {}  GPU cull + draw {:.3f} ms",
+                                   m_instancedMode ? "on" : "off", m_instanced->numInstances(), m_instanced->lodPatches(0),
+                                   m_instanced->lodPatches(1), m_instanced->lodPatches(2), m_stats.shownGPUMS(InstancedStatsTag)));
+  }
+  else
+  {
+    m_hud->setLine(10, "I instanced mode needs GL 4.3");
+  }
+  if (m_terrain)
+  {
+    m_hud->setLine(12, fmt::format("E terrain {}  tiles drawn {} resident {} / {} ({} KB)  queued {} loaded {} ({:.2f} ms) uploaded {}  patches {}  GPU {:.3f} ms",
+                                   m_terrainMode ? "on" : "off", m_terrain->drawnTiles(), m_terrain->residentTiles(),
+                                   TerrainScene::PoolLayers, m_terrain->bytes() / 1024, m_terrain->queuedTiles(),
+                                   m_terrain->tilesLoaded(), m_hudTerrainLoadMS, m_terrain->tilesUploaded(),
+                                   m_terrain->drawnPatches(), m_stats.shownGPUMS(TerrainStatsTag)));
+  }
+  else
+  {
+    m_hud->setLine(12, "E terrain off");
+  }
+}
+
+float NGLScene::projectionScale() const
+{
+  // converts a view space size over distance into pixels on screen
+  return m_project.m_m[1][1] * m_height * 0.5f;
+}
+
+void NGLScene::createPatchMesh()
+{
+  tess::buildPatchMesh(m_patchMeshSettings, m_patchMesh, m_encodedMesh);
+  m_patchACMR = tess::patchACMR(m_patchMesh);
+  m_vao = createPatchMeshVAO(m_encodedMesh);
+  std::cout << "Sphere control mesh " << m_patchMesh.numPatches() << " patches " << m_patchMesh.numVertices() << " vertices, "
+            << tess::positionFormatName(m_encodedMesh.positionFormat) << " positions "
+            << tess::indexFormatName(m_encodedMesh.indexFormat) << " indices " << m_encodedMesh.bytes() << " bytes, ACMR "
+            << m_patchACMR << ", largest position error " << tess::maxPositionError(m_patchMesh, m_encodedMesh) << '\n';
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -212,23 +735,33 @@ void NGLScene::mouseMoveEvent(QMouseEvent *_event)
 #else
   auto position = _event->pos();
 #endif
-  if (m_rotate && _event->buttons() == Qt::LeftButton)
+  InputEvent event;
+  event.type = InputEvent::Type::MouseMove;
+  event.x = position.x();
+  event.y = position.y();
+  event.buttons = static_cast<int>(_event->buttons());
+  input(event);
+}
+
+void NGLScene::applyMouseMove(const InputEvent &_event)
+{
+  if (m_rotate && _event.buttons == Qt::LeftButton)
   {
-    int diffx = position.x() - m_origX;
-    int diffy = position.y() - m_origY;
+    int diffx = _event.x - m_origX;
+    int diffy = _event.y - m_origY;
     m_spinXFace += (float)0.5f * diffy;
     m_spinYFace += (float)0.5f * diffx;
-    m_origX = position.x();
-    m_origY = position.y();
+    m_origX = _event.x;
+    m_origY = _event.y;
     update();
   }
   // right mouse translate code
-  else if (m_translate && _event->buttons() == Qt::RightButton)
+  else if (m_translate && _event.buttons == Qt::RightButton)
   {
-    int diffX = (int)(position.x() - m_origXPos);
-    int diffY = (int)(position.y() - m_origYPos);
-    m_origXPos = position.x();
-    m_origYPos = position.y();
+    int diffX = (int)(_event.x - m_origXPos);
+    int diffY = (int)(_event.y - m_origYPos);
+    m_origXPos = _event.x;
+    m_origYPos = _event.y;
     m_modelPos.m_x += INCREMENT * diffX;
     m_modelPos.m_y -= INCREMENT * diffY;
     update();
@@ -238,39 +771,57 @@ void NGLScene::mouseMoveEvent(QMouseEvent *_event)
 //----------------------------------------------------------------------------------------------------------------------
 void NGLScene::mousePressEvent(QMouseEvent *_event)
 {
-// this method is called when the mouse button is pressed in this case we
-// store the value where the maouse was clicked (x,y) and set the Rotate flag to true
 #if QT_VERSION > QT_VERSION_CHECK(6, 0, 0)
   auto position = _event->position();
 #else
   auto position = _event->pos();
 #endif
-  if (_event->button() == Qt::LeftButton)
+  InputEvent event;
+  event.type = InputEvent::Type::MousePress;
+  event.x = position.x();
+  event.y = position.y();
+  event.buttons = static_cast<int>(_event->button());
+  input(event);
+}
+
+void NGLScene::applyMousePress(const InputEvent &_event)
+{
+  // this method is called when the mouse button is pressed in this case we
+  // store the value where the maouse was clicked (x,y) and set the Rotate flag to true
+  if (_event.buttons == Qt::LeftButton)
   {
-    m_origX = position.x();
-    m_origY = position.y();
+    m_origX = _event.x;
+    m_origY = _event.y;
     m_rotate = true;
   }
   // right mouse translate mode
-  else if (_event->button() == Qt::RightButton)
+  else if (_event.buttons == Qt::RightButton)
   {
-    m_origXPos = position.x();
-    m_origYPos = position.y();
+    m_origXPos = _event.x;
+    m_origYPos = _event.y;
     m_translate = true;
   }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 void NGLScene::mouseReleaseEvent(QMouseEvent *_event)
+{
+  InputEvent event;
+  event.type = InputEvent::Type::MouseRelease;
+  event.buttons = static_cast<int>(_event->button());
+  input(event);
+}
+
+void NGLScene::applyMouseRelease(const InputEvent &_event)
 {
   // this event is called when the mouse button is released
   // we then set Rotate to false
-  if (_event->button() == Qt::LeftButton)
+  if (_event.buttons == Qt::LeftButton)
   {
     m_rotate = false;
   }
   // right mouse translate mode
-  if (_event->button() == Qt::RightButton)
+  if (_event.buttons == Qt::RightButton)
   {
     m_translate = false;
   }
@@ -279,13 +830,21 @@ void NGLScene::mouseReleaseEvent(QMouseEvent *_event)
 //----------------------------------------------------------------------------------------------------------------------
 void NGLScene::wheelEvent(QWheelEvent *_event)
 {
+  InputEvent event;
+  event.type = InputEvent::Type::Wheel;
+  event.deltaX = _event->angleDelta().x();
+  event.deltaY = _event->angleDelta().y();
+  input(event);
+}
 
+void NGLScene::applyWheel(const InputEvent &_event)
+{
   // check the diff of the wheel position (0 means no change)
-  if (_event->angleDelta().x() > 0)
+  if (_event.deltaX > 0)
   {
     m_modelPos.m_z += ZOOM;
   }
-  else if (_event->angleDelta().x() < 0)
+  else if (_event.deltaX < 0)
   {
     m_modelPos.m_z -= ZOOM;
   }
@@ -294,10 +853,18 @@ void NGLScene::wheelEvent(QWheelEvent *_event)
 //----------------------------------------------------------------------------------------------------------------------
 
 void NGLScene::keyPressEvent(QKeyEvent *_event)
+{
+  InputEvent event;
+  event.type = InputEvent::Type::Key;
+  event.key = _event->key();
+  input(event);
+}
+
+void NGLScene::applyKey(const InputEvent &_event)
 {
   // this method is called every time the main window recives a key event.
   // we then switch on the key value and set the camera in the GLWindow
-  switch (_event->key())
+  switch (_event.key)
   {
   // escape key to quite
   case Qt::Key_Escape:
@@ -319,20 +886,68 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
   case Qt::Key_N:
     showNormal();
     break;
+  // choosing a level by hand hands control back from the automatic levels
   case Qt::Key_1:
+    setAutoLevels(false);
     updateInnerTess(-1);
     break;
   case Qt::Key_2:
+    setAutoLevels(false);
     updateInnerTess(1);
     break;
 
   case Qt::Key_3:
+    setAutoLevels(false);
     updateOuterTess(-1);
     break;
   case Qt::Key_4:
+    setAutoLevels(false);
     updateOuterTess(1);
     break;
+  case Qt::Key_T:
+    setAutoLevels(!m_autoLevels);
+    break;
+  case Qt::Key_5:
+    updateTargetEdgePixels(-1);
+    break;
+  case Qt::Key_6:
+    updateTargetEdgePixels(1);
+    break;
+  case Qt::Key_A:
+    m_adaptive ^= true;
+    break;
+  case Qt::Key_C:
+    m_cullPatches ^= true;
+    break;
+  case Qt::Key_L:
+    m_lodMode ^= true;
+    break;
+  case Qt::Key_B:
+    m_bezierMode ^= true;
+    break;
+  case Qt::Key_I:
+    m_instancedMode ^= true;
+    break;
+  case Qt::Key_E:
+    m_terrainMode ^= true;
+    break;
+  case Qt::Key_P:
+    m_captureFile = fmt::format("capture_{}.ply", ++m_captureCount);
+    break;
+  case Qt::Key_V:
+    m_variant.spacing = static_cast<TessSpacing>((static_cast<int>(m_variant.spacing) + 1) % 3);
+    break;
+  case Qt::Key_O:
+    m_variant.winding = m_variant.winding == TessWinding::CW ? TessWinding::CCW : TessWinding::CW;
+    break;
+  case Qt::Key_M:
+    m_variant.primitive = m_variant.primitive == TessPrimitive::Triangles ? TessPrimitive::Points : TessPrimitive::Triangles;
+    break;
+  case Qt::Key_G:
+    m_pipeline = m_pipeline == TessPipeline::GeometryShader ? TessPipeline::NoGeometryShader : TessPipeline::GeometryShader;
+    break;
   case Qt::Key_Space:
+    setAutoLevels(false);
     reset();
     break;
 
@@ -344,6 +959,98 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
   update();
 }
 
+void NGLScene::input(const InputEvent &_event, bool _replayed)
+{
+  if (m_replay)
+  {
+    // live input would make it a different run, though Escape still quits. The Escape a recording usually ends
+    // with is dropped, the replay exits by itself once the summary is printed
+    const bool escape = _event.type == InputEvent::Type::Key && _event.key == Qt::Key_Escape;
+    if (_replayed ? escape : !escape)
+    {
+      return;
+    }
+  }
+  if (m_recorder)
+  {
+    m_recorder->record(_event);
+  }
+  switch (_event.type)
+  {
+  case InputEvent::Type::MousePress:
+    applyMousePress(_event);
+    break;
+  case InputEvent::Type::MouseRelease:
+    applyMouseRelease(_event);
+    break;
+  case InputEvent::Type::MouseMove:
+    applyMouseMove(_event);
+    break;
+  case InputEvent::Type::Wheel:
+    applyWheel(_event);
+    break;
+  case InputEvent::Type::Key:
+    applyKey(_event);
+    break;
+  }
+}
+
+void NGLScene::startInput()
+{
+  if (m_replay)
+  {
+    std::cout << "Replaying " << m_replay->events() << " events over " << m_replay->frames() << " frames\n";
+  }
+  else if (!m_recordFile.empty())
+  {
+    InputSession session;
+    session.width = width();
+    session.height = height();
+    session.innerLevel = m_innerLevel;
+    session.outerLevel = m_outerLevel;
+    m_recorder = std::make_unique<InputRecorder>();
+    if (m_recorder->open(m_recordFile, session))
+    {
+      std::cout << "Recording input to " << m_recordFile << '\n';
+    }
+    else
+    {
+      m_recorder.reset();
+    }
+  }
+}
+
+void NGLScene::endInputFrame()
+{
+  if (m_recorder)
+  {
+    m_recorder->endFrame();
+  }
+  if (!m_replay)
+  {
+    return;
+  }
+  // only count each GPU result once, they arrive a few frames late
+  const bool newGPU = m_stats.framesCollected() != m_replayGPUFrames;
+  m_replayGPUFrames = m_stats.framesCollected();
+  m_replay->endFrame(m_stats.cpuMS(), newGPU ? m_stats.gpuMS() : -1.0f);
+  if (m_replay->finished())
+  {
+    std::cout << m_replay->summary();
+    QGuiApplication::exit(EXIT_SUCCESS);
+  }
+  else
+  {
+    // fixed frame steps, the next frame is drawn whether or not anything changed
+    update();
+  }
+}
+
+QSize NGLScene::initialSize() const
+{
+  return m_replay ? QSize(m_replay->session().width, m_replay->session().height) : QSize(1024, 720);
+}
+
 void NGLScene::updateInnerTess(float _v)
 {
   m_innerLevel += _v;
@@ -355,3 +1062,9 @@ void NGLScene::updateOuterTess(float _v)
   m_outerLevel += _v;
   m_outerLevel = std::min(64.0f, std::max(1.0f, m_outerLevel));
 }
+
+void NGLScene::updateTargetEdgePixels(float _v)
+{
+  m_targetEdgePixels += _v;
+  m_targetEdgePixels = std::min(200.0f, std::max(1.0f, m_targetEdgePixels));
+}
@@ -0,0 +1,246 @@
+#include "ParallelTessellator.h"
+#include "TessTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace tess
+{
+
+namespace
+{
+  // marks an index as pointing at an arena's interior vertices rather than at a shared vertex
+  constexpr uint32_t InteriorFlag = 0x80000000u;
+
+  double msSince(std::chrono::steady_clock::time_point _start)
+  {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+  }
+} // end anonymous namespace
+
+ParallelTessellator::ParallelTessellator(ThreadPool &_pool) : m_pool(_pool), m_arenas(_pool.size())
+{
+}
+
+void ParallelTessellator::buildEdges(const uint32_t *_patchIndices, size_t _numPatches)
+{
+  // sorting the (edge, patch side) pairs groups the sides of each edge with the lowest patch, the owner, first
+  struct Side
+  {
+    uint64_t key;
+    uint32_t patchEdge;
+    bool operator<(const Side &_r) const { return key < _r.key || (key == _r.key && patchEdge < _r.patchEdge); }
+  };
+  std::vector<Side> sides(_numPatches * 3);
+  for (size_t patch = 0; patch < _numPatches; ++patch)
+  {
+    for (int e = 0; e < 3; ++e)
+    {
+      uint64_t a = _patchIndices[patch * 3 + (e + 1) % 3];
+      uint64_t b = _patchIndices[patch * 3 + (e + 2) % 3];
+      sides[patch * 3 + e] = {std::min(a, b) << 32 | std::max(a, b), static_cast<uint32_t>(patch * 3 + e)};
+    }
+  }
+  std::sort(sides.begin(), sides.end());
+  m_patchEdges.assign(_numPatches * 3, PatchEdge());
+  m_edgeStart.assign(1, 0);
+  for (size_t first = 0; first < sides.size();)
+  {
+    const uint32_t edge = static_cast<uint32_t>(m_edgeStart.size() - 1);
+    const uint32_t ownerSide = sides[first].patchEdge;
+    const size_t ownerPatch = ownerSide / 3;
+    const int ownerE = ownerSide % 3;
+    const uint32_t ownerStart = _patchIndices[ownerPatch * 3 + (ownerE + 1) % 3];
+    IntLevels levels = roundLevels(m_patchLevels[ownerPatch]);
+    size_t count = levels.discarded ? 0 : static_cast<size_t>(levels.outer[ownerE] - 1);
+    size_t last = first;
+    for (; last < sides.size() && sides[last].key == sides[first].key; ++last)
+    {
+      const uint32_t side = sides[last].patchEdge;
+      PatchEdge &pe = m_patchEdges[side];
+      pe.edge = edge;
+      pe.owner = last == first;
+      pe.reversed = _patchIndices[(side / 3) * 3 + (side % 3 + 1) % 3] != ownerStart;
+    }
+    m_edgeStart.push_back(m_edgeStart.back() + count);
+    first = last;
+  }
+}
+
+void ParallelTessellator::tessellate(const float *_positions, size_t _numPositions, const uint32_t *_patchIndices,
+                                     size_t _numPatches, const PatchLevelFunction &_levels, PatchEvaluation _evaluation,
+                                     TessMesh &o_mesh)
+{
+  TESS_TRACE_ZONE("ParallelTessellator::tessellate");
+  m_timings = Timings();
+  auto start = std::chrono::steady_clock::now();
+  const size_t grain = std::max<size_t>(1, m_grain);
+  m_patchLevels.resize(_numPatches);
+  m_pool.parallelFor(_numPatches, grain * 4, [&](size_t _begin, size_t _end, size_t)
+                     {
+                       TESS_TRACE_ZONE("patch levels");
+                       for (size_t patch = _begin; patch < _end; ++patch)
+                       {
+                         m_patchLevels[patch] = _levels(patch);
+                       }
+                     });
+  buildEdges(_patchIndices, _numPatches);
+  const size_t edgeBase = _numPositions;
+  const size_t interiorBase = edgeBase + m_edgeStart.back();
+  o_mesh.positions.resize(interiorBase * 3);
+  o_mesh.patchCoords.clear();
+  o_mesh.normals.clear();
+  // corners are the control points, on the sphere moved out to the surface like every other point
+  m_pool.parallelFor(_numPositions, grain * 16, [&](size_t _begin, size_t _end, size_t)
+                     {
+                       TESS_TRACE_ZONE("corners");
+                       for (size_t i = _begin; i < _end; ++i)
+                       {
+                         const float *p = &_positions[i * 3];
+                         float inv = _evaluation == PatchEvaluation::Sphere ? 1.0f / std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]) : 1.0f;
+                         for (int k = 0; k < 3; ++k)
+                         {
+                           o_mesh.positions[i * 3 + k] = p[k] * inv;
+                         }
+                       }
+                     });
+  m_timings.edgesMS = msSince(start);
+
+  start = std::chrono::steady_clock::now();
+  for (auto &arena : m_arenas)
+  {
+    arena.vertices.clear();
+    arena.indices.clear();
+    arena.segments.clear();
+  }
+  m_pool.parallelFor(_numPatches, grain, [&](size_t _begin, size_t _end, size_t _worker)
+                     {
+                       TESS_TRACE_ZONE("tessellate patches");
+                       Arena &arena = m_arenas[_worker];
+                       Segment segment;
+                       segment.chunk = _begin / grain;
+                       segment.vertexStart = arena.vertices.size() / 3;
+                       segment.indexStart = arena.indices.size();
+                       for (size_t patch = _begin; patch < _end; ++patch)
+                       {
+                         const TessPattern &pattern = arena.tessellator.pattern(m_patchLevels[patch]);
+                         if (pattern.levels().discarded)
+                         {
+                           continue;
+                         }
+                         const uint32_t *idx = &_patchIndices[patch * 3];
+                         const float *p0 = &_positions[idx[0] * 3];
+                         const float *p1 = &_positions[idx[1] * 3];
+                         const float *p2 = &_positions[idx[2] * 3];
+                         const size_t nv = pattern.numVertices();
+                         arena.scratch.resize(nv * 3);
+                         if (_evaluation == PatchEvaluation::Sphere)
+                         {
+                           evaluateSpherePatch(pattern, p0, p1, p2, arena.scratch.data());
+                         }
+                         else
+                         {
+                           evaluateLinearPatch(pattern, p0, p1, p2, arena.scratch.data());
+                         }
+                         arena.remap.resize(nv);
+                         for (int c = 0; c < 3; ++c)
+                         {
+                           arena.remap[c] = idx[c];
+                         }
+                         for (int e = 0; e < 3; ++e)
+                         {
+                           const PatchEdge &pe = m_patchEdges[patch * 3 + e];
+                           const uint32_t count = pattern.edgeCount(e);
+                           const size_t base = edgeBase + m_edgeStart[pe.edge];
+                           // a neighbour asked for a different level, keep this side's points private rather than
+                           // index past the shared run (the mesh cracks there like it would on the GPU)
+                           if (count != m_edgeStart[pe.edge + 1] - m_edgeStart[pe.edge])
+                           {
+                             for (uint32_t k = 0; k < count; ++k)
+                             {
+                               const uint32_t local = pattern.edgeStart(e) + k;
+                               arena.remap[local] = static_cast<uint32_t>(arena.vertices.size() / 3) | InteriorFlag;
+                               arena.vertices.insert(arena.vertices.end(), &arena.scratch[local * 3], &arena.scratch[local * 3] + 3);
+                             }
+                             continue;
+                           }
+                           for (uint32_t k = 0; k < count; ++k)
+                           {
+                             const size_t global = base + (pe.reversed ? count - 1 - k : k);
+                             const uint32_t local = pattern.edgeStart(e) + k;
+                             arena.remap[local] = static_cast<uint32_t>(global);
+                             // only the owner writes so every edge point is evaluated exactly once
+                             if (pe.owner)
+                             {
+                               std::copy(&arena.scratch[local * 3], &arena.scratch[local * 3] + 3, &o_mesh.positions[global * 3]);
+                             }
+                           }
+                         }
+                         for (size_t i = pattern.interiorStart(); i < nv; ++i)
+                         {
+                           arena.remap[i] = static_cast<uint32_t>(arena.vertices.size() / 3) | InteriorFlag;
+                           arena.vertices.insert(arena.vertices.end(), &arena.scratch[i * 3], &arena.scratch[i * 3] + 3);
+                         }
+                         for (uint32_t i : pattern.indices())
+                         {
+                           arena.indices.push_back(arena.remap[i]);
+                         }
+                       }
+                       segment.vertexCount = arena.vertices.size() / 3 - segment.vertexStart;
+                       segment.indexCount = arena.indices.size() - segment.indexStart;
+                       arena.segments.push_back(segment);
+                     });
+  m_timings.patchesMS = msSince(start);
+
+  start = std::chrono::steady_clock::now();
+  // lay the segments out in patch order whichever worker produced them
+  struct Placed
+  {
+    const Arena *arena;
+    const Segment *segment;
+    size_t vertexOffset;
+    size_t indexOffset;
+  };
+  std::vector<Placed> placed;
+  for (const auto &arena : m_arenas)
+  {
+    for (const auto &segment : arena.segments)
+    {
+      placed.push_back({&arena, &segment, 0, 0});
+    }
+  }
+  std::sort(placed.begin(), placed.end(), [](const Placed &_a, const Placed &_b) { return _a.segment->chunk < _b.segment->chunk; });
+  size_t vertices = interiorBase;
+  size_t indices = 0;
+  for (auto &p : placed)
+  {
+    p.vertexOffset = vertices;
+    p.indexOffset = indices;
+    vertices += p.segment->vertexCount;
+    indices += p.segment->indexCount;
+  }
+  o_mesh.positions.resize(vertices * 3);
+  o_mesh.indices.resize(indices);
+  m_pool.parallelFor(placed.size(), 1, [&](size_t _begin, size_t _end, size_t)
+                     {
+                       TESS_TRACE_ZONE("gather");
+                       for (size_t s = _begin; s < _end; ++s)
+                       {
+                         const Placed &p = placed[s];
+                         const Segment &segment = *p.segment;
+                         const float *vin = &p.arena->vertices[segment.vertexStart * 3];
+                         std::copy(vin, vin + segment.vertexCount * 3, &o_mesh.positions[p.vertexOffset * 3]);
+                         const uint32_t *in = &p.arena->indices[segment.indexStart];
+                         uint32_t *out = &o_mesh.indices[p.indexOffset];
+                         for (size_t i = 0; i < segment.indexCount; ++i)
+                         {
+                           out[i] = in[i] & InteriorFlag
+                                        ? static_cast<uint32_t>((in[i] & ~InteriorFlag) - segment.vertexStart + p.vertexOffset)
+                                        : in[i];
+                         }
+                       }
+                     });
+  m_timings.mergeMS = msSince(start);
+}
+
+} // end namespace tess
@@ -0,0 +1,69 @@
+#include "PatchCulling.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tess
+{
+
+namespace
+{
+  float dot(const float *_a, const float *_b)
+  {
+    return _a[0] * _b[0] + _a[1] * _b[1] + _a[2] * _b[2];
+  }
+  float distance(const float *_a, const float *_b)
+  {
+    float d[3] = {_a[0] - _b[0], _a[1] - _b[1], _a[2] - _b[2]};
+    return std::sqrt(dot(d, d));
+  }
+  float cosAngle(const float *_a, const float *_b)
+  {
+    return std::min(1.0f, std::max(-1.0f, dot(_a, _b) / std::sqrt(dot(_a, _a) * dot(_b, _b))));
+  }
+} // end anonymous namespace
+
+bool patchCulled(const float *_p0, const float *_p1, const float *_p2, const CullParams &_params)
+{
+  // bounding sphere of the flat triangle grown by how far the surface bulges out to the unit sphere
+  float c[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    c[i] = (_p0[i] + _p1[i] + _p2[i]) / 3.0f;
+  }
+  float r = std::max(distance(c, _p0), std::max(distance(c, _p1), distance(c, _p2)));
+  float e1[3] = {_p1[0] - _p0[0], _p1[1] - _p0[1], _p1[2] - _p0[2]};
+  float e2[3] = {_p2[0] - _p0[0], _p2[1] - _p0[1], _p2[2] - _p0[2]};
+  float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+  r += 1.0f - std::fabs(dot(n, _p0)) / std::sqrt(dot(n, n));
+  // frustum planes from the rows of the column major MVP
+  const float *m = _params.MVP;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    for (float sign : {1.0f, -1.0f})
+    {
+      float plane[4];
+      for (int col = 0; col < 4; ++col)
+      {
+        plane[col] = m[col * 4 + 3] + sign * m[col * 4 + axis];
+      }
+      if (dot(plane, c) + plane[3] < -r * std::sqrt(dot(plane, plane)))
+      {
+        return true;
+      }
+    }
+  }
+  // back facing cone test, see tesscontrol.glsl
+  float eyeDist = std::sqrt(dot(_params.eye, _params.eye));
+  if (eyeDist > 1.0f)
+  {
+    float alpha = std::acos(std::min(cosAngle(c, _p0), std::min(cosAngle(c, _p1), cosAngle(c, _p2))));
+    float theta = std::acos(cosAngle(c, _params.eye));
+    if (eyeDist * std::cos(std::max(0.0f, theta - alpha)) < 1.0f)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // end namespace tess
@@ -0,0 +1,371 @@
+#include "PatchMesh.h"
+#include "Icosahedron.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <utility>
+
+namespace tess
+{
+
+namespace
+{
+  // spread the low 10 bits of _v out so there are two zero bits between each
+  uint32_t expandBits(uint32_t _v)
+  {
+    _v = (_v * 0x00010001u) & 0xFF0000FFu;
+    _v = (_v * 0x00000101u) & 0x0F00F00Fu;
+    _v = (_v * 0x00000011u) & 0xC30C30C3u;
+    _v = (_v * 0x00000005u) & 0x49249249u;
+    return _v;
+  }
+
+  int16_t toSnorm16(float _v)
+  {
+    return static_cast<int16_t>(std::lround(std::clamp(_v, -1.0f, 1.0f) * 32767.0f));
+  }
+
+  float fromSnorm16(int16_t _v)
+  {
+    return std::max(_v / 32767.0f, -1.0f);
+  }
+
+  template <typename IndexType>
+  void writeIndices(const std::vector<uint32_t> &_indices, std::vector<uint8_t> &o_data)
+  {
+    o_data.resize(_indices.size() * sizeof(IndexType));
+    for (size_t i = 0; i < _indices.size(); ++i)
+    {
+      IndexType index = static_cast<IndexType>(_indices[i]);
+      std::memcpy(&o_data[i * sizeof(IndexType)], &index, sizeof(IndexType));
+    }
+  }
+} // end anonymous namespace
+
+void makeIcosphere(int _subdivisions, TrianglePatchMesh &o_mesh)
+{
+  o_mesh.positions.assign(IcosahedronVerts.begin(), IcosahedronVerts.end());
+  o_mesh.patchIndices.assign(IcosahedronFaces.begin(), IcosahedronFaces.end());
+  for (int level = 0; level < _subdivisions; ++level)
+  {
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+    auto midpoint = [&](uint32_t _a, uint32_t _b)
+    {
+      auto key = std::make_pair(std::min(_a, _b), std::max(_a, _b));
+      auto found = midpoints.find(key);
+      if (found != midpoints.end())
+      {
+        return found->second;
+      }
+      float p[3];
+      for (int k = 0; k < 3; ++k)
+      {
+        p[k] = 0.5f * (o_mesh.positions[_a * 3 + k] + o_mesh.positions[_b * 3 + k]);
+      }
+      float inv = 1.0f / std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+      uint32_t index = static_cast<uint32_t>(o_mesh.numVertices());
+      o_mesh.positions.insert(o_mesh.positions.end(), {p[0] * inv, p[1] * inv, p[2] * inv});
+      midpoints.emplace(key, index);
+      return index;
+    };
+    std::vector<uint32_t> patches;
+    patches.reserve(o_mesh.patchIndices.size() * 4);
+    for (size_t i = 0; i < o_mesh.patchIndices.size(); i += 3)
+    {
+      // keep the winding of the parent on all 4 children
+      uint32_t a = o_mesh.patchIndices[i], b = o_mesh.patchIndices[i + 1], c = o_mesh.patchIndices[i + 2];
+      uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+      patches.insert(patches.end(), {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca});
+    }
+    o_mesh.patchIndices.swap(patches);
+  }
+}
+
+double patchACMR(const TrianglePatchMesh &_mesh, size_t _cacheSize)
+{
+  if (_mesh.numPatches() == 0)
+  {
+    return 0.0;
+  }
+  // a FIFO like the post transform caches of most GPUs, a hit doesn't refresh the entry
+  std::vector<size_t> insertedAt(_mesh.numVertices(), 0);
+  size_t misses = 0;
+  for (uint32_t index : _mesh.patchIndices)
+  {
+    if (insertedAt[index] == 0 || misses - insertedAt[index] + 1 > _cacheSize)
+    {
+      ++misses;
+      insertedAt[index] = misses;
+    }
+  }
+  return static_cast<double>(misses) / _mesh.numPatches();
+}
+
+void reorderPatches(TrianglePatchMesh &io_mesh)
+{
+  const size_t numPatches = io_mesh.numPatches();
+  if (numPatches == 0)
+  {
+    return;
+  }
+  float lo[3] = {1e30f, 1e30f, 1e30f};
+  float hi[3] = {-1e30f, -1e30f, -1e30f};
+  for (size_t i = 0; i < io_mesh.positions.size(); ++i)
+  {
+    lo[i % 3] = std::min(lo[i % 3], io_mesh.positions[i]);
+    hi[i % 3] = std::max(hi[i % 3], io_mesh.positions[i]);
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> codes(numPatches);
+  for (size_t patch = 0; patch < numPatches; ++patch)
+  {
+    uint32_t cell[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      float centre = 0.0f;
+      for (int c = 0; c < 3; ++c)
+      {
+        centre += io_mesh.positions[io_mesh.patchIndices[patch * 3 + c] * 3 + k];
+      }
+      centre /= 3.0f;
+      float t = hi[k] > lo[k] ? (centre - lo[k]) / (hi[k] - lo[k]) : 0.0f;
+      cell[k] = std::min(1023u, static_cast<uint32_t>(t * 1024.0f));
+    }
+    codes[patch] = {expandBits(cell[0]) << 2 | expandBits(cell[1]) << 1 | expandBits(cell[2]), static_cast<uint32_t>(patch)};
+  }
+  std::stable_sort(codes.begin(), codes.end(), [](const auto &_a, const auto &_b) { return _a.first < _b.first; });
+
+  constexpr uint32_t Unused = ~0u;
+  std::vector<uint32_t> remap(io_mesh.numVertices(), Unused);
+  std::vector<uint32_t> patches(io_mesh.patchIndices.size());
+  std::vector<float> positions;
+  positions.reserve(io_mesh.positions.size());
+  uint32_t next = 0;
+  for (size_t i = 0; i < numPatches; ++i)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      uint32_t old = io_mesh.patchIndices[codes[i].second * 3 + c];
+      if (remap[old] == Unused)
+      {
+        remap[old] = next++;
+        positions.insert(positions.end(), &io_mesh.positions[old * 3], &io_mesh.positions[old * 3] + 3);
+      }
+      patches[i * 3 + c] = remap[old];
+    }
+  }
+  // vertices no patch uses go to the end so nothing is lost
+  for (size_t old = 0; old < remap.size(); ++old)
+  {
+    if (remap[old] == Unused)
+    {
+      positions.insert(positions.end(), &io_mesh.positions[old * 3], &io_mesh.positions[old * 3] + 3);
+    }
+  }
+  io_mesh.positions.swap(positions);
+  io_mesh.patchIndices.swap(patches);
+}
+
+const char *indexFormatName(IndexFormat _format)
+{
+  switch (_format)
+  {
+  case IndexFormat::UInt8:
+    return "uint8";
+  case IndexFormat::UInt16:
+    return "uint16";
+  default:
+    return "uint32";
+  }
+}
+
+const char *positionFormatName(PositionFormat _format)
+{
+  switch (_format)
+  {
+  case PositionFormat::Snorm16:
+    return "snorm16";
+  case PositionFormat::Octahedral:
+    return "octahedral";
+  default:
+    return "float";
+  }
+}
+
+size_t indexFormatSize(IndexFormat _format)
+{
+  return _format == IndexFormat::UInt8 ? 1 : _format == IndexFormat::UInt16 ? 2 : 4;
+}
+
+IndexFormat smallestIndexFormat(size_t _numVertices)
+{
+  if (_numVertices <= 256)
+  {
+    return IndexFormat::UInt8;
+  }
+  return _numVertices <= 65536 ? IndexFormat::UInt16 : IndexFormat::UInt32;
+}
+
+bool encodePatchMesh(const TrianglePatchMesh &_mesh, PositionFormat _positions, IndexFormat _indices,
+                     EncodedPatchMesh &o_encoded)
+{
+  o_encoded = EncodedPatchMesh();
+  const size_t numVertices = _mesh.numVertices();
+  if (numVertices > (size_t(1) << (8 * indexFormatSize(_indices))))
+  {
+    return false;
+  }
+  o_encoded.positionFormat = _positions;
+  o_encoded.indexFormat = _indices;
+  o_encoded.numVertices = numVertices;
+  o_encoded.numIndices = _mesh.patchIndices.size();
+  switch (_positions)
+  {
+  case PositionFormat::Float32:
+    o_encoded.vertexStride = 3 * sizeof(float);
+    o_encoded.vertexData.resize(_mesh.positions.size() * sizeof(float));
+    std::memcpy(o_encoded.vertexData.data(), _mesh.positions.data(), o_encoded.vertexData.size());
+    break;
+  case PositionFormat::Snorm16:
+  {
+    float scale = 0.0f;
+    for (float v : _mesh.positions)
+    {
+      scale = std::max(scale, std::abs(v));
+    }
+    o_encoded.positionScale = scale > 0.0f ? scale : 1.0f;
+    o_encoded.vertexStride = 4 * sizeof(int16_t);
+    o_encoded.vertexData.resize(numVertices * o_encoded.vertexStride);
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+      int16_t v[4] = {0, 0, 0, 0};
+      for (int k = 0; k < 3; ++k)
+      {
+        v[k] = toSnorm16(_mesh.positions[i * 3 + k] / o_encoded.positionScale);
+      }
+      std::memcpy(&o_encoded.vertexData[i * o_encoded.vertexStride], v, sizeof(v));
+    }
+    break;
+  }
+  case PositionFormat::Octahedral:
+    o_encoded.vertexStride = 2 * sizeof(int16_t);
+    o_encoded.vertexData.resize(numVertices * o_encoded.vertexStride);
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+      const float *p = &_mesh.positions[i * 3];
+      float l1 = std::abs(p[0]) + std::abs(p[1]) + std::abs(p[2]);
+      float x = l1 > 0.0f ? p[0] / l1 : 0.0f;
+      float y = l1 > 0.0f ? p[1] / l1 : 0.0f;
+      // fold the lower hemisphere over the diagonals
+      if (p[2] < 0.0f)
+      {
+        float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+      }
+      int16_t v[2] = {toSnorm16(x), toSnorm16(y)};
+      std::memcpy(&o_encoded.vertexData[i * o_encoded.vertexStride], v, sizeof(v));
+    }
+    break;
+  }
+  switch (_indices)
+  {
+  case IndexFormat::UInt8:
+    writeIndices<uint8_t>(_mesh.patchIndices, o_encoded.indexData);
+    break;
+  case IndexFormat::UInt16:
+    writeIndices<uint16_t>(_mesh.patchIndices, o_encoded.indexData);
+    break;
+  case IndexFormat::UInt32:
+    writeIndices<uint32_t>(_mesh.patchIndices, o_encoded.indexData);
+    break;
+  }
+  return true;
+}
+
+void decodePosition(const EncodedPatchMesh &_encoded, size_t _vertex, float *o_xyz)
+{
+  const uint8_t *data = &_encoded.vertexData[_vertex * _encoded.vertexStride];
+  switch (_encoded.positionFormat)
+  {
+  case PositionFormat::Float32:
+    std::memcpy(o_xyz, data, 3 * sizeof(float));
+    break;
+  case PositionFormat::Snorm16:
+  {
+    int16_t v[3];
+    std::memcpy(v, data, sizeof(v));
+    for (int k = 0; k < 3; ++k)
+    {
+      o_xyz[k] = fromSnorm16(v[k]) * _encoded.positionScale;
+    }
+    break;
+  }
+  case PositionFormat::Octahedral:
+  {
+    // the same steps as octahedralDecode in tessvert.glsl
+    int16_t v[2];
+    std::memcpy(v, data, sizeof(v));
+    float x = fromSnorm16(v[0]);
+    float y = fromSnorm16(v[1]);
+    float z = 1.0f - std::abs(x) - std::abs(y);
+    float t = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    float inv = 1.0f / std::sqrt(x * x + y * y + z * z);
+    o_xyz[0] = x * inv;
+    o_xyz[1] = y * inv;
+    o_xyz[2] = z * inv;
+    break;
+  }
+  }
+}
+
+float maxPositionError(const TrianglePatchMesh &_mesh, const EncodedPatchMesh &_encoded)
+{
+  float error = 0.0f;
+  for (size_t i = 0; i < _encoded.numVertices; ++i)
+  {
+    float p[3];
+    std::copy(&_mesh.positions[i * 3], &_mesh.positions[i * 3] + 3, p);
+    if (_encoded.positionFormat == PositionFormat::Octahedral)
+    {
+      float inv = 1.0f / std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+      p[0] *= inv;
+      p[1] *= inv;
+      p[2] *= inv;
+    }
+    float d[3];
+    decodePosition(_encoded, i, d);
+    error = std::max(error, std::sqrt((d[0] - p[0]) * (d[0] - p[0]) + (d[1] - p[1]) * (d[1] - p[1]) + (d[2] - p[2]) * (d[2] - p[2])));
+  }
+  return error;
+}
+
+void buildPatchMesh(const PatchMeshSettings &_settings, TrianglePatchMesh &o_mesh, EncodedPatchMesh &o_encoded)
+{
+  makeIcosphere(_settings.subdivisions, o_mesh);
+  if (_settings.reorder)
+  {
+    reorderPatches(o_mesh);
+  }
+  IndexFormat indices = smallestIndexFormat(o_mesh.numVertices());
+  IndexFormat requested = _settings.indexBits == 8 ? IndexFormat::UInt8 : _settings.indexBits == 16 ? IndexFormat::UInt16 : IndexFormat::UInt32;
+  if (_settings.indexBits != 0)
+  {
+    if (indexFormatSize(requested) < indexFormatSize(indices))
+    {
+      std::cerr << o_mesh.numVertices() << " vertices need " << indexFormatName(indices) << " indices, not "
+                << indexFormatName(requested) << '\n';
+    }
+    else
+    {
+      indices = requested;
+    }
+  }
+  encodePatchMesh(o_mesh, _settings.positions, indices, o_encoded);
+}
+
+} // end namespace tess
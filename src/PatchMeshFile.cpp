@@ -0,0 +1,256 @@
+#include "PatchMeshFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tess
+{
+
+namespace
+{
+  uint64_t align16(uint64_t _offset)
+  {
+    return (_offset + 15) & ~uint64_t(15);
+  }
+
+  void pad(std::ofstream &_out, uint64_t _to)
+  {
+    static const char zeros[16] = {};
+    uint64_t at = static_cast<uint64_t>(_out.tellp());
+    _out.write(zeros, static_cast<std::streamsize>(_to - at));
+  }
+
+  // o_result = _a * _b, false if it doesn't fit in 64 bits
+  bool checkedMul(uint64_t _a, uint64_t _b, uint64_t &o_result)
+  {
+    if (_a != 0 && _b > ~uint64_t(0) / _a)
+    {
+      return false;
+    }
+    o_result = _a * _b;
+    return true;
+  }
+
+  // a section of _count elements of _elementBytes at _offset lies after the header and inside a file of _size bytes
+  bool sectionFits(uint64_t _offset, uint64_t _count, uint64_t _elementBytes, uint64_t _size)
+  {
+    uint64_t bytes = 0;
+    return _offset >= sizeof(PatchMeshFileHeader) && _offset <= _size && checkedMul(_count, _elementBytes, bytes) &&
+           bytes <= _size - _offset;
+  }
+} // end anonymous namespace
+
+bool writePatchMeshFile(const std::string &_fname, const TrianglePatchMesh &_mesh, const std::vector<float> &_hints,
+                        uint64_t _patchesPerBlock)
+{
+  std::ofstream out(_fname, std::ios::binary);
+  if (!out)
+  {
+    std::cerr << "Unable to write " << _fname << '\n';
+    return false;
+  }
+  const bool hints = !_hints.empty();
+  if (hints && _hints.size() != _mesh.numPatches())
+  {
+    std::cerr << "Need one hint per patch, got " << _hints.size() << " for " << _mesh.numPatches() << " patches\n";
+    return false;
+  }
+  PatchMeshFileHeader header;
+  header.indexSize = _mesh.numVertices() <= 65536 ? 2 : 4;
+  header.flags = hints ? PatchMeshHasHints : 0;
+  header.numVertices = _mesh.numVertices();
+  header.numPatches = _mesh.numPatches();
+  header.patchesPerBlock = std::max<uint64_t>(1, _patchesPerBlock);
+  header.numBlocks = (header.numPatches + header.patchesPerBlock - 1) / header.patchesPerBlock;
+  header.positionsOffset = align16(sizeof(PatchMeshFileHeader));
+  header.indicesOffset = align16(header.positionsOffset + header.numVertices * 3 * sizeof(float));
+  uint64_t end = align16(header.indicesOffset + header.numPatches * 3 * header.indexSize);
+  if (hints)
+  {
+    header.hintsOffset = end;
+    end = align16(header.hintsOffset + header.numPatches * sizeof(float));
+  }
+  header.blocksOffset = end;
+
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  pad(out, header.positionsOffset);
+  out.write(reinterpret_cast<const char *>(_mesh.positions.data()), static_cast<std::streamsize>(_mesh.positions.size() * sizeof(float)));
+  pad(out, header.indicesOffset);
+  if (header.indexSize == 2)
+  {
+    std::vector<uint16_t> narrow(_mesh.patchIndices.begin(), _mesh.patchIndices.end());
+    out.write(reinterpret_cast<const char *>(narrow.data()), static_cast<std::streamsize>(narrow.size() * sizeof(uint16_t)));
+  }
+  else
+  {
+    out.write(reinterpret_cast<const char *>(_mesh.patchIndices.data()), static_cast<std::streamsize>(_mesh.patchIndices.size() * sizeof(uint32_t)));
+  }
+  if (hints)
+  {
+    pad(out, header.hintsOffset);
+    out.write(reinterpret_cast<const char *>(_hints.data()), static_cast<std::streamsize>(_hints.size() * sizeof(float)));
+  }
+  pad(out, header.blocksOffset);
+  // running maximum so each entry covers every patch up to the end of its block
+  uint64_t vertexEnd = 0;
+  for (uint64_t block = 0; block < header.numBlocks; ++block)
+  {
+    uint64_t last = std::min(header.numPatches, (block + 1) * header.patchesPerBlock);
+    for (uint64_t i = block * header.patchesPerBlock * 3; i < last * 3; ++i)
+    {
+      vertexEnd = std::max<uint64_t>(vertexEnd, _mesh.patchIndices[i] + uint64_t(1));
+    }
+    out.write(reinterpret_cast<const char *>(&vertexEnd), sizeof(vertexEnd));
+  }
+  return static_cast<bool>(out);
+}
+
+MappedPatchMesh::~MappedPatchMesh()
+{
+  close();
+}
+
+bool MappedPatchMesh::open(const std::string &_fname)
+{
+  close();
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(_fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    std::cerr << "Unable to open " << _fname << '\n';
+    return false;
+  }
+  LARGE_INTEGER size;
+  GetFileSizeEx(file, &size);
+  HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+  void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  m_file = file;
+  m_mapping = mapping;
+  m_size = static_cast<size_t>(size.QuadPart);
+#else
+  int fd = ::open(_fname.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    std::cerr << "Unable to open " << _fname << '\n';
+    return false;
+  }
+  struct stat info;
+  void *data = nullptr;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+  {
+    m_size = static_cast<size_t>(info.st_size);
+    data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      data = nullptr;
+    }
+    else
+    {
+      // the sections are read front to back once
+      madvise(data, m_size, MADV_SEQUENTIAL);
+    }
+  }
+  // the mapping keeps the file alive
+  ::close(fd);
+#endif
+  m_data = static_cast<const uint8_t *>(data);
+  if (!m_data)
+  {
+    std::cerr << "Unable to map " << _fname << '\n';
+    close();
+    return false;
+  }
+  const PatchMeshFileHeader &h = header();
+  // the sizes come from the file so all the arithmetic is checked, a wrapped size would pass the comparisons
+  const bool valid =
+      m_size >= sizeof(PatchMeshFileHeader) && std::memcmp(h.magic, "TPMF", 4) == 0 && h.version == PatchMeshFileVersion &&
+      (h.indexSize == 2 || h.indexSize == 4) && h.patchesPerBlock > 0 &&
+      h.numBlocks == h.numPatches / h.patchesPerBlock + (h.numPatches % h.patchesPerBlock != 0 ? 1 : 0) &&
+      sectionFits(h.positionsOffset, h.numVertices, 3 * sizeof(float), m_size) &&
+      sectionFits(h.indicesOffset, h.numPatches, 3 * uint64_t(h.indexSize), m_size) &&
+      (h.hintsOffset == 0 || sectionFits(h.hintsOffset, h.numPatches, sizeof(float), m_size)) &&
+      sectionFits(h.blocksOffset, h.numBlocks, sizeof(uint64_t), m_size);
+  if (!valid)
+  {
+    std::cerr << _fname << " is not a version " << PatchMeshFileVersion << " .tpm file or is truncated\n";
+    close();
+    return false;
+  }
+  if (!validBlocks())
+  {
+    std::cerr << _fname << " has a bad block table\n";
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedPatchMesh::validBlocks() const
+{
+  // MeshStreamer copies blockVertexEnd(b) vertices and blockPatchEnd(b) patches for block b, so both have to grow
+  // block by block and stay inside the mesh. The sections fit in the mapping so the counts fit in a size_t
+  size_t vertexEnd = 0;
+  size_t patchEnd = 0;
+  for (size_t block = 0; block < numBlocks(); ++block)
+  {
+    if (blockVertexEnd(block) < vertexEnd || blockVertexEnd(block) > numVertices() || blockPatchEnd(block) <= patchEnd)
+    {
+      return false;
+    }
+    vertexEnd = blockVertexEnd(block);
+    patchEnd = blockPatchEnd(block);
+  }
+  return patchEnd == numPatches();
+}
+
+void MappedPatchMesh::close()
+{
+#if defined(_WIN32)
+  if (m_data)
+  {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping)
+  {
+    CloseHandle(m_mapping);
+  }
+  if (m_file)
+  {
+    CloseHandle(m_file);
+  }
+  m_file = m_mapping = nullptr;
+#else
+  if (m_data)
+  {
+    munmap(const_cast<uint8_t *>(m_data), m_size);
+  }
+#endif
+  m_data = nullptr;
+  m_size = 0;
+}
+
+size_t MappedPatchMesh::blockPatchEnd(size_t _block) const
+{
+  // every block but the last is full, open() has checked numBlocks against numPatches
+  return _block + 1 < numBlocks() ? (_block + 1) * static_cast<size_t>(header().patchesPerBlock) : numPatches();
+}
+
+size_t MappedPatchMesh::blockVertexEnd(size_t _block) const
+{
+  uint64_t end = 0;
+  std::memcpy(&end, m_data + header().blocksOffset + _block * sizeof(uint64_t), sizeof(end));
+  return static_cast<size_t>(end);
+}
+
+} // end namespace tess
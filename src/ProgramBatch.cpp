@@ -0,0 +1,144 @@
+#include "ProgramBatch.h"
+#include "TessTrace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+namespace
+{
+  std::string infoLog(GLuint _object, bool _program)
+  {
+    GLint length = 0;
+    _program ? glGetProgramiv(_object, GL_INFO_LOG_LENGTH, &length) : glGetShaderiv(_object, GL_INFO_LOG_LENGTH, &length);
+    std::string log(static_cast<size_t>(std::max(length, 1)), '\0');
+    _program ? glGetProgramInfoLog(_object, length, nullptr, &log[0]) : glGetShaderInfoLog(_object, length, nullptr, &log[0]);
+    return log;
+  }
+} // end anonymous namespace
+
+ProgramBatch::ProgramBatch(bool _programCache) : m_cache(_programCache)
+{
+  m_parallelCompile = ProgramCache::enableParallelCompile();
+}
+
+void ProgramBatch::add(ProgramRequest _request)
+{
+  if (m_entries.empty())
+  {
+    m_start = std::chrono::steady_clock::now();
+  }
+  Entry entry;
+  entry.request = std::move(_request);
+  const auto &request = entry.request;
+  ngl::ShaderLib::createShaderProgram(request.name);
+  entry.cacheKey = m_cache.key(request.stages, request.defines, request.feedbackVaryings);
+  entry.cacheHit = m_cache.enabled() && m_cache.submitBinary(ngl::ShaderLib::getProgramID(request.name), entry.cacheKey);
+  if (!entry.cacheHit)
+  {
+    submitCompile(entry);
+  }
+  m_entries.push_back(std::move(entry));
+}
+
+void ProgramBatch::submitCompile(const Entry &_entry) const
+{
+  const auto &request = _entry.request;
+  const GLuint program = ngl::ShaderLib::getProgramID(request.name);
+  for (const auto &stage : request.stages)
+  {
+    ngl::ShaderLib::attachShader(stage.name, stage.type);
+    ngl::ShaderLib::loadShaderSourceFromString(stage.name, ProgramCache::injectDefines(stage.source, request.defines));
+    ngl::ShaderLib::attachShaderToProgram(request.name, stage.name);
+    // ShaderLib::compileShader checks the status straight away, which would wait for the compiler
+    glCompileShader(ngl::ShaderLib::getShaderID(stage.name));
+  }
+  if (m_cache.enabled())
+  {
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+  if (!request.feedbackVaryings.empty())
+  {
+    std::vector<const char *> names;
+    for (const auto &varying : request.feedbackVaryings)
+    {
+      names.push_back(varying.c_str());
+    }
+    glTransformFeedbackVaryings(program, static_cast<GLsizei>(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+  }
+  glLinkProgram(program);
+}
+
+bool ProgramBatch::poll()
+{
+  if (done())
+  {
+    return true;
+  }
+  TESS_TRACE_ZONE("ProgramBatch::poll");
+  ++m_frames;
+  for (auto &entry : m_entries)
+  {
+    if (entry.finished)
+    {
+      continue;
+    }
+    if (m_parallelCompile ? ProgramCache::linkCompleted(ngl::ShaderLib::getProgramID(entry.request.name)) : m_frames >= PollFrames)
+    {
+      finish(entry);
+      if (!m_parallelCompile)
+      {
+        // one wait per frame
+        m_frames = 0;
+        break;
+      }
+    }
+  }
+  if (done())
+  {
+    m_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+  }
+  return done();
+}
+
+void ProgramBatch::finish(Entry &io_entry)
+{
+  const auto &request = io_entry.request;
+  const GLuint program = ngl::ShaderLib::getProgramID(request.name);
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (!linked && io_entry.cacheHit)
+  {
+    // the driver turned the binary down, compile it and check again on a later poll
+    io_entry.cacheHit = false;
+    submitCompile(io_entry);
+    return;
+  }
+  if (!linked)
+  {
+    // the start up programs are not optional, fail as loudly as ShaderLib would
+    std::cerr << "Program " << request.name << " failed to build\n" << infoLog(program, true) << '\n';
+    for (const auto &stage : request.stages)
+    {
+      std::cerr << stage.name << '\n' << infoLog(ngl::ShaderLib::getShaderID(stage.name), false);
+    }
+    std::exit(EXIT_FAILURE);
+  }
+  if (m_cache.enabled() && !io_entry.cacheHit)
+  {
+    m_cache.saveBinary(program, io_entry.cacheKey);
+  }
+  ngl::ShaderLib::use(request.name);
+  ngl::ShaderLib::autoRegisterUniforms(request.name);
+  if (request.setup)
+  {
+    request.setup();
+  }
+  io_entry.finished = true;
+  ++m_finished;
+}
+
+size_t ProgramBatch::cacheHits() const
+{
+  return static_cast<size_t>(std::count_if(m_entries.begin(), m_entries.end(), [](const Entry &_e) { return _e.cacheHit; }));
+}
@@ -0,0 +1,239 @@
+#include "ProgramCache.h"
+#include <QDir>
+#include <QOpenGLContext>
+#include <QStandardPaths>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+  // KHR_parallel_shader_compile and ARB_parallel_shader_compile share the enum
+  constexpr GLenum CompletionStatus = 0x91B1;
+
+  // 64 bit FNV-1a, good enough to tell sources apart and needs nothing extra
+  uint64_t fnv1a(uint64_t _hash, const std::string &_data)
+  {
+    for (unsigned char c : _data)
+    {
+      _hash ^= c;
+      _hash *= 1099511628211ull;
+    }
+    // separate consecutive strings so "ab"+"c" and "a"+"bc" differ
+    _hash ^= 0xff;
+    _hash *= 1099511628211ull;
+    return _hash;
+  }
+  std::string glString(GLenum _name)
+  {
+    auto s = glGetString(_name);
+    return s ? reinterpret_cast<const char *>(s) : "";
+  }
+} // end anonymous namespace
+
+ProgramCache::ProgramCache(bool _enabled) : m_enabled(_enabled)
+{
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  // no formats means the driver can't give us binaries at all
+  m_enabled = m_enabled && formats > 0;
+  m_directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString() + "/programs";
+}
+
+std::string ProgramCache::readFile(const std::string &_fname)
+{
+  std::ifstream in(_fname);
+  if (!in)
+  {
+    std::cerr << "Unable to open " << _fname << '\n';
+    return {};
+  }
+  std::stringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+std::string ProgramCache::injectDefines(const std::string &_source, const std::string &_defines)
+{
+  if (_defines.empty())
+  {
+    return _source;
+  }
+  // #version must stay the first thing in the shader
+  auto version = _source.find("#version");
+  size_t insert = version == std::string::npos ? 0 : _source.find('\n', version);
+  insert = insert == std::string::npos ? _source.size() : insert + 1;
+  return _source.substr(0, insert) + _defines + (_defines.back() == '\n' ? "" : "\n") + _source.substr(insert);
+}
+
+uint64_t ProgramCache::key(const std::vector<ShaderStageSource> &_stages, const std::string &_defines,
+                          const std::vector<std::string> &_feedbackVaryings) const
+{
+  uint64_t hash = 14695981039346656037ull;
+  hash = fnv1a(hash, glString(GL_VENDOR));
+  hash = fnv1a(hash, glString(GL_RENDERER));
+  hash = fnv1a(hash, glString(GL_VERSION));
+  hash = fnv1a(hash, _defines);
+  for (const auto &stage : _stages)
+  {
+    hash = fnv1a(hash, std::to_string(static_cast<int>(stage.type)));
+    hash = fnv1a(hash, stage.source);
+  }
+  for (const auto &varying : _feedbackVaryings)
+  {
+    hash = fnv1a(hash, varying);
+  }
+  return hash;
+}
+
+std::string ProgramCache::fileName(uint64_t _key) const
+{
+  std::stringstream name;
+  name << m_directory << '/' << std::hex << _key << ".bin";
+  return name.str();
+}
+
+bool ProgramCache::submitBinary(GLuint _program, uint64_t _key) const
+{
+  std::ifstream in(fileName(_key), std::ios::binary);
+  if (!in)
+  {
+    return false;
+  }
+  GLenum format = 0;
+  in.read(reinterpret_cast<char *>(&format), sizeof(format));
+  if (!in)
+  {
+    return false;
+  }
+  std::vector<char> binary((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (binary.empty())
+  {
+    return false;
+  }
+  glProgramBinary(_program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+  return true;
+}
+
+bool ProgramCache::loadBinary(GLuint _program, uint64_t _key) const
+{
+  if (!submitBinary(_program, _key))
+  {
+    return false;
+  }
+  GLint linked = GL_FALSE;
+  glGetProgramiv(_program, GL_LINK_STATUS, &linked);
+  return linked == GL_TRUE;
+}
+
+void ProgramCache::saveBinary(GLuint _program, uint64_t _key) const
+{
+  GLint length = 0;
+  glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+  {
+    return;
+  }
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(_program, length, &length, &format, binary.data());
+  QDir().mkpath(QString::fromStdString(m_directory));
+  std::ofstream out(fileName(_key), std::ios::binary);
+  if (!out)
+  {
+    std::cerr << "Unable to write program cache " << fileName(_key) << '\n';
+    return;
+  }
+  out.write(reinterpret_cast<const char *>(&format), sizeof(format));
+  out.write(binary.data(), length);
+}
+
+ProgramBuildInfo ProgramCache::build(const std::string &_program, const std::vector<ShaderStageSource> &_stages,
+                                     const std::string &_defines, const std::vector<std::string> &_feedbackVaryings)
+{
+  auto start = std::chrono::steady_clock::now();
+  ProgramBuildInfo info;
+  const uint64_t hash = key(_stages, _defines, _feedbackVaryings);
+  ngl::ShaderLib::createShaderProgram(_program);
+  info.cacheHit = m_enabled && loadBinary(ngl::ShaderLib::getProgramID(_program), hash);
+  if (!info.cacheHit)
+  {
+    for (auto &stage : _stages)
+    {
+      // create an empty shader, attach the source and add it to the program
+      ngl::ShaderLib::attachShader(stage.name, stage.type);
+      ngl::ShaderLib::loadShaderSourceFromString(stage.name, injectDefines(stage.source, _defines));
+      ngl::ShaderLib::attachShaderToProgram(_program, stage.name);
+    }
+    for (auto &stage : _stages)
+    {
+      ngl::ShaderLib::compileShader(stage.name);
+    }
+    if (m_enabled)
+    {
+      glProgramParameteri(ngl::ShaderLib::getProgramID(_program), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    if (!_feedbackVaryings.empty())
+    {
+      std::vector<const char *> names;
+      for (const auto &varying : _feedbackVaryings)
+      {
+        names.push_back(varying.c_str());
+      }
+      glTransformFeedbackVaryings(ngl::ShaderLib::getProgramID(_program), static_cast<GLsizei>(names.size()),
+                                  names.data(), GL_INTERLEAVED_ATTRIBS);
+    }
+    // now we have associated this data we can link the shader
+    ngl::ShaderLib::linkProgramObject(_program);
+    if (m_enabled)
+    {
+      saveBinary(ngl::ShaderLib::getProgramID(_program), hash);
+    }
+  }
+  ngl::ShaderLib::use(_program);
+  ngl::ShaderLib::autoRegisterUniforms(_program);
+  info.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return info;
+}
+
+ProgramBuildInfo ProgramCache::build(const ProgramRequest &_request)
+{
+  auto info = build(_request.name, _request.stages, _request.defines, _request.feedbackVaryings);
+  if (_request.setup)
+  {
+    _request.setup();
+  }
+  return info;
+}
+
+bool ProgramCache::enableParallelCompile()
+{
+  auto context = QOpenGLContext::currentContext();
+  if (!context)
+  {
+    return false;
+  }
+  const bool khr = context->hasExtension("GL_KHR_parallel_shader_compile");
+  if (!khr && !context->hasExtension("GL_ARB_parallel_shader_compile"))
+  {
+    return false;
+  }
+  using MaxCompilerThreads = void(QOPENGLF_APIENTRY *)(GLuint);
+  auto maxThreads = reinterpret_cast<MaxCompilerThreads>(
+      context->getProcAddress(khr ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB"));
+  if (maxThreads)
+  {
+    // let the driver pick how many threads
+    maxThreads(0xFFFFFFFF);
+  }
+  return true;
+}
+
+bool ProgramCache::linkCompleted(GLuint _program)
+{
+  GLint done = GL_FALSE;
+  glGetProgramiv(_program, CompletionStatus, &done);
+  return done == GL_TRUE;
+}
@@ -0,0 +1,652 @@
+#include "SoftRasterizer.h"
+#include "TessMath.h"
+#include "TessTrace.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TESS_RASTER_SSE 1
+#endif
+
+namespace tess
+{
+
+namespace
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief sub pixel steps per pixel, positions are snapped to this before the edge functions are built
+  //----------------------------------------------------------------------------------------------------------------------
+  constexpr int SubPixelBits = 4;
+  constexpr int SubPixels = 1 << SubPixelBits;
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief how far off screen (in pixels) a vertex may be before the triangle is clipped, this keeps the sub pixel
+  /// positions inside 18 bits
+  //----------------------------------------------------------------------------------------------------------------------
+  constexpr float GuardPixels = 8192.0f;
+
+#ifdef TESS_RASTER_SSE
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief 2^x for 4 values: x = n + f with n the nearest integer and |f| <= 0.5, 2^f from its series to the f^5
+  /// term (relative error under 3e-6, far below what 8 bit output can show) and 2^n built in the exponent bits
+  //----------------------------------------------------------------------------------------------------------------------
+  __m128 exp2x4(__m128 _x)
+  {
+    const __m128i n = _mm_cvtps_epi32(_x);
+    const __m128 f = _mm_sub_ps(_x, _mm_cvtepi32_ps(n));
+    __m128 p = _mm_set1_ps(1.3333558e-3f);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.6181291e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.5504109e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.4022651e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.9314718e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+    return _mm_mul_ps(p, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23)));
+  }
+
+  // tessfrag.glsl
+  __m128 amplify(__m128 _d, float _scale, float _offset)
+  {
+    _d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(_scale), _d), _mm_set1_ps(_offset));
+    _d = _mm_min_ps(_mm_max_ps(_d, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_sub_ps(_mm_set1_ps(1.0f), exp2x4(_mm_mul_ps(_mm_set1_ps(-2.0f), _mm_mul_ps(_d, _d))));
+  }
+#else
+  // tessfrag.glsl
+  float amplify(float _d, float _scale, float _offset)
+  {
+    _d = _scale * _d + _offset;
+    _d = std::min(1.0f, std::max(0.0f, _d));
+    return 1.0f - std::exp2(-2.0f * _d * _d);
+  }
+#endif
+
+  uint8_t toUnorm8(float _c)
+  {
+    return static_cast<uint8_t>(std::min(1.0f, std::max(0.0f, _c)) * 255.0f + 0.5f);
+  }
+
+  int floorDiv(int64_t _a, int64_t _b)
+  {
+    return static_cast<int>(_a >= 0 ? _a / _b : -((-_a + _b - 1) / _b));
+  }
+
+  bool readToken(std::istream &_in, std::string &o_token)
+  {
+    o_token.clear();
+    char c = 0;
+    while (_in.get(c))
+    {
+      if (c == '#')
+      {
+        std::string comment;
+        std::getline(_in, comment);
+      }
+      else if (!std::isspace(static_cast<unsigned char>(c)))
+      {
+        o_token += c;
+        break;
+      }
+    }
+    while (_in.get(c) && !std::isspace(static_cast<unsigned char>(c)))
+    {
+      o_token += c;
+    }
+    // the single whitespace after the last header field has been read, the pixels follow
+    return !o_token.empty();
+  }
+} // end anonymous namespace
+
+bool writePPM(const std::string &_fname, const RasterImage &_image)
+{
+  std::ofstream out(_fname, std::ios::binary);
+  if (!out)
+  {
+    std::cerr << "Unable to write " << _fname << '\n';
+    return false;
+  }
+  out << "P6\n" << _image.width << ' ' << _image.height << "\n255\n";
+  out.write(reinterpret_cast<const char *>(_image.rgb.data()), static_cast<std::streamsize>(_image.rgb.size()));
+  return static_cast<bool>(out);
+}
+
+bool readPPM(const std::string &_fname, RasterImage &o_image)
+{
+  std::ifstream in(_fname, std::ios::binary);
+  if (!in)
+  {
+    std::cerr << "Unable to open " << _fname << '\n';
+    return false;
+  }
+  std::string magic;
+  std::string width;
+  std::string height;
+  std::string maxValue;
+  if (!readToken(in, magic) || magic != "P6" || !readToken(in, width) || !readToken(in, height) ||
+      !readToken(in, maxValue) || maxValue != "255")
+  {
+    std::cerr << _fname << " is not an 8 bit binary PPM\n";
+    return false;
+  }
+  o_image.resize(std::atoi(width.c_str()), std::atoi(height.c_str()));
+  in.read(reinterpret_cast<char *>(o_image.rgb.data()), static_cast<std::streamsize>(o_image.rgb.size()));
+  if (o_image.width <= 0 || o_image.height <= 0 || !in)
+  {
+    std::cerr << _fname << " is truncated\n";
+    return false;
+  }
+  return true;
+}
+
+ImageDiff compareImages(const RasterImage &_a, const RasterImage &_b, int _tolerance, RasterImage *o_diff)
+{
+  ImageDiff diff;
+  diff.sameSize = _a.width == _b.width && _a.height == _b.height && _a.rgb.size() == _b.rgb.size();
+  if (!diff.sameSize)
+  {
+    return diff;
+  }
+  if (o_diff)
+  {
+    o_diff->resize(_a.width, _a.height);
+  }
+  uint64_t total = 0;
+  const size_t numPixels = _a.rgb.size() / 3;
+  for (size_t p = 0; p < numPixels; ++p)
+  {
+    int pixelMax = 0;
+    for (size_t c = p * 3; c < p * 3 + 3; ++c)
+    {
+      const int d = std::abs(static_cast<int>(_a.rgb[c]) - static_cast<int>(_b.rgb[c]));
+      pixelMax = std::max(pixelMax, d);
+      total += static_cast<uint64_t>(d);
+      if (o_diff)
+      {
+        o_diff->rgb[c] = static_cast<uint8_t>(std::min(255, d * 4));
+      }
+    }
+    diff.maxDifference = std::max(diff.maxDifference, pixelMax);
+    diff.pixelsOver += pixelMax > _tolerance ? 1 : 0;
+  }
+  diff.meanDifference = numPixels ? static_cast<double>(total) / (numPixels * 3) : 0.0;
+  diff.fractionOver = numPixels ? static_cast<double>(diff.pixelsOver) / numPixels : 0.0;
+  return diff;
+}
+
+SoftRasterizer::SoftRasterizer(ThreadPool &_pool) : m_pool(_pool)
+{
+}
+
+bool SoftRasterizer::render(const TessMesh &_mesh, const float *_modelview, const float *_projection,
+                            const RasterShading &_shading, RasterImage &io_image)
+{
+  TESS_TRACE_ZONE("SoftRasterizer::render");
+  if (io_image.width <= 0 || io_image.height <= 0 || io_image.width > MaxImageSize || io_image.height > MaxImageSize)
+  {
+    std::cerr << "SoftRasterizer can't render " << io_image.width << 'x' << io_image.height << " images\n";
+    return false;
+  }
+  m_stats = Stats();
+  m_width = io_image.width;
+  m_height = io_image.height;
+  m_tilesX = (m_width + TileSize - 1) / TileSize;
+  m_tilesY = (m_height + TileSize - 1) / TileSize;
+  const size_t numTiles = static_cast<size_t>(m_tilesX) * m_tilesY;
+  m_guardX = 2.0f * GuardPixels / m_width - 1.0f;
+  m_guardY = 2.0f * GuardPixels / m_height - 1.0f;
+  std::copy(_modelview, _modelview + 16, m_modelview.begin());
+  float MVP[16];
+  multiply(_projection, _modelview, MVP);
+
+  auto start = std::chrono::steady_clock::now();
+  const size_t numVertices = _mesh.numVertices();
+  m_clip.resize(numVertices * 4);
+  m_pool.parallelFor(numVertices, 4096, [&](size_t _begin, size_t _end, size_t)
+                     {
+                       TESS_TRACE_ZONE("transform");
+                       for (size_t v = _begin; v < _end; ++v)
+                       {
+                         transformPoint(MVP, &_mesh.positions[v * 3], &m_clip[v * 4]);
+                       }
+                     });
+  auto binStart = std::chrono::steady_clock::now();
+  m_bins.resize(m_pool.size());
+  for (auto &bins : m_bins)
+  {
+    bins.triangles.clear();
+    bins.tiles.resize(numTiles);
+    for (auto &tile : bins.tiles)
+    {
+      tile.clear();
+    }
+  }
+  m_pool.parallelFor(_mesh.numTriangles(), 1024, [&](size_t _begin, size_t _end, size_t _worker)
+                     {
+                       TESS_TRACE_ZONE("setup and bin");
+                       for (size_t t = _begin; t < _end; ++t)
+                       {
+                         setupTriangle(_mesh, t, _shading, m_bins[_worker]);
+                       }
+                     });
+  auto rasterStart = std::chrono::steady_clock::now();
+  m_depthStride = (m_width + 3) & ~3;
+  m_depth.assign(static_cast<size_t>(m_depthStride) * m_height, 1.0f);
+  m_pool.parallelFor(numTiles, 1, [&](size_t _begin, size_t _end, size_t _worker)
+                     {
+                       TESS_TRACE_ZONE("rasterise tiles");
+                       for (size_t tile = _begin; tile < _end; ++tile)
+                       {
+                         rasteriseTile(tile, _shading, m_bins[_worker], io_image);
+                       }
+                     });
+  auto end = std::chrono::steady_clock::now();
+
+  for (const auto &bins : m_bins)
+  {
+    m_stats.triangles += bins.triangles.size();
+    for (const auto &tile : bins.tiles)
+    {
+      m_stats.binned += tile.size();
+    }
+  }
+  m_stats.tiles = numTiles;
+  m_stats.transformMS = std::chrono::duration<double, std::milli>(binStart - start).count();
+  m_stats.binMS = std::chrono::duration<double, std::milli>(rasterStart - binStart).count();
+  m_stats.rasterMS = std::chrono::duration<double, std::milli>(end - rasterStart).count();
+  return true;
+}
+
+void SoftRasterizer::setupTriangle(const TessMesh &_mesh, size_t _triangle, const RasterShading &_shading, Bins &io_bins)
+{
+  const uint32_t *idx = &_mesh.indices[_triangle * 3];
+  SetupTriangle shared;
+  shared.order = static_cast<uint64_t>(_triangle) * 8;
+  // tessgeom.glsl : NormalMatrix * normalize(cross(p2 - p0, p1 - p0)) then tessfrag.glsl lights it
+  const float *p0 = &_mesh.positions[idx[0] * 3];
+  const float *p1 = &_mesh.positions[idx[1] * 3];
+  const float *p2 = &_mesh.positions[idx[2] * 3];
+  const float e1[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+  const float e2[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+  const float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+  float N[3];
+  for (int r = 0; r < 3; ++r)
+  {
+    N[r] = m_modelview[r] * n[0] + m_modelview[4 + r] * n[1] + m_modelview[8 + r] * n[2];
+  }
+  const float length = std::sqrt(N[0] * N[0] + N[1] * N[1] + N[2] * N[2]);
+  const auto &L = _shading.lightPosition;
+  const float df = length > 0.0f ? std::abs(N[0] * L[0] + N[1] * L[1] + N[2] * L[2]) / length : 0.0f;
+  for (int c = 0; c < 3; ++c)
+  {
+    shared.colour[c] = _shading.ambient[c] + df * _shading.diffuse[c];
+  }
+  for (int v = 0; v < 3; ++v)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      // without patch coordinates there are no patch edges to draw, 1 is the middle of a patch
+      shared.patchDistance[v][c] = _mesh.patchCoords.empty() ? 1.0f : _mesh.patchCoords[idx[v] * 3 + c];
+    }
+  }
+
+  auto &polygon = io_bins.polygon;
+  polygon.resize(3);
+  for (int v = 0; v < 3; ++v)
+  {
+    const float *clip = &m_clip[idx[v] * 4];
+    polygon[v].clip = {{clip[0], clip[1], clip[2], clip[3]}};
+    polygon[v].triDistance = {{v == 0 ? 1.0f : 0.0f, v == 1 ? 1.0f : 0.0f, v == 2 ? 1.0f : 0.0f}};
+  }
+  // near, far and the guard band, each as a distance that is >= 0 inside
+  const float gx = m_guardX;
+  const float gy = m_guardY;
+  auto distance = [gx, gy](int _plane, const ClipVertex &_v)
+  {
+    const auto &c = _v.clip;
+    switch (_plane)
+    {
+    case 0:
+      return c[2] + c[3];
+    case 1:
+      return c[3] - c[2];
+    case 2:
+      return gx * c[3] + c[0];
+    case 3:
+      return gx * c[3] - c[0];
+    case 4:
+      return gy * c[3] + c[1];
+    default:
+      return gy * c[3] - c[1];
+    }
+  };
+  for (int plane = 0; plane < 6 && polygon.size() >= 3; ++plane)
+  {
+    bool allInside = true;
+    for (const auto &v : polygon)
+    {
+      allInside = allInside && distance(plane, v) >= 0.0f;
+    }
+    if (allInside)
+    {
+      continue;
+    }
+    // Sutherland Hodgman, the attributes are linear in clip space so they are interpolated there
+    auto &clipped = io_bins.clipped;
+    clipped.clear();
+    for (size_t i = 0; i < polygon.size(); ++i)
+    {
+      const ClipVertex &a = polygon[i];
+      const ClipVertex &b = polygon[(i + 1) % polygon.size()];
+      const float da = distance(plane, a);
+      const float db = distance(plane, b);
+      if (da >= 0.0f)
+      {
+        clipped.push_back(a);
+      }
+      if ((da >= 0.0f) != (db >= 0.0f))
+      {
+        const float t = da / (da - db);
+        ClipVertex v;
+        for (int c = 0; c < 4; ++c)
+        {
+          v.clip[c] = a.clip[c] + t * (b.clip[c] - a.clip[c]);
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+          v.triDistance[c] = a.triDistance[c] + t * (b.triDistance[c] - a.triDistance[c]);
+        }
+        clipped.push_back(v);
+      }
+    }
+    polygon.swap(clipped);
+  }
+  for (size_t i = 1; i + 1 < polygon.size(); ++i)
+  {
+    shared.order = static_cast<uint64_t>(_triangle) * 8 + (i - 1);
+    addTriangle(polygon[0], polygon[i], polygon[i + 1], shared, io_bins);
+  }
+}
+
+void SoftRasterizer::addTriangle(const ClipVertex &_v0, const ClipVertex &_v1, const ClipVertex &_v2,
+                                 const SetupTriangle &_shared, Bins &io_bins)
+{
+  SetupTriangle t = _shared;
+  const ClipVertex *v[3] = {&_v0, &_v1, &_v2};
+  for (int i = 0; i < 3; ++i)
+  {
+    const auto &c = v[i]->clip;
+    const float invW = 1.0f / c[3];
+    // image rows go top to bottom so y is flipped on the way to pixels
+    t.x[i] = static_cast<int32_t>(std::lround((c[0] * invW * 0.5f + 0.5f) * m_width * SubPixels));
+    t.y[i] = static_cast<int32_t>(std::lround((0.5f - c[1] * invW * 0.5f) * m_height * SubPixels));
+    t.depth[i] = c[2] * invW * 0.5f + 0.5f;
+    t.invW[i] = invW;
+    t.triDistance[i] = v[i]->triDistance;
+  }
+  auto area = [&t]()
+  {
+    return static_cast<int64_t>(t.x[2] - t.x[1]) * (t.y[0] - t.y[1]) - static_cast<int64_t>(t.y[2] - t.y[1]) * (t.x[0] - t.x[1]);
+  };
+  int64_t twiceArea = area();
+  if (twiceArea == 0)
+  {
+    return;
+  }
+  if (twiceArea < 0)
+  {
+    // there is no face culling in the GL path so both windings are drawn, flip to keep the edge tests one way
+    std::swap(t.x[1], t.x[2]);
+    std::swap(t.y[1], t.y[2]);
+    std::swap(t.depth[1], t.depth[2]);
+    std::swap(t.invW[1], t.invW[2]);
+    std::swap(t.triDistance[1], t.triDistance[2]);
+    twiceArea = -twiceArea;
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    const int a = (i + 1) % 3;
+    const int b = (i + 2) % 3;
+    t.a[i] = t.y[a] - t.y[b];
+    t.b[i] = t.x[b] - t.x[a];
+    // a shared edge has opposite coefficients in its two triangles so exactly one of them owns pixels on it
+    t.bias[i] = t.a[i] > 0 || (t.a[i] == 0 && t.b[i] > 0) ? 0 : 1;
+  }
+  t.invArea = 1.0 / static_cast<double>(twiceArea);
+  // pixels whose centre (x * SubPixels + SubPixels / 2) is inside the bounds
+  const int half = SubPixels / 2;
+  t.minX = std::max(0, -floorDiv(-(static_cast<int64_t>(*std::min_element(t.x.begin(), t.x.end())) - half), SubPixels));
+  t.minY = std::max(0, -floorDiv(-(static_cast<int64_t>(*std::min_element(t.y.begin(), t.y.end())) - half), SubPixels));
+  t.maxX = std::min(m_width - 1, floorDiv(*std::max_element(t.x.begin(), t.x.end()) - half, SubPixels));
+  t.maxY = std::min(m_height - 1, floorDiv(*std::max_element(t.y.begin(), t.y.end()) - half, SubPixels));
+  if (t.minX > t.maxX || t.minY > t.maxY)
+  {
+    return;
+  }
+  const auto index = static_cast<uint32_t>(io_bins.triangles.size());
+  io_bins.triangles.push_back(t);
+  for (int ty = t.minY / TileSize; ty <= t.maxY / TileSize; ++ty)
+  {
+    for (int tx = t.minX / TileSize; tx <= t.maxX / TileSize; ++tx)
+    {
+      io_bins.tiles[static_cast<size_t>(ty) * m_tilesX + tx].push_back(index);
+    }
+  }
+}
+
+void SoftRasterizer::rasteriseTile(size_t _tile, const RasterShading &_shading, Bins &io_scratch, RasterImage &io_image)
+{
+  const int x0 = static_cast<int>(_tile % m_tilesX) * TileSize;
+  const int y0 = static_cast<int>(_tile / m_tilesX) * TileSize;
+  const int x1 = std::min(x0 + TileSize, m_width);
+  const int y1 = std::min(y0 + TileSize, m_height);
+  const uint8_t clear[3] = {toUnorm8(_shading.clearColour[0]), toUnorm8(_shading.clearColour[1]), toUnorm8(_shading.clearColour[2])};
+  for (int y = y0; y < y1; ++y)
+  {
+    uint8_t *row = &io_image.rgb[(static_cast<size_t>(y) * m_width + x0) * 3];
+    for (int x = x0; x < x1; ++x, row += 3)
+    {
+      row[0] = clear[0];
+      row[1] = clear[1];
+      row[2] = clear[2];
+    }
+  }
+  auto &triangles = io_scratch.scratch;
+  triangles.clear();
+  for (const auto &bins : m_bins)
+  {
+    for (auto index : bins.tiles[_tile])
+    {
+      triangles.push_back(&bins.triangles[index]);
+    }
+  }
+  std::sort(triangles.begin(), triangles.end(), [](const SetupTriangle *_a, const SetupTriangle *_b) { return _a->order < _b->order; });
+  for (auto t : triangles)
+  {
+    drawTriangle(*t, x0, y0, x1, y1, io_image);
+  }
+}
+
+void SoftRasterizer::drawTriangle(const SetupTriangle &_t, int _x0, int _y0, int _x1, int _y1, RasterImage &io_image)
+{
+  // start on a multiple of 4 so every 4 pixel step stays inside the tile, pixels left of minX fail the edge tests
+  const int x0 = std::max(_x0, _t.minX) & ~3;
+  const int y0 = std::max(_y0, _t.minY);
+  const int x1 = std::min(_x1, _t.maxX + 1);
+  const int y1 = std::min(_y1, _t.maxY + 1);
+  if (x0 >= x1 || y0 >= y1)
+  {
+    return;
+  }
+  const int lastX = ((x1 - x0 + 3) & ~3) - 1;
+  const int lastY = y1 - y0 - 1;
+  const int64_t px = static_cast<int64_t>(x0) * SubPixels + SubPixels / 2;
+  const int64_t py = static_cast<int64_t>(y0) * SubPixels + SubPixels / 2;
+  int32_t e[3];
+  int32_t stepX[3];
+  int32_t stepY[3];
+  float l[3];
+  float dlx[3];
+  float dly[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    const int a = (i + 1) % 3;
+    const int64_t exact = static_cast<int64_t>(_t.a[i]) * (px - _t.x[a]) + static_cast<int64_t>(_t.b[i]) * (py - _t.y[a]);
+    const int64_t dx = static_cast<int64_t>(_t.a[i]) * SubPixels;
+    const int64_t dy = static_cast<int64_t>(_t.b[i]) * SubPixels;
+    l[i] = static_cast<float>(exact * _t.invArea);
+    dlx[i] = static_cast<float>(dx * _t.invArea);
+    dly[i] = static_cast<float>(dy * _t.invArea);
+    // decide the edge for the whole rectangle if we can, otherwise its values fit in 32 bits across it
+    const int64_t biased = exact - _t.bias[i];
+    const int64_t lo = biased + std::min<int64_t>(0, dx * lastX) + std::min<int64_t>(0, dy * lastY);
+    const int64_t hi = biased + std::max<int64_t>(0, dx * lastX) + std::max<int64_t>(0, dy * lastY);
+    if (hi < 0)
+    {
+      return;
+    }
+    const bool inside = lo >= 0;
+    e[i] = inside ? 0 : static_cast<int32_t>(biased);
+    stepX[i] = inside ? 0 : static_cast<int32_t>(dx);
+    stepY[i] = inside ? 0 : static_cast<int32_t>(dy);
+  }
+  const float depth0 = _t.depth[0];
+  const float depth1 = _t.depth[1] - _t.depth[0];
+  const float depth2 = _t.depth[2] - _t.depth[0];
+#ifdef TESS_RASTER_SSE
+  const __m128i laneX[3] = {_mm_set_epi32(3 * stepX[0], 2 * stepX[0], stepX[0], 0),
+                            _mm_set_epi32(3 * stepX[1], 2 * stepX[1], stepX[1], 0),
+                            _mm_set_epi32(3 * stepX[2], 2 * stepX[2], stepX[2], 0)};
+  const __m128i step4[3] = {_mm_set1_epi32(4 * stepX[0]), _mm_set1_epi32(4 * stepX[1]), _mm_set1_epi32(4 * stepX[2])};
+  const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+  const __m128 dl1x4 = _mm_set1_ps(4.0f * dlx[1]);
+  const __m128 dl2x4 = _mm_set1_ps(4.0f * dlx[2]);
+  const __m128 d0 = _mm_set1_ps(depth0);
+  const __m128 d1 = _mm_set1_ps(depth1);
+  const __m128 d2 = _mm_set1_ps(depth2);
+  const __m128i minusOne = _mm_set1_epi32(-1);
+  const __m128i end = _mm_set1_epi32(x1);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 invW[3] = {_mm_set1_ps(_t.invW[0]), _mm_set1_ps(_t.invW[1]), _mm_set1_ps(_t.invW[2])};
+  alignas(16) int32_t rgb[3][4];
+  for (int y = y0; y < y1; ++y)
+  {
+    const int row = y - y0;
+    __m128i e0 = _mm_add_epi32(_mm_set1_epi32(e[0] + row * stepY[0]), laneX[0]);
+    __m128i e1 = _mm_add_epi32(_mm_set1_epi32(e[1] + row * stepY[1]), laneX[1]);
+    __m128i e2 = _mm_add_epi32(_mm_set1_epi32(e[2] + row * stepY[2]), laneX[2]);
+    __m128 l1 = _mm_add_ps(_mm_set1_ps(l[1] + row * dly[1]), _mm_mul_ps(lanes, _mm_set1_ps(dlx[1])));
+    __m128 l2 = _mm_add_ps(_mm_set1_ps(l[2] + row * dly[2]), _mm_mul_ps(lanes, _mm_set1_ps(dlx[2])));
+    float *depthRow = &m_depth[static_cast<size_t>(y) * m_depthStride];
+    uint8_t *rgbRow = &io_image.rgb[static_cast<size_t>(y) * m_width * 3];
+    for (int x = x0; x < x1; x += 4)
+    {
+      // a pixel is in when no edge function is negative, i.e. the sign bit of their or is clear
+      __m128i in = _mm_cmpgt_epi32(_mm_or_si128(e0, _mm_or_si128(e1, e2)), minusOne);
+      in = _mm_and_si128(in, _mm_cmplt_epi32(_mm_set_epi32(x + 3, x + 2, x + 1, x), end));
+      const __m128 z = _mm_add_ps(d0, _mm_add_ps(_mm_mul_ps(l1, d1), _mm_mul_ps(l2, d2)));
+      const __m128 stored = _mm_loadu_ps(depthRow + x);
+      const __m128 pass = _mm_and_ps(_mm_castsi128_ps(in), _mm_cmplt_ps(z, stored));
+      const int mask = _mm_movemask_ps(pass);
+      if (mask)
+      {
+        _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, stored)));
+        // the same sums as shade() 4 pixels at a time
+        const __m128 q0 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, l1), l2), invW[0]);
+        const __m128 q1 = _mm_mul_ps(l1, invW[1]);
+        const __m128 q2 = _mm_mul_ps(l2, invW[2]);
+        const __m128 s = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(q0, q1), q2));
+        __m128 tri[3];
+        for (int c = 0; c < 3; ++c)
+        {
+          tri[c] = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(q0, _mm_set1_ps(_t.triDistance[0][c])),
+                                                    _mm_mul_ps(q1, _mm_set1_ps(_t.triDistance[1][c]))),
+                                         _mm_mul_ps(q2, _mm_set1_ps(_t.triDistance[2][c]))),
+                              s);
+        }
+        __m128 patch[3];
+        for (int c = 0; c < 3; ++c)
+        {
+          patch[c] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tri[0], _mm_set1_ps(_t.patchDistance[0][c])),
+                                           _mm_mul_ps(tri[1], _mm_set1_ps(_t.patchDistance[1][c]))),
+                                _mm_mul_ps(tri[2], _mm_set1_ps(_t.patchDistance[2][c])));
+        }
+        const __m128 f = _mm_mul_ps(amplify(_mm_min_ps(_mm_min_ps(tri[0], tri[1]), tri[2]), 40.0f, -0.5f),
+                                    amplify(_mm_min_ps(_mm_min_ps(patch[0], patch[1]), patch[2]), 60.0f, -0.5f));
+        for (int c = 0; c < 3; ++c)
+        {
+          const __m128 colour = _mm_min_ps(_mm_max_ps(_mm_mul_ps(f, _mm_set1_ps(_t.colour[c])), _mm_setzero_ps()), one);
+          _mm_store_si128(reinterpret_cast<__m128i *>(rgb[c]),
+                          _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(colour, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f))));
+        }
+        for (int k = 0; k < 4; ++k)
+        {
+          if (mask & (1 << k))
+          {
+            uint8_t *out = rgbRow + (x + k) * 3;
+            out[0] = static_cast<uint8_t>(rgb[0][k]);
+            out[1] = static_cast<uint8_t>(rgb[1][k]);
+            out[2] = static_cast<uint8_t>(rgb[2][k]);
+          }
+        }
+      }
+      e0 = _mm_add_epi32(e0, step4[0]);
+      e1 = _mm_add_epi32(e1, step4[1]);
+      e2 = _mm_add_epi32(e2, step4[2]);
+      l1 = _mm_add_ps(l1, dl1x4);
+      l2 = _mm_add_ps(l2, dl2x4);
+    }
+  }
+#else
+  auto shade = [&_t](float _l1, float _l2, uint8_t *o_rgb)
+  {
+    const float q0 = (1.0f - _l1 - _l2) * _t.invW[0];
+    const float q1 = _l1 * _t.invW[1];
+    const float q2 = _l2 * _t.invW[2];
+    const float s = 1.0f / (q0 + q1 + q2);
+    float tri[3];
+    for (int c = 0; c < 3; ++c)
+    {
+      tri[c] = (q0 * _t.triDistance[0][c] + q1 * _t.triDistance[1][c] + q2 * _t.triDistance[2][c]) * s;
+    }
+    float patch[3];
+    for (int c = 0; c < 3; ++c)
+    {
+      patch[c] = tri[0] * _t.patchDistance[0][c] + tri[1] * _t.patchDistance[1][c] + tri[2] * _t.patchDistance[2][c];
+    }
+    const float d1 = std::min(std::min(tri[0], tri[1]), tri[2]);
+    const float d2 = std::min(std::min(patch[0], patch[1]), patch[2]);
+    const float f = amplify(d1, 40.0f, -0.5f) * amplify(d2, 60.0f, -0.5f);
+    o_rgb[0] = toUnorm8(f * _t.colour[0]);
+    o_rgb[1] = toUnorm8(f * _t.colour[1]);
+    o_rgb[2] = toUnorm8(f * _t.colour[2]);
+  };
+  for (int y = y0; y < y1; ++y)
+  {
+    const int row = y - y0;
+    float *depthRow = &m_depth[static_cast<size_t>(y) * m_depthStride];
+    uint8_t *rgbRow = &io_image.rgb[static_cast<size_t>(y) * m_width * 3];
+    for (int x = x0; x < x1; ++x)
+    {
+      const int column = x - x0;
+      if ((e[0] + row * stepY[0] + column * stepX[0]) < 0 || (e[1] + row * stepY[1] + column * stepX[1]) < 0 ||
+          (e[2] + row * stepY[2] + column * stepX[2]) < 0)
+      {
+        continue;
+      }
+      const float l1 = l[1] + row * dly[1] + column * dlx[1];
+      const float l2 = l[2] + row * dly[2] + column * dlx[2];
+      const float z = depth0 + l1 * depth1 + l2 * depth2;
+      if (z < depthRow[x])
+      {
+        depthRow[x] = z;
+        shade(l1, l2, rgbRow + x * 3);
+      }
+    }
+  }
+#endif
+}
+
+} // end namespace tess
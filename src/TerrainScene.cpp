@@ -0,0 +1,255 @@
+#include "TerrainScene.h"
+#include "TessMath.h"
+#include "TessTrace.h"
+#include "TessUniforms.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+TerrainScene::TerrainScene(const std::string &_fname)
+{
+  // a tile is one layer of the pool, so its side is limited by the largest texture and by PoolBudgetBytes
+  GLint maxTextureSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  const uint32_t maxSamples = std::min(static_cast<uint32_t>(std::max(1, maxTextureSize)), maxPoolSamples());
+  if (_fname.empty() || !m_loader.open(_fname, maxSamples))
+  {
+    m_loader.openProcedural(tess::TerrainInfo());
+  }
+  m_layers.resize(PoolLayers);
+  glGenTextures(1, &m_heightTexture);
+  if (!allocatePool() && !m_loader.procedural())
+  {
+    std::cerr << "No GPU memory for " << PoolLayers << " tiles of " << info().samples() << " samples, generating the terrain instead\n";
+    m_loader.openProcedural(tess::TerrainInfo());
+    allocatePool();
+  }
+  const tess::TerrainInfo &terrain = m_loader.info();
+  m_tileLayer.assign(static_cast<size_t>(terrain.numTiles()), -1);
+
+  // one tile's grid of patches, each patch's corners in the order terraineval.glsl expects
+  std::vector<float> corners;
+  corners.reserve(PatchesPerTile * PatchesPerTile * 8);
+  const float step = 1.0f / PatchesPerTile;
+  for (int z = 0; z < PatchesPerTile; ++z)
+  {
+    for (int x = 0; x < PatchesPerTile; ++x)
+    {
+      const float u0 = x * step;
+      const float v0 = z * step;
+      const float u1 = (x + 1) * step;
+      const float v1 = (z + 1) * step;
+      corners.insert(corners.end(), {u0, v0, u1, v0, u1, v1, u0, v1});
+    }
+  }
+  glGenVertexArrays(1, &m_vao);
+  glBindVertexArray(m_vao);
+  glGenBuffers(1, &m_patchBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_patchBuffer);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(corners.size() * sizeof(float)), corners.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+  // a tile can't be drawn without a layer so the pool size bounds the instances too
+  const size_t tileBytes = PoolLayers * 3 * sizeof(float);
+  glGenBuffers(1, &m_tileBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_tileBuffer);
+  glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(tileBytes), nullptr, GL_STREAM_DRAW);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+  glVertexAttribDivisor(1, 1);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  m_bytes = PoolLayers * terrain.tileBytes() + corners.size() * sizeof(float) + tileBytes;
+  updateCamera(0.0f, 0.0f);
+}
+
+uint32_t TerrainScene::maxPoolSamples()
+{
+  return static_cast<uint32_t>(std::sqrt(static_cast<double>(PoolBudgetBytes) / (PoolLayers * sizeof(uint16_t))));
+}
+
+bool TerrainScene::allocatePool()
+{
+  // the whole pool is allocated here and never grows. Earlier errors are cleared first so that only the
+  // allocation's own is seen
+  while (glGetError() != GL_NO_ERROR)
+  {
+  }
+  const GLsizei samples = static_cast<GLsizei>(info().samples());
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_heightTexture);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16, samples, samples, PoolLayers, 0, GL_RED, GL_UNSIGNED_SHORT, nullptr);
+  const bool allocated = glGetError() == GL_NO_ERROR;
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  return allocated;
+}
+
+TerrainScene::~TerrainScene()
+{
+  glDeleteTextures(1, &m_heightTexture);
+  glDeleteBuffers(1, &m_patchBuffer);
+  glDeleteBuffers(1, &m_tileBuffer);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void TerrainScene::update(float _yaw, float _pitch)
+{
+  TESS_TRACE_ZONE("TerrainScene::update");
+  // frame 0 is never wanted, so layers that have never been used are the first to be taken
+  ++m_frame;
+  m_distance += FlightSpeed;
+  updateCamera(_yaw, _pitch);
+  updateTiles();
+}
+
+void TerrainScene::updateCamera(float _yaw, float _pitch)
+{
+  // a circle around the middle of the terrain just above the highest height a tile can have
+  const tess::TerrainInfo &terrain = info();
+  const float width = terrain.tilesX * terrain.tileSize;
+  const float depth = terrain.tilesZ * terrain.tileSize;
+  const float radius = 0.35f * std::min(width, depth);
+  const float angle = m_distance / radius;
+  m_eye[0] = 0.5f * width + radius * std::cos(angle);
+  m_eye[1] = 1.1f * terrain.heightScale;
+  m_eye[2] = 0.5f * depth + radius * std::sin(angle);
+  // along the tangent of the circle, turned by the mouse and looking down a little
+  constexpr float degrees = 3.14159265f / 180.0f;
+  const float heading = angle + 0.5f * 3.14159265f - _yaw * degrees;
+  const float pitch = std::min(85.0f, std::max(-85.0f, _pitch - 20.0f)) * degrees;
+  const float centre[3] = {m_eye[0] + std::cos(pitch) * std::cos(heading), m_eye[1] + std::sin(pitch),
+                           m_eye[2] + std::cos(pitch) * std::sin(heading)};
+  const float up[3] = {0.0f, 1.0f, 0.0f};
+  tess::lookAt(m_eye, centre, up, m_view);
+}
+
+void TerrainScene::updateTiles()
+{
+  TESS_TRACE_ZONE("TerrainScene::updateTiles");
+  const tess::TerrainInfo &terrain = info();
+  const int cameraX = static_cast<int>(std::floor(m_eye[0] / terrain.tileSize));
+  const int cameraZ = static_cast<int>(std::floor(m_eye[2] / terrain.tileSize));
+  std::vector<uint32_t> wanted;
+  for (int z = std::max(0, cameraZ - ResidentRadius); z <= std::min<int>(terrain.tilesZ - 1, cameraZ + ResidentRadius); ++z)
+  {
+    for (int x = std::max(0, cameraX - ResidentRadius); x <= std::min<int>(terrain.tilesX - 1, cameraX + ResidentRadius); ++x)
+    {
+      wanted.push_back(static_cast<uint32_t>(z) * terrain.tilesX + static_cast<uint32_t>(x));
+    }
+  }
+  auto distance = [&](uint32_t _tile)
+  {
+    const float dx = ((_tile % terrain.tilesX) + 0.5f) * terrain.tileSize - m_eye[0];
+    const float dz = ((_tile / terrain.tilesX) + 0.5f) * terrain.tileSize - m_eye[2];
+    return dx * dx + dz * dz;
+  };
+  std::sort(wanted.begin(), wanted.end(), [&](uint32_t _a, uint32_t _b) { return distance(_a) < distance(_b); });
+  for (uint32_t tile : wanted)
+  {
+    if (m_tileLayer[tile] >= 0)
+    {
+      m_layers[m_tileLayer[tile]].lastWanted = m_frame;
+    }
+  }
+
+  // upload the nearest of the tiles that have arrived, the rest wait for the next frame
+  m_loader.collect(m_arrived);
+  int uploads = 0;
+  std::vector<uint32_t> missing;
+  for (uint32_t tile : wanted)
+  {
+    if (m_tileLayer[tile] >= 0)
+    {
+      continue;
+    }
+    auto arrived = std::find_if(m_arrived.begin(), m_arrived.end(), [tile](const tess::TerrainTile &_tile) { return _tile.index == tile; });
+    if (arrived == m_arrived.end())
+    {
+      missing.push_back(tile);
+      continue;
+    }
+    if (uploads == UploadsPerFrame)
+    {
+      continue;
+    }
+    // a free layer or the one whose tile has been away from the camera longest
+    auto layer = std::min_element(m_layers.begin(), m_layers.end(), [](const Layer &_a, const Layer &_b) { return _a.lastWanted < _b.lastWanted; });
+    if (layer->lastWanted == m_frame)
+    {
+      continue;
+    }
+    if (layer->tile >= 0)
+    {
+      m_tileLayer[static_cast<size_t>(layer->tile)] = -1;
+    }
+    const int index = static_cast<int>(layer - m_layers.begin());
+    upload(*arrived, index);
+    layer->tile = tile;
+    layer->lastWanted = m_frame;
+    m_tileLayer[tile] = index;
+    ++uploads;
+  }
+  // tiles the camera has already left are dropped, they are loaded again if it comes back
+  m_arrived.erase(std::remove_if(m_arrived.begin(), m_arrived.end(),
+                                 [&](const tess::TerrainTile &_tile)
+                                 { return m_tileLayer[_tile.index] >= 0 || std::find(wanted.begin(), wanted.end(), _tile.index) == wanted.end(); }),
+                  m_arrived.end());
+  m_loader.request(missing);
+
+  m_drawTiles.clear();
+  for (uint32_t tile : wanted)
+  {
+    if (m_tileLayer[tile] >= 0)
+    {
+      m_drawTiles.insert(m_drawTiles.end(), {static_cast<float>(tile % terrain.tilesX), static_cast<float>(tile / terrain.tilesX),
+                                             static_cast<float>(m_tileLayer[tile])});
+    }
+  }
+  m_residentTiles = static_cast<size_t>(std::count_if(m_layers.begin(), m_layers.end(), [](const Layer &_layer) { return _layer.tile >= 0; }));
+  if (!m_drawTiles.empty())
+  {
+    glBindBuffer(GL_ARRAY_BUFFER, m_tileBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(m_drawTiles.size() * sizeof(float)), m_drawTiles.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+}
+
+void TerrainScene::upload(const tess::TerrainTile &_tile, int _layer)
+{
+  const GLsizei samples = static_cast<GLsizei>(info().samples());
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_heightTexture);
+  // rows of an odd number of 16 bit samples aren't 4 byte aligned
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+  glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, _layer, samples, samples, 1, GL_RED, GL_UNSIGNED_SHORT, _tile.heights.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  ++m_uploads;
+}
+
+void TerrainScene::setProgramUniforms(GLuint _program) const
+{
+  const tess::TerrainInfo &terrain = info();
+  glProgramUniform1f(_program, glGetUniformLocation(_program, "TileSize"), terrain.tileSize);
+  glProgramUniform1f(_program, glGetUniformLocation(_program, "HeightScale"), terrain.heightScale);
+  glProgramUniform1f(_program, glGetUniformLocation(_program, "TileSamples"), static_cast<float>(terrain.samples()));
+  glProgramUniform1f(_program, glGetUniformLocation(_program, "PatchSamples"),
+                     std::min(64.0f, std::max(1.0f, static_cast<float>(terrain.resolution) / PatchesPerTile)));
+}
+
+void TerrainScene::draw() const
+{
+  if (m_drawTiles.empty())
+  {
+    return;
+  }
+  glActiveTexture(GL_TEXTURE0 + TerrainHeightTextureUnit);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, m_heightTexture);
+  glActiveTexture(GL_TEXTURE0);
+  glBindVertexArray(m_vao);
+  glDrawArraysInstanced(GL_PATCHES, 0, PatchesPerTile * PatchesPerTile * 4, static_cast<GLsizei>(drawnTiles()));
+  glBindVertexArray(0);
+}
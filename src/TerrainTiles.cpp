@@ -0,0 +1,303 @@
+#include "TerrainTiles.h"
+#include "TessTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace tess
+{
+
+namespace
+{
+  // integer hash of a lattice point, [0,1)
+  float lattice(int32_t _x, int32_t _z, uint32_t _seed)
+  {
+    uint32_t h = static_cast<uint32_t>(_x) * 0x8da6b343u ^ static_cast<uint32_t>(_z) * 0xd8163841u ^ _seed * 0xcb1ab31fu;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    h *= 0x297a2d39u;
+    h ^= h >> 15;
+    return (h & 0xffffffu) / 16777216.0f;
+  }
+
+  float valueNoise(float _x, float _z, uint32_t _seed)
+  {
+    const float fx = std::floor(_x);
+    const float fz = std::floor(_z);
+    const int32_t ix = static_cast<int32_t>(fx);
+    const int32_t iz = static_cast<int32_t>(fz);
+    float tx = _x - fx;
+    float tz = _z - fz;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+    const float row0 = lattice(ix, iz, _seed) + (lattice(ix + 1, iz, _seed) - lattice(ix, iz, _seed)) * tx;
+    const float row1 = lattice(ix, iz + 1, _seed) + (lattice(ix + 1, iz + 1, _seed) - lattice(ix, iz + 1, _seed)) * tx;
+    return row0 + (row1 - row0) * tz;
+  }
+
+  constexpr int Octaves = 7;
+  // lowest octave in samples, about two tiles at the default resolution
+  constexpr float BaseWavelength = 256.0f;
+} // end anonymous namespace
+
+bool TerrainInfo::valid() const
+{
+  return resolution > 0 && resolution <= MaxTerrainResolution && tilesX > 0 && tilesX <= MaxTerrainTilesPerSide && tilesZ > 0 &&
+         tilesZ <= MaxTerrainTilesPerSide && std::isfinite(tileSize) && tileSize > 0.0f && std::isfinite(heightScale) &&
+         heightScale > 0.0f;
+}
+
+void generateTerrainTile(const TerrainInfo &_info, uint32_t _x, uint32_t _z, uint16_t *o_heights)
+{
+  const uint32_t samples = _info.samples();
+  float norm = 0.0f;
+  for (int octave = 0; octave < Octaves; ++octave)
+  {
+    norm += std::pow(0.5f, static_cast<float>(octave));
+  }
+  for (uint32_t j = 0; j < samples; ++j)
+  {
+    for (uint32_t i = 0; i < samples; ++i)
+    {
+      // global sample position, the same for both tiles that share an edge
+      const float gx = static_cast<float>(_x * _info.resolution + i) / BaseWavelength;
+      const float gz = static_cast<float>(_z * _info.resolution + j) / BaseWavelength;
+      float h = 0.0f;
+      float amplitude = 1.0f;
+      float frequency = 1.0f;
+      for (int octave = 0; octave < Octaves; ++octave)
+      {
+        h += amplitude * valueNoise(gx * frequency, gz * frequency, _info.seed + static_cast<uint32_t>(octave));
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+      }
+      // squaring flattens the valleys and sharpens the peaks
+      h /= norm;
+      h *= h;
+      o_heights[j * samples + i] = static_cast<uint16_t>(std::min(1.0f, std::max(0.0f, h)) * 65535.0f + 0.5f);
+    }
+  }
+}
+
+bool writeTerrainFile(const std::string &_fname, const TerrainInfo &_info)
+{
+  std::ofstream out(_fname, std::ios::binary);
+  if (!out)
+  {
+    std::cerr << "Unable to write " << _fname << '\n';
+    return false;
+  }
+  TerrainFileHeader header;
+  header.resolution = _info.resolution;
+  header.tilesX = _info.tilesX;
+  header.tilesZ = _info.tilesZ;
+  header.tileSize = _info.tileSize;
+  header.heightScale = _info.heightScale;
+  header.seed = _info.seed;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  std::vector<uint16_t> heights(_info.tileBytes() / sizeof(uint16_t));
+  for (uint32_t z = 0; z < _info.tilesZ; ++z)
+  {
+    for (uint32_t x = 0; x < _info.tilesX; ++x)
+    {
+      generateTerrainTile(_info, x, z, heights.data());
+      out.write(reinterpret_cast<const char *>(heights.data()), static_cast<std::streamsize>(_info.tileBytes()));
+    }
+  }
+  return static_cast<bool>(out);
+}
+
+TerrainTileLoader::~TerrainTileLoader()
+{
+  stop();
+}
+
+bool TerrainTileLoader::open(const std::string &_fname, uint32_t _maxSamples)
+{
+  stop();
+  m_file.close();
+  m_file.clear();
+  m_file.open(_fname, std::ios::binary);
+  if (!m_file)
+  {
+    std::cerr << "Unable to open " << _fname << '\n';
+    return false;
+  }
+  TerrainFileHeader header;
+  m_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!m_file || std::string(header.magic, 4) != "THTF" || header.version != TerrainFileVersion)
+  {
+    std::cerr << _fname << " is not a .tht terrain\n";
+    m_file.close();
+    return false;
+  }
+  TerrainInfo info;
+  info.resolution = header.resolution;
+  info.tilesX = header.tilesX;
+  info.tilesZ = header.tilesZ;
+  info.tileSize = header.tileSize;
+  info.heightScale = header.heightScale;
+  info.seed = header.seed;
+  if (!info.valid() || (_maxSamples > 0 && info.samples() > _maxSamples))
+  {
+    std::cerr << _fname << " has " << header.tilesX << " x " << header.tilesZ << " tiles of " << header.resolution
+              << " quads, size " << header.tileSize << " height " << header.heightScale << ", not a terrain that can be shown\n";
+    m_file.close();
+    return false;
+  }
+  // the limits keep the tile data well inside 64 bits, only the offset comes straight from the file
+  m_file.seekg(0, std::ios::end);
+  const uint64_t size = static_cast<uint64_t>(m_file.tellg());
+  const uint64_t tileData = info.numTiles() * info.tileBytes();
+  if (header.tilesOffset < sizeof(TerrainFileHeader) || size < header.tilesOffset || size - header.tilesOffset < tileData)
+  {
+    std::cerr << _fname << " is truncated\n";
+    m_file.close();
+    return false;
+  }
+  m_info = info;
+  m_tilesOffset = header.tilesOffset;
+  m_fname = _fname;
+  m_procedural = false;
+  start();
+  return true;
+}
+
+void TerrainTileLoader::openProcedural(const TerrainInfo &_info)
+{
+  stop();
+  m_file.close();
+  m_info = _info;
+  m_fname.clear();
+  m_procedural = true;
+  start();
+}
+
+void TerrainTileLoader::start()
+{
+  m_quit = false;
+  m_thread = std::thread(&TerrainTileLoader::loaderLoop, this);
+}
+
+void TerrainTileLoader::stop()
+{
+  if (!m_thread.joinable())
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+    m_queue.clear();
+  }
+  m_wake.notify_one();
+  m_thread.join();
+}
+
+void TerrainTileLoader::request(const std::vector<uint32_t> &_tiles)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.clear();
+    for (uint32_t index : _tiles)
+    {
+      // the tile being read and the finished ones are already on their way
+      const bool done = std::any_of(m_done.begin(), m_done.end(), [index](const TerrainTile &_tile) { return _tile.index == index; });
+      if (index != m_loading && !done)
+      {
+        m_queue.push_back(index);
+      }
+    }
+  }
+  m_wake.notify_one();
+}
+
+void TerrainTileLoader::collect(std::vector<TerrainTile> &o_tiles)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto &tile : m_done)
+  {
+    o_tiles.push_back(std::move(tile));
+  }
+  m_done.clear();
+}
+
+size_t TerrainTileLoader::queued() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_queue.size();
+}
+
+size_t TerrainTileLoader::tilesLoaded() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_loaded;
+}
+
+float TerrainTileLoader::averageLoadMS() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_loaded > 0 ? static_cast<float>(m_loadMS / m_loaded) : 0.0f;
+}
+
+void TerrainTileLoader::loaderLoop()
+{
+  Trace::setThreadName("terrain loader");
+  for (;;)
+  {
+    uint32_t index = 0;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [this]() { return m_quit || !m_queue.empty(); });
+      if (m_quit)
+      {
+        return;
+      }
+      index = m_queue.front();
+      m_queue.pop_front();
+      m_loading = index;
+    }
+    auto start = std::chrono::steady_clock::now();
+    TerrainTile tile;
+    const bool loaded = load(index, tile);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_loading = NoTile;
+    if (!loaded)
+    {
+      continue;
+    }
+    m_done.push_back(std::move(tile));
+    ++m_loaded;
+    m_loadMS += ms;
+  }
+}
+
+bool TerrainTileLoader::load(uint32_t _index, TerrainTile &o_tile)
+{
+  TESS_TRACE_ZONE("TerrainTileLoader::load");
+  if (_index >= m_info.numTiles())
+  {
+    return false;
+  }
+  o_tile.index = _index;
+  o_tile.heights.resize(m_info.tileBytes() / sizeof(uint16_t));
+  if (m_procedural)
+  {
+    generateTerrainTile(m_info, _index % m_info.tilesX, _index / m_info.tilesX, o_tile.heights.data());
+    return true;
+  }
+  m_file.clear();
+  m_file.seekg(static_cast<std::streamoff>(m_tilesOffset + static_cast<uint64_t>(_index) * m_info.tileBytes()));
+  m_file.read(reinterpret_cast<char *>(o_tile.heights.data()), static_cast<std::streamsize>(m_info.tileBytes()));
+  if (!m_file)
+  {
+    std::cerr << "Unable to read terrain tile " << _index << " of " << m_fname << '\n';
+    return false;
+  }
+  return true;
+}
+
+} // end namespace tess
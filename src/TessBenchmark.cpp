@@ -0,0 +1,291 @@
+#include "TessBenchmark.h"
+#include "CPUTessellator.h"
+#include "TessUniforms.h"
+#include <ngl/NGLInit.h>
+#include <ngl/ShaderLib.h>
+#include <ngl/Util.h>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+TessBenchmark::TessBenchmark(const AppOptions &_options) : m_options(_options)
+{
+}
+
+TessBenchmark::~TessBenchmark()
+{
+  if (m_context && m_context->makeCurrent(m_surface.get()))
+  {
+    m_vao.reset();
+    m_uniforms.reset();
+    glDeleteQueries(static_cast<GLsizei>(m_timeQueries.size()), m_timeQueries.data());
+    glDeleteQueries(static_cast<GLsizei>(m_primitiveQueries.size()), m_primitiveQueries.data());
+    deleteFramebuffer();
+    m_context->doneCurrent();
+  }
+}
+
+bool TessBenchmark::createContext()
+{
+  // uses the default format set up in main, on a machine without a GPU Mesa gives us llvmpipe
+  m_surface = std::make_unique<QOffscreenSurface>();
+  m_surface->create();
+  m_context = std::make_unique<QOpenGLContext>();
+  if (!m_context->create() || !m_context->makeCurrent(m_surface.get()))
+  {
+    std::cerr << "Unable to create an OpenGL context for the benchmark\n";
+    return false;
+  }
+  ngl::NGLInit::initialize();
+  m_renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+  std::cerr << "OpenGL Version : " << glGetString(GL_VERSION) << " Renderer : " << m_renderer << std::endl;
+  return true;
+}
+
+void TessBenchmark::createFramebuffer()
+{
+  glGenRenderbuffers(1, &m_colourBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, m_colourBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_options.benchWidth, m_options.benchHeight);
+  glGenRenderbuffers(1, &m_depthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_options.benchWidth, m_options.benchHeight);
+  glGenFramebuffers(1, &m_fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colourBuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+  {
+    std::cerr << "Benchmark framebuffer is incomplete\n";
+  }
+}
+
+void TessBenchmark::deleteFramebuffer()
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &m_fbo);
+  glDeleteRenderbuffers(1, &m_colourBuffer);
+  glDeleteRenderbuffers(1, &m_depthBuffer);
+  m_fbo = m_colourBuffer = m_depthBuffer = 0;
+}
+
+void TessBenchmark::loadMatricesToShader(float _inner, float _outer)
+{
+  // the same start up camera as NGLScene, fixed levels with adaptive mode and culling off
+  ngl::Mat4 MV = ngl::lookAt(ngl::Vec3(0, 2, 2), ngl::Vec3(0, 0, 0), ngl::Vec3(0, 1, 0));
+  ngl::Mat4 project = ngl::perspective(45.0f, static_cast<float>(m_options.benchWidth) / m_options.benchHeight, 0.05f, 350.0f);
+  ngl::Mat4 MVP = project * MV;
+  // every frame of a measurement draws with the same blocks so they are written once
+  m_uniforms->beginFrame();
+  FrameUniforms frame;
+  frame.tessLevelInner = _inner;
+  frame.tessLevelOuter = _outer;
+  m_uniforms->writeAndBind(FrameBlockBinding, frame);
+  ObjectUniforms object;
+  setObjectUniforms(MV.m_openGL, MVP.m_openGL, object);
+  object.positionScale = m_encodedMesh.positionScale;
+  m_uniforms->writeAndBind(ObjectBlockBinding, object);
+}
+
+TessBenchmark::Result TessBenchmark::measure(int _inner, int _outer)
+{
+  loadMatricesToShader(static_cast<float>(_inner), static_cast<float>(_outer));
+  // one unmeasured frame so any lazy driver work for these levels is out of the way
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  m_vao->bind();
+  m_vao->draw();
+  for (int frame = 0; frame < m_options.benchFrames; ++frame)
+  {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glBeginQuery(GL_TIME_ELAPSED, m_timeQueries[frame]);
+    glBeginQuery(GL_PRIMITIVES_GENERATED, m_primitiveQueries[frame]);
+    m_vao->draw();
+    glEndQuery(GL_PRIMITIVES_GENERATED);
+    glEndQuery(GL_TIME_ELAPSED);
+  }
+  m_vao->unbind();
+  m_uniforms->endFrame();
+
+  Result result;
+  result.encoding = m_encodings.size() - 1;
+  result.inner = _inner;
+  result.outer = _outer;
+  result.minMS = std::numeric_limits<double>::max();
+  // reading the last result waits for all of them
+  for (int frame = 0; frame < m_options.benchFrames; ++frame)
+  {
+    GLuint64 ns = 0;
+    GLuint64 primitives = 0;
+    glGetQueryObjectui64v(m_timeQueries[frame], GL_QUERY_RESULT, &ns);
+    glGetQueryObjectui64v(m_primitiveQueries[frame], GL_QUERY_RESULT, &primitives);
+    double ms = ns / 1.0e6;
+    result.meanMS += ms;
+    result.minMS = std::min(result.minMS, ms);
+    result.primitives = primitives;
+  }
+  result.meanMS /= m_options.benchFrames;
+  tess::TessLevels levels;
+  levels.inner = static_cast<float>(_inner);
+  levels.outer = {{static_cast<float>(_outer), static_cast<float>(_outer), static_cast<float>(_outer)}};
+  result.expectedPrimitives = tess::expectedTriangleCount(levels) * m_patchMesh.numPatches();
+  return result;
+}
+
+void TessBenchmark::createPatchMesh(const tess::PatchMeshSettings &_settings)
+{
+  tess::buildPatchMesh(_settings, m_patchMesh, m_encodedMesh);
+  m_vao = createPatchMeshVAO(m_encodedMesh);
+  Encoding encoding;
+  encoding.settings = _settings;
+  encoding.indexFormat = m_encodedMesh.indexFormat;
+  encoding.patches = m_patchMesh.numPatches();
+  encoding.bytes = m_encodedMesh.bytes();
+  encoding.acmr = tess::patchACMR(m_patchMesh);
+  encoding.maxError = tess::maxPositionError(m_patchMesh, m_encodedMesh);
+  m_encodings.push_back(encoding);
+}
+
+int TessBenchmark::run()
+{
+  if (!createContext())
+  {
+    return EXIT_FAILURE;
+  }
+  createFramebuffer();
+  glViewport(0, 0, m_options.benchWidth, m_options.benchHeight);
+  glClearColor(0.4f, 0.4f, 0.4f, 1.0f);
+  glEnable(GL_DEPTH_TEST);
+  ProgramCache cache(m_options.programCache);
+  m_uniforms = std::make_unique<UniformRing>(4096);
+  m_timeQueries.resize(m_options.benchFrames);
+  m_primitiveQueries.resize(m_options.benchFrames);
+  glGenQueries(m_options.benchFrames, m_timeQueries.data());
+  glGenQueries(m_options.benchFrames, m_primitiveQueries.data());
+
+  std::vector<tess::PatchMeshSettings> meshes = {m_options.patchMesh};
+  if (m_options.benchEncodings)
+  {
+    // the mesh as it was always uploaded (floats, 32 bit indices, subdivision order) then each compact form
+    tess::PatchMeshSettings settings;
+    settings.subdivisions = m_options.patchMesh.subdivisions;
+    settings.indexBits = 32;
+    meshes = {settings};
+    settings.indexBits = 0;
+    settings.reorder = true;
+    for (auto positions : {tess::PositionFormat::Float32, tess::PositionFormat::Snorm16, tess::PositionFormat::Octahedral})
+    {
+      settings.positions = positions;
+      meshes.push_back(settings);
+    }
+  }
+
+  // 1, 1 + step, ... and always the maximum level, which a step that doesn't divide 63 would otherwise skip
+  std::vector<int> levels;
+  for (int level = 1; level < tess::MaxTessLevel; level += m_options.benchStep)
+  {
+    levels.push_back(level);
+  }
+  levels.push_back(tess::MaxTessLevel);
+
+  size_t mismatches = 0;
+  for (const auto &mesh : meshes)
+  {
+    createTessProgram(m_options.pipeline, cache, mesh.positions);
+    createPatchMesh(mesh);
+    const size_t first = m_results.size();
+    for (int inner : levels)
+    {
+      for (int outer : levels)
+      {
+        m_results.push_back(measure(inner, outer));
+        if (m_results.back().primitives != m_results.back().expectedPrimitives)
+        {
+          ++mismatches;
+        }
+      }
+      std::cerr << "inner level " << inner << " done\n";
+    }
+    double total = 0.0;
+    for (size_t i = first; i < m_results.size(); ++i)
+    {
+      total += m_results[i].minMS;
+    }
+    const auto &encoding = m_encodings.back();
+    std::cerr << tess::positionFormatName(mesh.positions) << " positions " << tess::indexFormatName(encoding.indexFormat)
+              << " indices" << (mesh.reorder ? " reordered" : "") << " : " << encoding.bytes << " bytes, ACMR "
+              << encoding.acmr << ", mean of the fastest frames " << total / (m_results.size() - first) << " ms\n";
+  }
+  bool written = writeCSV(m_options.benchOutput + ".csv") && writeJSON(m_options.benchOutput + ".json");
+  std::cerr << m_results.size() << " level combinations measured, " << mismatches
+            << " with a primitive count different from the GL tessellation rules\n";
+  return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool TessBenchmark::writeCSV(const std::string &_fname) const
+{
+  std::ofstream out(_fname);
+  if (!out)
+  {
+    std::cerr << "Unable to write " << _fname << '\n';
+    return false;
+  }
+  out << "pipeline,positions,indices,reordered,patches,mesh_bytes,acmr,inner,outer,frames,gpu_ms_mean,gpu_ms_min,primitives,"
+         "expected_primitives\n";
+  for (const auto &r : m_results)
+  {
+    const auto &e = m_encodings[r.encoding];
+    out << tessProgramName(m_options.pipeline) << ',' << tess::positionFormatName(e.settings.positions) << ','
+        << tess::indexFormatName(e.indexFormat) << ',' << e.settings.reorder << ',' << e.patches << ',' << e.bytes << ','
+        << e.acmr << ',' << r.inner << ',' << r.outer << ',' << m_options.benchFrames << ','
+        << r.meanMS << ',' << r.minMS << ',' << r.primitives << ',' << r.expectedPrimitives << '\n';
+  }
+  return true;
+}
+
+bool TessBenchmark::writeJSON(const std::string &_fname) const
+{
+  std::ofstream out(_fname);
+  if (!out)
+  {
+    std::cerr << "Unable to write " << _fname << '\n';
+    return false;
+  }
+  std::string renderer;
+  for (char c : m_renderer)
+  {
+    if (c == '"' || c == '\\')
+    {
+      renderer += '\\';
+    }
+    renderer += c;
+  }
+  out << "{\n  \"renderer\" : \"" << renderer << "\",\n"
+      << "  \"pipeline\" : \"" << tessProgramName(m_options.pipeline) << "\",\n"
+      << "  \"width\" : " << m_options.benchWidth << ",\n"
+      << "  \"height\" : " << m_options.benchHeight << ",\n"
+      << "  \"frames\" : " << m_options.benchFrames << ",\n"
+      << "  \"encodings\" : [\n";
+  for (size_t i = 0; i < m_encodings.size(); ++i)
+  {
+    const auto &e = m_encodings[i];
+    out << "    {\"positions\" : \"" << tess::positionFormatName(e.settings.positions) << "\", \"indices\" : \""
+        << tess::indexFormatName(e.indexFormat) << "\", \"reordered\" : " << (e.settings.reorder ? "true" : "false")
+        << ", \"subdivisions\" : " << e.settings.subdivisions << ", \"patches\" : " << e.patches
+        << ", \"mesh_bytes\" : " << e.bytes << ", \"acmr\" : " << e.acmr << ", \"max_position_error\" : " << e.maxError
+        << "}" << (i + 1 < m_encodings.size() ? "," : "") << '\n';
+  }
+  out << "  ],\n"
+      << "  \"results\" : [\n";
+  for (size_t i = 0; i < m_results.size(); ++i)
+  {
+    const auto &r = m_results[i];
+    out << "    {\"encoding\" : " << r.encoding << ", \"inner\" : " << r.inner << ", \"outer\" : " << r.outer << ", \"gpu_ms_mean\" : " << r.meanMS
+        << ", \"gpu_ms_min\" : " << r.minMS << ", \"primitives\" : " << r.primitives
+        << ", \"expected_primitives\" : " << r.expectedPrimitives << "}" << (i + 1 < m_results.size() ? "," : "") << '\n';
+  }
+  out << "  ]\n}\n";
+  return true;
+}
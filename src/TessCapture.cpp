@@ -0,0 +1,112 @@
+#include "TessCapture.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+TessCapture::TessCapture(size_t _maxTriangles) : m_maxTriangles(_maxTriangles)
+{
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, m_buffer);
+  glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, static_cast<GLsizeiptr>(m_maxTriangles * BytesPerTriangle), nullptr, GL_STREAM_READ);
+  glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+  glGenQueries(1, &m_generatedQuery);
+  glGenQueries(1, &m_writtenQuery);
+}
+
+TessCapture::~TessCapture()
+{
+  glDeleteQueries(1, &m_generatedQuery);
+  glDeleteQueries(1, &m_writtenQuery);
+  glDeleteBuffers(1, &m_buffer);
+}
+
+CaptureResult TessCapture::capture(ngl::AbstractVAO &_vao, size_t _expected, const std::string &_fname)
+{
+  auto start = std::chrono::steady_clock::now();
+  CaptureResult result;
+  result.expected = _expected;
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_buffer);
+  glBeginQuery(GL_PRIMITIVES_GENERATED, m_generatedQuery);
+  glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, m_writtenQuery);
+  glBeginTransformFeedback(GL_TRIANGLES);
+  _vao.bind();
+  _vao.draw();
+  _vao.unbind();
+  glEndTransformFeedback();
+  glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+  glEndQuery(GL_PRIMITIVES_GENERATED);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  glDisable(GL_RASTERIZER_DISCARD);
+  // a capture is a one off so waiting for the results here is fine
+  GLuint64 generated = 0;
+  GLuint64 written = 0;
+  glGetQueryObjectui64v(m_generatedQuery, GL_QUERY_RESULT, &generated);
+  glGetQueryObjectui64v(m_writtenQuery, GL_QUERY_RESULT, &written);
+  result.primitives = generated;
+  result.overflow = written < generated;
+  result.written = write(_fname, static_cast<size_t>(written));
+  result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+
+bool TessCapture::write(const std::string &_fname, size_t _triangles) const
+{
+  std::ofstream out(_fname, std::ios::binary);
+  if (!out)
+  {
+    std::cerr << "Unable to write " << _fname << '\n';
+    return false;
+  }
+  const bool ply = _fname.size() > 4 && _fname.compare(_fname.size() - 4, 4, ".ply") == 0;
+  const size_t vertices = _triangles * 3;
+  if (ply)
+  {
+    out << "ply\nformat binary_little_endian 1.0\ncomment tessellated with the Tess program\n"
+        << "element vertex " << vertices << "\nproperty float x\nproperty float y\nproperty float z\n"
+        << "element face " << _triangles << "\nproperty list uchar int vertex_indices\nend_header\n";
+  }
+  const size_t bytes = _triangles * BytesPerTriangle;
+  if (bytes > 0)
+  {
+    glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+    auto data = static_cast<const char *>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT));
+    if (!data)
+    {
+      std::cerr << "Unable to map the transform feedback buffer\n";
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+      return false;
+    }
+    for (size_t offset = 0; offset < bytes; offset += ChunkBytes)
+    {
+      out.write(data + offset, static_cast<std::streamsize>(std::min(ChunkBytes, bytes - offset)));
+    }
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  }
+  if (ply)
+  {
+    // the faces are just consecutive vertices, build them a chunk at a time rather than all at once
+    constexpr size_t FaceBytes = 1 + 3 * sizeof(int32_t);
+    std::vector<char> chunk;
+    chunk.reserve(ChunkBytes / FaceBytes * FaceBytes);
+    for (size_t face = 0; face < _triangles; ++face)
+    {
+      chunk.push_back(3);
+      for (int32_t i = 0; i < 3; ++i)
+      {
+        int32_t index = static_cast<int32_t>(face * 3) + i;
+        const char *b = reinterpret_cast<const char *>(&index);
+        chunk.insert(chunk.end(), b, b + sizeof(index));
+      }
+      if (chunk.size() + FaceBytes > chunk.capacity() || face + 1 == _triangles)
+      {
+        out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        chunk.clear();
+      }
+    }
+  }
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,62 @@
+#include "TessLevelController.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace tess
+{
+
+TessLevelController::TessLevelController(const LevelControllerParams &_params) : m_params(_params)
+{
+  m_params.window = std::max<size_t>(1, m_params.window);
+  m_samples.reserve(m_params.window);
+}
+
+void TessLevelController::setLevel(float _level)
+{
+  m_level = std::min(static_cast<float>(MaxTessLevel), std::max(1.0f, std::round(_level)));
+  m_samples.clear();
+  m_skip = m_params.settleFrames;
+}
+
+bool TessLevelController::update(float _gpuMS)
+{
+  if (m_skip > 0)
+  {
+    --m_skip;
+    return false;
+  }
+  // queries that were skipped or failed report 0, they say nothing about the cost of this level
+  if (!(_gpuMS > 0.0f))
+  {
+    return false;
+  }
+  m_samples.push_back(_gpuMS);
+  if (m_samples.size() < m_params.window)
+  {
+    return false;
+  }
+  m_averageMS = std::accumulate(m_samples.begin(), m_samples.end(), 0.0f) / m_samples.size();
+  // slide the window by one frame
+  m_samples.erase(m_samples.begin());
+  const float budget = m_params.budgetMS;
+  float next = m_level;
+  if (m_averageMS > budget * (1.0f + m_params.hysteresis))
+  {
+    next = std::min(m_level - 1.0f, std::floor(m_level * std::sqrt(budget / m_averageMS)));
+  }
+  else if (m_averageMS < budget * (1.0f - m_params.hysteresis))
+  {
+    float grown = std::min(m_level * std::sqrt(budget / m_averageMS), m_level * (1.0f + m_params.maxGrowth));
+    next = std::max(m_level + 1.0f, std::floor(grown));
+  }
+  next = std::min(static_cast<float>(MaxTessLevel), std::max(1.0f, next));
+  if (next == m_level)
+  {
+    return false;
+  }
+  setLevel(next);
+  return true;
+}
+
+} // end namespace tess
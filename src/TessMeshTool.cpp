@@ -0,0 +1,165 @@
+// Writes an icosphere control mesh as a .tpm file for the --mesh option, no GL needed
+// usage : TessMeshTool out.tpm [subdivisions=6] [--reorder] [--hints] [--block patches]
+//  subdivisions splits every icosahedron face into 4 that many times (20 * 4^n patches), 10 is about 380 MB
+//  --hints stores a per patch inner level multiplier, denser towards the poles
+//  --block sets the patches per block of the streaming table (default 65536)
+// or : TessMeshTool out.tht [tiles=32] [--resolution quads] writes a tiles x tiles height tile terrain for --terrain
+#include "PatchMeshFile.h"
+#include "TerrainTiles.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  bool endsWith(const std::string &_text, const std::string &_end)
+  {
+    return _text.size() >= _end.size() && _text.compare(_text.size() - _end.size(), _end.size(), _end) == 0;
+  }
+
+  int writeTerrain(const std::string &_fname, int argc, char **argv)
+  {
+    tess::TerrainInfo info;
+    for (int i = 2; i < argc; ++i)
+    {
+      if (std::strcmp(argv[i], "--resolution") == 0 && i + 1 < argc)
+      {
+        info.resolution = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+      }
+      else
+      {
+        info.tilesX = info.tilesZ = static_cast<uint32_t>(std::max(1, std::atoi(argv[i])));
+      }
+    }
+    if (!info.valid())
+    {
+      std::fprintf(stderr, "At most %u tiles a side of at most %u quads\n", tess::MaxTerrainTilesPerSide, tess::MaxTerrainResolution);
+      return EXIT_FAILURE;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (!tess::writeTerrainFile(_fname, info))
+    {
+      return EXIT_FAILURE;
+    }
+    double writeMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // read the last tile back through the loader the viewer uses
+    tess::TerrainTileLoader loader;
+    if (!loader.open(_fname))
+    {
+      return EXIT_FAILURE;
+    }
+    const uint32_t last = static_cast<uint32_t>(info.numTiles() - 1);
+    loader.request({last});
+    std::vector<tess::TerrainTile> tiles;
+    for (int wait = 0; wait < 10000 && loader.tilesLoaded() == 0; ++wait)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    loader.collect(tiles);
+    std::vector<uint16_t> expected(info.tileBytes() / sizeof(uint16_t));
+    tess::generateTerrainTile(info, last % info.tilesX, last / info.tilesX, expected.data());
+    const bool same = tiles.size() == 1 && tiles[0].index == last && tiles[0].heights == expected;
+    std::printf("%s : %u x %u tiles of %u x %u samples, %.1f MB, written in %.1f ms, %s\n", _fname.c_str(), info.tilesX,
+                info.tilesZ, info.samples(), info.samples(), info.numTiles() * info.tileBytes() / (1024.0 * 1024.0), writeMS,
+                same ? "verified" : "MISMATCH");
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+} // end anonymous namespace
+
+int main(int argc, char **argv)
+{
+  if (argc < 2 || argv[1][0] == '-')
+  {
+    std::fprintf(stderr, "usage : %s out.tpm [subdivisions=6] [--reorder] [--hints] [--block patches]\n"
+                         "        %s out.tht [tiles=32] [--resolution quads]\n", argv[0], argv[0]);
+    return EXIT_FAILURE;
+  }
+  const std::string fname = argv[1];
+  if (endsWith(fname, ".tht"))
+  {
+    return writeTerrain(fname, argc, argv);
+  }
+  int subdivisions = 6;
+  bool reorder = false;
+  bool hints = false;
+  uint64_t patchesPerBlock = 64 * 1024;
+  for (int i = 2; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--reorder") == 0)
+    {
+      reorder = true;
+    }
+    else if (std::strcmp(argv[i], "--hints") == 0)
+    {
+      hints = true;
+    }
+    else if (std::strcmp(argv[i], "--block") == 0 && i + 1 < argc)
+    {
+      patchesPerBlock = std::strtoull(argv[++i], nullptr, 10);
+    }
+    else
+    {
+      subdivisions = std::atoi(argv[i]);
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  tess::TrianglePatchMesh mesh;
+  tess::makeIcosphere(subdivisions, mesh);
+  if (reorder)
+  {
+    tess::reorderPatches(mesh);
+  }
+  std::vector<float> patchHints;
+  if (hints)
+  {
+    // only the inner level is scaled so neighbouring patches still agree on their shared edges
+    patchHints.resize(mesh.numPatches());
+    for (size_t patch = 0; patch < mesh.numPatches(); ++patch)
+    {
+      float y = 0.0f;
+      for (int v = 0; v < 3; ++v)
+      {
+        y += mesh.positions[mesh.patchIndices[patch * 3 + v] * 3 + 1];
+      }
+      patchHints[patch] = 1.0f + std::fabs(y / 3.0f);
+    }
+  }
+  double buildMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  if (!tess::writePatchMeshFile(fname, mesh, patchHints, patchesPerBlock))
+  {
+    return EXIT_FAILURE;
+  }
+  double writeMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  // read it back through the mapping the viewer uses
+  tess::MappedPatchMesh file;
+  if (!file.open(fname))
+  {
+    return EXIT_FAILURE;
+  }
+  bool same = file.numVertices() == mesh.numVertices() && file.numPatches() == mesh.numPatches() &&
+              std::memcmp(file.positions(), mesh.positions.data(), mesh.positions.size() * sizeof(float)) == 0;
+  for (size_t i = 0; same && i < mesh.patchIndices.size(); ++i)
+  {
+    uint32_t index = 0;
+    std::memcpy(&index, file.indices() + i * file.indexSize(), file.indexSize());
+    same = index == mesh.patchIndices[i];
+  }
+  for (size_t block = 0; same && block < file.numBlocks(); ++block)
+  {
+    same = file.blockVertexEnd(block) <= file.numVertices();
+  }
+  std::printf("%s : %zu patches %zu vertices %zu bit indices %s hints, %zu blocks, %.1f MB, built in %.1f ms written in %.1f ms, %s\n",
+              fname.c_str(), file.numPatches(), file.numVertices(), file.indexSize() * 8, file.hasHints() ? "with" : "no",
+              file.numBlocks(), file.bytes() / (1024.0 * 1024.0), buildMS, writeMS, same ? "verified" : "MISMATCH");
+  return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,223 @@
+#include "TessProgram.h"
+#include "TessUniforms.h"
+#include <ngl/ShaderLib.h>
+#include <ngl/SimpleIndexVAO.h>
+#include <ngl/VAOFactory.h>
+#include <utility>
+
+const char *tessProgramName(TessPipeline _pipeline)
+{
+  return _pipeline == TessPipeline::GeometryShader ? "Tess" : "TessNoGeom";
+}
+
+std::string tessProgramDefines(tess::PositionFormat _positions)
+{
+  std::string defines;
+  if (_positions == tess::PositionFormat::Snorm16)
+  {
+    defines = "#define POSITION_SNORM16\n";
+  }
+  else if (_positions == tess::PositionFormat::Octahedral)
+  {
+    defines = "#define POSITION_OCTAHEDRAL\n";
+  }
+  return defines + ProgramCache::readFile("shaders/tessblocks.glsl");
+}
+
+std::vector<ShaderStageSource> tessProgramStages(TessPipeline _pipeline, const std::string &_program)
+{
+  const bool geometry = _pipeline == TessPipeline::GeometryShader;
+  std::vector<ShaderStageSource> stages = {
+      {_program + "Vertex", ngl::ShaderType::VERTEX, ProgramCache::readFile("shaders/tessvert.glsl")},
+      {_program + "Fragment", ngl::ShaderType::FRAGMENT, ProgramCache::readFile(geometry ? "shaders/tessfrag.glsl" : "shaders/tessfragnogeom.glsl")},
+      {_program + "Control", ngl::ShaderType::TESSCONTROL, ProgramCache::readFile("shaders/tesscontrol.glsl")},
+      {_program + "Eval", ngl::ShaderType::TESSEVAL, ProgramCache::readFile(geometry ? "shaders/tesseval.glsl" : "shaders/tessevalnogeom.glsl")}};
+  if (geometry)
+  {
+    stages.push_back({_program + "Geom", ngl::ShaderType::GEOMETRY, ProgramCache::readFile("shaders/tessgeom.glsl")});
+  }
+  return stages;
+}
+
+void setTessProgramUniforms(GLuint _program)
+{
+  bindTessUniformBlocks(_program);
+  glProgramUniform3f(_program, glGetUniformLocation(_program, "AmbientMaterial"), 0.1f, 0.1f, 0.1f);
+  glProgramUniform3f(_program, glGetUniformLocation(_program, "DiffuseMaterial"), 0.8f, 0.0f, 0.0f);
+  glProgramUniform3f(_program, glGetUniformLocation(_program, "LightPosition"), 1.0f, 1.0f, 1.0f);
+  glProgramUniform1i(_program, glGetUniformLocation(_program, "PatchHints"), PatchHintsTextureUnit);
+}
+
+ProgramRequest tessProgramRequest(TessPipeline _pipeline, tess::PositionFormat _positions)
+{
+  const std::string program = tessProgramName(_pipeline);
+  return {program, tessProgramStages(_pipeline, program), tessProgramDefines(_positions), {}, [program]()
+          {
+            ngl::ShaderLib::printRegisteredUniforms(program);
+            setTessProgramUniforms(ngl::ShaderLib::getProgramID(program));
+          }};
+}
+
+ProgramBuildInfo createTessProgram(TessPipeline _pipeline, ProgramCache &_cache, tess::PositionFormat _positions)
+{
+  return _cache.build(tessProgramRequest(_pipeline, _positions));
+}
+
+ProgramRequest lodProgramRequest()
+{
+  const std::string program = LODProgramName;
+  std::vector<ShaderStageSource> stages = {
+      {program + "Vertex", ngl::ShaderType::VERTEX, ProgramCache::readFile("shaders/lodvert.glsl")},
+      {program + "Geom", ngl::ShaderType::GEOMETRY, ProgramCache::readFile("shaders/tessgeom.glsl")},
+      {program + "Fragment", ngl::ShaderType::FRAGMENT, ProgramCache::readFile("shaders/tessfrag.glsl")}};
+  return {program, stages, ProgramCache::readFile("shaders/tessblocks.glsl"), {}, [program]()
+          {
+            bindTessUniformBlocks(program);
+            ngl::ShaderLib::setUniform("AmbientMaterial", 0.1f, 0.1f, 0.1f);
+            ngl::ShaderLib::setUniform("DiffuseMaterial", 0.8f, 0.0f, 0.0f);
+            ngl::ShaderLib::setUniform("LightPosition", 1.0f, 1.0f, 1.0f);
+          }};
+}
+
+ProgramRequest bezierProgramRequest()
+{
+  const std::string program = BezierProgramName;
+  std::vector<ShaderStageSource> stages = {
+      {program + "Vertex", ngl::ShaderType::VERTEX, ProgramCache::readFile("shaders/tessvert.glsl")},
+      {program + "Control", ngl::ShaderType::TESSCONTROL, ProgramCache::readFile("shaders/beziercontrol.glsl")},
+      {program + "Eval", ngl::ShaderType::TESSEVAL, ProgramCache::readFile("shaders/beziereval.glsl")},
+      {program + "Geom", ngl::ShaderType::GEOMETRY, ProgramCache::readFile("shaders/tessgeom.glsl")},
+      {program + "Fragment", ngl::ShaderType::FRAGMENT, ProgramCache::readFile("shaders/tessfrag.glsl")}};
+  return {program, stages, ProgramCache::readFile("shaders/tessblocks.glsl"), {}, [program]()
+          {
+            bindTessUniformBlocks(program);
+            ngl::ShaderLib::setUniform("AmbientMaterial", 0.1f, 0.1f, 0.1f);
+            ngl::ShaderLib::setUniform("DiffuseMaterial", 0.0f, 0.3f, 0.8f);
+            ngl::ShaderLib::setUniform("LightPosition", 1.0f, 1.0f, 1.0f);
+          }};
+}
+
+ProgramRequest captureProgramRequest(tess::PositionFormat _positions)
+{
+  const std::string program = CaptureProgramName;
+  std::vector<ShaderStageSource> stages = {
+      {program + "Vertex", ngl::ShaderType::VERTEX, ProgramCache::readFile("shaders/tessvert.glsl")},
+      {program + "Control", ngl::ShaderType::TESSCONTROL, ProgramCache::readFile("shaders/tesscontrol.glsl")},
+      {program + "Eval", ngl::ShaderType::TESSEVAL, ProgramCache::readFile("shaders/tesseval.glsl")}};
+  return {program, stages, tessProgramDefines(_positions), {"tePosition"}, [program]()
+          {
+            bindTessUniformBlocks(program);
+            ngl::ShaderLib::setUniform("PatchHints", PatchHintsTextureUnit);
+          }};
+}
+
+ProgramRequest instancedProgramRequest()
+{
+  const std::string program = InstancedProgramName;
+  std::vector<ShaderStageSource> stages = {
+      {program + "Vertex", ngl::ShaderType::VERTEX, ProgramCache::readFile("shaders/instvert.glsl")},
+      {program + "Control", ngl::ShaderType::TESSCONTROL, ProgramCache::readFile("shaders/instcontrol.glsl")},
+      {program + "Eval", ngl::ShaderType::TESSEVAL, ProgramCache::readFile("shaders/insteval.glsl")},
+      {program + "Geom", ngl::ShaderType::GEOMETRY, ProgramCache::readFile("shaders/tessgeom.glsl")},
+      {program + "Fragment", ngl::ShaderType::FRAGMENT, ProgramCache::readFile("shaders/tessfrag.glsl")}};
+  return {program, stages, ProgramCache::readFile("shaders/tessblocks.glsl"), {}, [program]()
+          {
+            bindTessUniformBlocks(program);
+            ngl::ShaderLib::setUniform("AmbientMaterial", 0.1f, 0.1f, 0.1f);
+            ngl::ShaderLib::setUniform("DiffuseMaterial", 0.8f, 0.5f, 0.0f);
+            ngl::ShaderLib::setUniform("LightPosition", 1.0f, 1.0f, 1.0f);
+          }};
+}
+
+ProgramRequest instanceCullProgramRequest()
+{
+  const std::string program = InstanceCullProgramName;
+  std::vector<ShaderStageSource> stages = {
+      {program + "Compute", ngl::ShaderType::COMPUTE, ProgramCache::readFile("shaders/instcull.glsl")}};
+  return {program, stages, ProgramCache::readFile("shaders/tessblocks.glsl"), {}, [program]() { bindTessUniformBlocks(program); }};
+}
+
+ProgramRequest terrainProgramRequest()
+{
+  const std::string program = TerrainProgramName;
+  std::vector<ShaderStageSource> stages = {
+      {program + "Vertex", ngl::ShaderType::VERTEX, ProgramCache::readFile("shaders/terrainvert.glsl")},
+      {program + "Control", ngl::ShaderType::TESSCONTROL, ProgramCache::readFile("shaders/terraincontrol.glsl")},
+      {program + "Eval", ngl::ShaderType::TESSEVAL, ProgramCache::readFile("shaders/terraineval.glsl")},
+      {program + "Geom", ngl::ShaderType::GEOMETRY, ProgramCache::readFile("shaders/tessgeom.glsl")},
+      {program + "Fragment", ngl::ShaderType::FRAGMENT, ProgramCache::readFile("shaders/tessfrag.glsl")}};
+  return {program, stages, ProgramCache::readFile("shaders/tessblocks.glsl"), {}, [program]()
+          {
+            bindTessUniformBlocks(program);
+            ngl::ShaderLib::setUniform("HeightTiles", TerrainHeightTextureUnit);
+            ngl::ShaderLib::setUniform("AmbientMaterial", 0.1f, 0.1f, 0.1f);
+            ngl::ShaderLib::setUniform("DiffuseMaterial", 0.3f, 0.5f, 0.2f);
+            ngl::ShaderLib::setUniform("LightPosition", 1.0f, 1.0f, 1.0f);
+          }};
+}
+
+void bindTessUniformBlocks(const std::string &_program)
+{
+  bindTessUniformBlocks(ngl::ShaderLib::getProgramID(_program));
+}
+
+void bindTessUniformBlocks(GLuint _program)
+{
+  // block bindings are not part of the program binary so this is needed after a cache hit too
+  for (auto block : {std::make_pair("FrameBlock", FrameBlockBinding), std::make_pair("ObjectBlock", ObjectBlockBinding)})
+  {
+    GLuint index = glGetUniformBlockIndex(_program, block.first);
+    if (index != GL_INVALID_INDEX)
+    {
+      glUniformBlockBinding(_program, index, block.second);
+    }
+  }
+}
+
+std::unique_ptr<ngl::AbstractVAO> createPatchMeshVAO(const tess::EncodedPatchMesh &_mesh)
+{
+  GLenum indexType = GL_UNSIGNED_INT;
+  if (_mesh.indexFormat == tess::IndexFormat::UInt8)
+  {
+    indexType = GL_UNSIGNED_BYTE;
+  }
+  else if (_mesh.indexFormat == tess::IndexFormat::UInt16)
+  {
+    indexType = GL_UNSIGNED_SHORT;
+  }
+  auto vao = ngl::VAOFactory::createVAO(ngl::simpleIndexVAO, GL_PATCHES);
+  vao->bind();
+  // VertexData only takes floats but the buffer is uploaded as raw bytes
+  vao->setData(ngl::SimpleIndexVAO::VertexData(_mesh.vertexData.size(), *reinterpret_cast<const GLfloat *>(_mesh.vertexData.data()),
+                                               static_cast<unsigned int>(_mesh.indexData.size()), _mesh.indexData.data(),
+                                               indexType, GL_STATIC_DRAW));
+  const auto stride = static_cast<GLsizei>(_mesh.vertexStride);
+  switch (_mesh.positionFormat)
+  {
+  case tess::PositionFormat::Float32:
+    vao->setVertexAttributePointer(0, 3, GL_FLOAT, stride, 0);
+    break;
+  case tess::PositionFormat::Snorm16:
+    vao->setVertexAttributePointer(0, 3, GL_SHORT, stride, 0, true);
+    break;
+  case tess::PositionFormat::Octahedral:
+    vao->setVertexAttributePointer(0, 2, GL_SHORT, stride, 0, true);
+    break;
+  }
+  vao->setNumIndices(_mesh.numIndices);
+  vao->unbind();
+  return vao;
+}
+
+std::unique_ptr<ngl::AbstractVAO> createBezierVAO(const tess::BezierPatchMesh &_patches)
+{
+  auto vao = ngl::VAOFactory::createVAO(ngl::simpleIndexVAO, GL_PATCHES);
+  vao->bind();
+  vao->setData(ngl::SimpleIndexVAO::VertexData(_patches.controlPoints.size() * sizeof(float), _patches.controlPoints[0],
+                                               static_cast<unsigned int>(_patches.patchIndices.size() * sizeof(uint32_t)),
+                                               _patches.patchIndices.data(), GL_UNSIGNED_INT, GL_STATIC_DRAW));
+  vao->setVertexAttributePointer(0, 3, GL_FLOAT, 0, 0);
+  vao->setNumIndices(_patches.patchIndices.size());
+  vao->unbind();
+  return vao;
+}
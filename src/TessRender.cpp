@@ -0,0 +1,193 @@
+// Renders the tessellated sphere on the CPU to a PPM, for machines without a GPU, and optionally diffs it
+// usage : TessRender out.ppm [--size WxH] [--level n] [--inner n] [--outer n] [--subdivisions n] [--rotate x y]
+//                  [--threads n] [--compare ref.ppm] [--tolerance 16] [--max-differing 1.0] [--diff diff.ppm]
+//                  [--trace trace.json]
+//  the camera and lighting are the window's, so a --screenshot of the demo at the same size and levels is a reference
+//  --compare fails (exit code 1) when more than --max-differing percent of the pixels are over --tolerance apart
+//  --trace writes the tessellation and render zones of every thread as Chrome trace JSON, in TESS_ENABLE_TRACE builds
+#include "PatchMesh.h"
+#include "SoftRasterizer.h"
+#include "TessMath.h"
+#include "TessTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+int main(int argc, char **argv)
+{
+  if (argc < 2 || argv[1][0] == '-')
+  {
+    std::fprintf(stderr, "usage : %s out.ppm [--size WxH] [--level n] [--inner n] [--outer n] [--subdivisions n] "
+                         "[--rotate x y] [--threads n] [--compare ref.ppm] [--tolerance 16] [--max-differing 1.0] "
+                         "[--diff diff.ppm] [--trace trace.json]\n",
+                 argv[0]);
+    return EXIT_FAILURE;
+  }
+  const std::string fname = argv[1];
+  int width = 1024;
+  int height = 720;
+  tess::TessLevels levels;
+  int subdivisions = 0;
+  float rotate[2] = {0.0f, 0.0f};
+  size_t threads = 0;
+  std::string reference;
+  std::string diffName;
+  std::string traceName;
+  int tolerance = 16;
+  double maxDiffering = 1.0;
+  for (int i = 2; i < argc; ++i)
+  {
+    const bool value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--size") == 0 && value)
+    {
+      if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2)
+      {
+        std::fprintf(stderr, "--size takes WxH\n");
+        return EXIT_FAILURE;
+      }
+    }
+    else if (std::strcmp(argv[i], "--level") == 0 && value)
+    {
+      levels.inner = static_cast<float>(std::atof(argv[++i]));
+      levels.outer.fill(levels.inner);
+    }
+    else if (std::strcmp(argv[i], "--inner") == 0 && value)
+    {
+      levels.inner = static_cast<float>(std::atof(argv[++i]));
+    }
+    else if (std::strcmp(argv[i], "--outer") == 0 && value)
+    {
+      levels.outer.fill(static_cast<float>(std::atof(argv[++i])));
+    }
+    else if (std::strcmp(argv[i], "--subdivisions") == 0 && value)
+    {
+      subdivisions = std::clamp(std::atoi(argv[++i]), 0, 8);
+    }
+    else if (std::strcmp(argv[i], "--rotate") == 0 && i + 2 < argc)
+    {
+      rotate[0] = static_cast<float>(std::atof(argv[++i]));
+      rotate[1] = static_cast<float>(std::atof(argv[++i]));
+    }
+    else if (std::strcmp(argv[i], "--threads") == 0 && value)
+    {
+      threads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+    }
+    else if (std::strcmp(argv[i], "--compare") == 0 && value)
+    {
+      reference = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--tolerance") == 0 && value)
+    {
+      tolerance = std::max(0, std::atoi(argv[++i]));
+    }
+    else if (std::strcmp(argv[i], "--max-differing") == 0 && value)
+    {
+      maxDiffering = std::atof(argv[++i]);
+    }
+    else if (std::strcmp(argv[i], "--diff") == 0 && value)
+    {
+      diffName = argv[++i];
+    }
+    else if (std::strcmp(argv[i], "--trace") == 0 && value)
+    {
+      traceName = argv[++i];
+    }
+    else
+    {
+      std::fprintf(stderr, "unknown option %s\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!traceName.empty())
+  {
+    if (!tess::Trace::compiledIn())
+    {
+      std::fprintf(stderr, "--trace needs a build with -DTESS_ENABLE_TRACE=ON\n");
+      return EXIT_FAILURE;
+    }
+    TESS_TRACE_THREAD("main");
+    tess::Trace::start();
+  }
+  tess::TrianglePatchMesh sphere;
+  tess::makeIcosphere(subdivisions, sphere);
+  auto start = std::chrono::steady_clock::now();
+  tess::CPUTessellator tessellator;
+  tess::TessMesh mesh;
+  {
+    TESS_TRACE_ZONE("CPUTessellator::tessellate");
+    tessellator.tessellate(sphere.positions.data(), sphere.patchIndices.data(), sphere.numPatches(), levels, mesh, true);
+  }
+  const double tessMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  // NGLScene's camera, with the mouse rotation as rotY * rotX
+  const float eye[3] = {0.0f, 2.0f, 2.0f};
+  const float centre[3] = {0.0f, 0.0f, 0.0f};
+  const float up[3] = {0.0f, 1.0f, 0.0f};
+  float view[16];
+  float project[16];
+  float rotX[16];
+  float rotY[16];
+  float model[16];
+  float modelview[16];
+  tess::lookAt(eye, centre, up, view);
+  tess::perspective(45.0f, static_cast<float>(width) / height, 0.05f, 350.0f, project);
+  tess::rotation(0, rotate[0], rotX);
+  tess::rotation(1, rotate[1], rotY);
+  tess::multiply(rotY, rotX, model);
+  tess::multiply(view, model, modelview);
+
+  tess::ThreadPool pool(threads);
+  tess::SoftRasterizer rasterizer(pool);
+  tess::RasterImage image;
+  image.resize(width, height);
+  start = std::chrono::steady_clock::now();
+  if (!rasterizer.render(mesh, modelview, project, tess::RasterShading(), image))
+  {
+    return EXIT_FAILURE;
+  }
+  const double renderMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  const auto &stats = rasterizer.stats();
+  std::printf("%zu patches inner %g outer %g : %zu triangles tessellated in %.2f ms\n", sphere.numPatches(), levels.inner,
+              levels.outer[0], mesh.numTriangles(), tessMS);
+  std::printf("%dx%d on %zu threads in %.2f ms (transform %.2f bin %.2f raster %.2f), %zu triangles %zu tile entries "
+              "%zu tiles\n",
+              width, height, pool.size(), renderMS, stats.transformMS, stats.binMS, stats.rasterMS, stats.triangles,
+              stats.binned, stats.tiles);
+  if (!traceName.empty() && tess::Trace::write(traceName))
+  {
+    std::printf("%zu trace events written to %s\n", tess::Trace::events(), traceName.c_str());
+  }
+  if (!tess::writePPM(fname, image))
+  {
+    return EXIT_FAILURE;
+  }
+  if (reference.empty())
+  {
+    return EXIT_SUCCESS;
+  }
+  tess::RasterImage expected;
+  if (!tess::readPPM(reference, expected))
+  {
+    return EXIT_FAILURE;
+  }
+  tess::RasterImage diffImage;
+  const auto diff = tess::compareImages(image, expected, tolerance, diffName.empty() ? nullptr : &diffImage);
+  if (!diff.sameSize)
+  {
+    std::printf("%s is %dx%d, rendered %dx%d\n", reference.c_str(), expected.width, expected.height, width, height);
+    return EXIT_FAILURE;
+  }
+  if (!diffName.empty())
+  {
+    tess::writePPM(diffName, diffImage);
+  }
+  const bool pass = diff.fractionOver * 100.0 <= maxDiffering;
+  std::printf("compared with %s : max difference %d mean %.3f, %zu pixels (%.3f%%) over %d : %s\n", reference.c_str(),
+              diff.maxDifference, diff.meanDifference, diff.pixelsOver, diff.fractionOver * 100.0, tolerance,
+              pass ? "pass" : "FAIL");
+  return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,144 @@
+// Scaling benchmark for ParallelTessellator, no GL needed so it runs on build / CI machines
+// usage : TessScaling [subdivisions=4] [level=16] [maxThreads=hardware] [runs=5] [--varying]
+//  subdivisions splits every icosahedron face into 4 that many times (20 * 4^n patches)
+//  --varying gives every edge its own level so patches get very different amounts of work
+#include "ParallelTessellator.h"
+#include "PatchMesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief a closed sphere is watertight when every edge is used by exactly two triangles, once in each direction,
+  /// and V - E + F = 2
+  //----------------------------------------------------------------------------------------------------------------------
+  bool watertight(const tess::TessMesh &_mesh, long &o_euler)
+  {
+    std::vector<std::pair<uint64_t, int>> edges;
+    edges.reserve(_mesh.indices.size());
+    for (size_t t = 0; t < _mesh.indices.size(); t += 3)
+    {
+      for (int e = 0; e < 3; ++e)
+      {
+        uint64_t a = _mesh.indices[t + e];
+        uint64_t b = _mesh.indices[t + (e + 1) % 3];
+        edges.emplace_back(std::min(a, b) << 32 | std::max(a, b), a < b ? 1 : -1);
+      }
+    }
+    std::sort(edges.begin(), edges.end());
+    bool closed = true;
+    size_t numEdges = 0;
+    for (size_t i = 0; i < edges.size();)
+    {
+      size_t j = i;
+      int direction = 0;
+      for (; j < edges.size() && edges[j].first == edges[i].first; ++j)
+      {
+        direction += edges[j].second;
+      }
+      closed = closed && j - i == 2 && direction == 0;
+      ++numEdges;
+      i = j;
+    }
+    o_euler = static_cast<long>(_mesh.numVertices()) - static_cast<long>(numEdges) + static_cast<long>(_mesh.numTriangles());
+    return closed && o_euler == 2;
+  }
+
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief level for an edge from its midpoint, the same for both patches sharing it
+  //----------------------------------------------------------------------------------------------------------------------
+  float edgeLevel(const float *_a, const float *_b, int _level)
+  {
+    float z = 0.5f * (_a[2] + _b[2]);
+    return 1.0f + (_level - 1) * (0.5f + 0.5f * z);
+  }
+} // end anonymous namespace
+
+int main(int argc, char **argv)
+{
+  std::vector<int> args;
+  bool varying = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--varying") == 0)
+    {
+      varying = true;
+    }
+    else
+    {
+      args.push_back(std::atoi(argv[i]));
+    }
+  }
+  const int subdivisions = args.size() > 0 ? args[0] : 4;
+  const int level = std::clamp(args.size() > 1 ? args[1] : 16, 1, tess::MaxTessLevel);
+  const int maxThreads = args.size() > 2 ? args[2] : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  const int runs = std::max(1, args.size() > 3 ? args[3] : 5);
+
+  tess::TrianglePatchMesh sphere;
+  tess::makeIcosphere(subdivisions, sphere);
+  const std::vector<float> &positions = sphere.positions;
+  const std::vector<uint32_t> &patches = sphere.patchIndices;
+  const size_t numPatches = patches.size() / 3;
+
+  tess::PatchLevelFunction levels = [&](size_t _patch)
+  {
+    tess::TessLevels l;
+    if (!varying)
+    {
+      l.inner = static_cast<float>(level);
+      l.outer = {{l.inner, l.inner, l.inner}};
+      return l;
+    }
+    const uint32_t *idx = &patches[_patch * 3];
+    for (int e = 0; e < 3; ++e)
+    {
+      l.outer[e] = edgeLevel(&positions[idx[(e + 1) % 3] * 3], &positions[idx[(e + 2) % 3] * 3], level);
+    }
+    l.inner = std::max({l.outer[0], l.outer[1], l.outer[2]});
+    return l;
+  };
+
+  std::printf("%zu patches, level %d%s, best of %d runs\n", numPatches, level, varying ? " (varying)" : "", runs);
+  std::printf("threads,ms,edgesMS,patchesMS,mergeMS,speedup,efficiency,steals,vertices,triangles,watertight\n");
+  double baseMS = 0.0;
+  int failures = 0;
+  for (int threads = 1; threads <= maxThreads; ++threads)
+  {
+    tess::ThreadPool pool(static_cast<size_t>(threads));
+    tess::ParallelTessellator tessellator(pool);
+    tess::TessMesh mesh;
+    double best = 1e30;
+    tess::ParallelTessellator::Timings timings;
+    for (int run = 0; run < runs; ++run)
+    {
+      auto start = std::chrono::steady_clock::now();
+      tessellator.tessellate(positions.data(), positions.size() / 3, patches.data(), numPatches, levels,
+                             tess::PatchEvaluation::Sphere, mesh);
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (ms < best)
+      {
+        best = ms;
+        timings = tessellator.timings();
+      }
+    }
+    if (threads == 1)
+    {
+      baseMS = best;
+    }
+    long euler = 0;
+    bool closed = watertight(mesh, euler);
+    failures += closed ? 0 : 1;
+    double speedup = baseMS / best;
+    std::printf("%d,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%zu,%zu,%zu,%s\n", threads, best, timings.edgesMS, timings.patchesMS,
+                timings.mergeMS, speedup, speedup / threads, pool.steals(), mesh.numVertices(), mesh.numTriangles(),
+                closed ? "yes" : "no");
+  }
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
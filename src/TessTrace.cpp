@@ -0,0 +1,255 @@
+#include "TessTrace.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tess
+{
+
+namespace
+{
+  struct Event
+  {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+    /// @brief where the flow arrow into this event starts, when flowTrack isn't 0
+    uint64_t from;
+    uint32_t frame;
+    uint32_t flowTrack;
+  };
+  struct Buffer
+  {
+    uint32_t id = 0;
+    bool cpu = true;
+    std::string name;
+    std::unique_ptr<Event[]> events;
+    size_t capacity = 0;
+    /// @brief written by the owning thread only, events below it are complete
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> dropped{0};
+  };
+  constexpr size_t MaxTracks = 256;
+  struct State
+  {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    /// @brief by track id, so a track is found without the lock
+    std::array<std::atomic<Buffer *>, MaxTracks> tracks = {};
+    std::atomic<bool> active{false};
+    std::atomic<uint32_t> frame{0};
+    size_t capacity = Trace::DefaultCapacity;
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+  };
+  State s_state;
+  thread_local Buffer *t_buffer = nullptr;
+  thread_local std::string t_threadName;
+
+  // needs the lock, returns null when all the track ids are used
+  Buffer *createBuffer(const std::string &_name, bool _cpu)
+  {
+    const size_t id = s_state.buffers.size() + 1;
+    if (id >= MaxTracks)
+    {
+      return nullptr;
+    }
+    auto buffer = std::make_unique<Buffer>();
+    buffer->id = static_cast<uint32_t>(id);
+    buffer->cpu = _cpu;
+    buffer->name = _name;
+    buffer->capacity = s_state.capacity;
+    buffer->events = std::make_unique<Event[]>(buffer->capacity);
+    s_state.tracks[id].store(buffer.get(), std::memory_order_release);
+    s_state.buffers.push_back(std::move(buffer));
+    return s_state.buffers.back().get();
+  }
+
+  Buffer *threadBuffer()
+  {
+    if (t_buffer == nullptr)
+    {
+      std::lock_guard<std::mutex> lock(s_state.mutex);
+      t_buffer = createBuffer(!t_threadName.empty() ? t_threadName : "thread " + std::to_string(s_state.buffers.size() + 1), true);
+    }
+    return t_buffer;
+  }
+
+  void push(Buffer &io_buffer, const Event &_event)
+  {
+    const size_t n = io_buffer.count.load(std::memory_order_relaxed);
+    if (n == io_buffer.capacity)
+    {
+      io_buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    io_buffer.events[n] = _event;
+    io_buffer.count.store(n + 1, std::memory_order_release);
+  }
+
+  std::string escape(const std::string &_text)
+  {
+    std::string out;
+    for (char c : _text)
+    {
+      if (c == '"' || c == '\\')
+      {
+        out += '\\';
+      }
+      out += (static_cast<unsigned char>(c) < 0x20) ? ' ' : c;
+    }
+    return out;
+  }
+
+  // Chrome trace times are floating point microseconds
+  std::string micro(uint64_t _ns)
+  {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f", _ns / 1000.0);
+    return text;
+  }
+} // end anonymous namespace
+
+void Trace::start(size_t _capacity)
+{
+  {
+    std::lock_guard<std::mutex> lock(s_state.mutex);
+    s_state.capacity = std::max<size_t>(_capacity, 1);
+  }
+  s_state.active.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop()
+{
+  s_state.active.store(false, std::memory_order_relaxed);
+}
+
+bool Trace::active()
+{
+  return s_state.active.load(std::memory_order_relaxed);
+}
+
+uint64_t Trace::now()
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_state.epoch).count());
+}
+
+void Trace::setThreadName(const std::string &_name)
+{
+  t_threadName = _name;
+  if (t_buffer != nullptr)
+  {
+    std::lock_guard<std::mutex> lock(s_state.mutex);
+    t_buffer->name = _name;
+  }
+}
+
+void Trace::nextFrame()
+{
+  s_state.frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t Trace::frame()
+{
+  return s_state.frame.load(std::memory_order_relaxed);
+}
+
+void Trace::record(const char *_name, uint64_t _startNS, uint64_t _endNS)
+{
+  if (Buffer *buffer = threadBuffer())
+  {
+    push(*buffer, {_name, _startNS, _endNS, 0, frame(), 0});
+  }
+}
+
+uint32_t Trace::createTrack(const char *_name)
+{
+  std::lock_guard<std::mutex> lock(s_state.mutex);
+  Buffer *buffer = createBuffer(_name, false);
+  return buffer ? buffer->id : 0;
+}
+
+void Trace::recordOnTrack(uint32_t _track, const char *_name, uint64_t _startNS, uint64_t _endNS, uint32_t _frame,
+                          uint64_t _fromNS)
+{
+  Buffer *track = _track < MaxTracks ? s_state.tracks[_track].load(std::memory_order_acquire) : nullptr;
+  Buffer *from = threadBuffer();
+  if (track != nullptr && from != nullptr && active())
+  {
+    push(*track, {_name, _startNS, _endNS, _fromNS, _frame, from->id});
+  }
+}
+
+bool Trace::write(const std::string &_fname)
+{
+  std::ofstream out(_fname);
+  if (!out)
+  {
+    std::cerr << "Unable to write " << _fname << '\n';
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(s_state.mutex);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"TessellationShader\"}}";
+  size_t flows = 0;
+  for (const auto &buffer : s_state.buffers)
+  {
+    const std::string tid = std::to_string(buffer->id);
+    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":\""
+        << escape(buffer->name) << "\"}}";
+    // keep the GPU timelines below the threads
+    out << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"sort_index\":"
+        << (buffer->cpu ? buffer->id : MaxTracks + buffer->id) << "}}";
+    const char *category = buffer->cpu ? "cpu" : "gpu";
+    const size_t count = buffer->count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i)
+    {
+      const Event &event = buffer->events[i];
+      const std::string name = escape(event.name);
+      out << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+          << ",\"ts\":" << micro(event.start) << ",\"dur\":" << micro(event.end - event.start)
+          << ",\"args\":{\"frame\":" << event.frame << "}}";
+      if (event.flowTrack != 0)
+      {
+        // an arrow from where the work was submitted to where it ran
+        const std::string id = std::to_string(++flows);
+        out << ",\n{\"name\":\"" << name << "\",\"cat\":\"flow\",\"ph\":\"s\",\"id\":" << id << ",\"pid\":1,\"tid\":"
+            << event.flowTrack << ",\"ts\":" << micro(event.from) << "}";
+        out << ",\n{\"name\":\"" << name << "\",\"cat\":\"flow\",\"ph\":\"f\",\"bp\":\"e\",\"id\":" << id
+            << ",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << micro(event.start) << "}";
+      }
+    }
+  }
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
+
+size_t Trace::events()
+{
+  std::lock_guard<std::mutex> lock(s_state.mutex);
+  size_t total = 0;
+  for (const auto &buffer : s_state.buffers)
+  {
+    total += buffer->count.load(std::memory_order_acquire);
+  }
+  return total;
+}
+
+size_t Trace::dropped()
+{
+  std::lock_guard<std::mutex> lock(s_state.mutex);
+  size_t total = 0;
+  for (const auto &buffer : s_state.buffers)
+  {
+    total += buffer->dropped.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+} // end namespace tess
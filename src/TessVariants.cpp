@@ -0,0 +1,236 @@
+#include "TessVariants.h"
+#include "TessTrace.h"
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+  GLenum glStage(ngl::ShaderType _type)
+  {
+    switch (_type)
+    {
+    case ngl::ShaderType::VERTEX:
+      return GL_VERTEX_SHADER;
+    case ngl::ShaderType::TESSCONTROL:
+      return GL_TESS_CONTROL_SHADER;
+    case ngl::ShaderType::TESSEVAL:
+      return GL_TESS_EVALUATION_SHADER;
+    case ngl::ShaderType::GEOMETRY:
+      return GL_GEOMETRY_SHADER;
+    default:
+      return GL_FRAGMENT_SHADER;
+    }
+  }
+
+  std::string programLog(GLuint _program)
+  {
+    GLint length = 0;
+    glGetProgramiv(_program, GL_INFO_LOG_LENGTH, &length);
+    std::string log(static_cast<size_t>(std::max(length, 1)), '\0');
+    glGetProgramInfoLog(_program, length, nullptr, &log[0]);
+    return log;
+  }
+
+  std::string shaderLog(GLuint _shader)
+  {
+    GLint length = 0;
+    glGetShaderiv(_shader, GL_INFO_LOG_LENGTH, &length);
+    std::string log(static_cast<size_t>(std::max(length, 1)), '\0');
+    glGetShaderInfoLog(_shader, length, nullptr, &log[0]);
+    return log;
+  }
+} // end anonymous namespace
+
+const char *tessSpacingName(TessSpacing _spacing)
+{
+  switch (_spacing)
+  {
+  case TessSpacing::FractionalOdd:
+    return "fractional_odd_spacing";
+  case TessSpacing::FractionalEven:
+    return "fractional_even_spacing";
+  default:
+    return "equal_spacing";
+  }
+}
+
+TessVariant TessVariant::normalized() const
+{
+  TessVariant variant = *this;
+  if (primitive == TessPrimitive::Points)
+  {
+    variant.pipeline = TessPipeline::NoGeometryShader;
+  }
+  return variant;
+}
+
+bool TessVariant::isDefault() const
+{
+  return spacing == TessSpacing::Equal && winding == TessWinding::CW && primitive == TessPrimitive::Triangles;
+}
+
+uint32_t TessVariant::key() const
+{
+  return static_cast<uint32_t>(pipeline) | static_cast<uint32_t>(spacing) << 8 | static_cast<uint32_t>(winding) << 16 |
+         static_cast<uint32_t>(primitive) << 24;
+}
+
+std::string TessVariant::defines() const
+{
+  std::string defines = std::string("#define TESS_SPACING ") + tessSpacingName(spacing) + '\n';
+  defines += winding == TessWinding::CCW ? "#define TESS_WINDING ccw\n" : "#define TESS_WINDING cw\n";
+  if (primitive == TessPrimitive::Points)
+  {
+    defines += "#define TESS_POINT_MODE\n";
+  }
+  return defines;
+}
+
+std::string TessVariant::name() const
+{
+  return std::string(tessSpacingName(spacing)) + (winding == TessWinding::CCW ? " ccw " : " cw ") +
+         (primitive == TessPrimitive::Points ? "points" : "triangles");
+}
+
+TessVariantTable::TessVariantTable(bool _programCache, tess::PositionFormat _positions)
+    : m_cache(_programCache), m_positions(_positions)
+{
+  m_parallelCompile = ProgramCache::enableParallelCompile();
+}
+
+TessVariantTable::~TessVariantTable()
+{
+  for (auto &entry : m_entries)
+  {
+    for (auto shader : entry.second.shaders)
+    {
+      glDeleteShader(shader);
+    }
+    glDeleteProgram(entry.second.program);
+  }
+}
+
+void TessVariantTable::submitCompile(const std::vector<ShaderStageSource> &_stages, const std::string &_defines,
+                                     Entry &io_entry) const
+{
+  for (const auto &stage : _stages)
+  {
+    GLuint shader = glCreateShader(glStage(stage.type));
+    const std::string source = ProgramCache::injectDefines(stage.source, _defines);
+    const char *text = source.c_str();
+    glShaderSource(shader, 1, &text, nullptr);
+    glCompileShader(shader);
+    glAttachShader(io_entry.program, shader);
+    io_entry.shaders.push_back(shader);
+  }
+  if (m_cache.enabled())
+  {
+    glProgramParameteri(io_entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+  // nothing is queried here, that would wait for the compiler
+  glLinkProgram(io_entry.program);
+}
+
+GLuint TessVariantTable::program(const TessVariant &_variant)
+{
+  const TessVariant variant = _variant.normalized();
+  auto found = m_entries.find(variant.key());
+  if (found != m_entries.end())
+  {
+    return found->second.state == State::Ready ? found->second.program : 0;
+  }
+  Entry &entry = m_entries[variant.key()];
+  entry.variant = variant;
+  entry.start = std::chrono::steady_clock::now();
+  entry.program = glCreateProgram();
+  const auto stages = tessProgramStages(variant.pipeline, "TessVariant");
+  const std::string defines = variant.defines() + tessProgramDefines(m_positions);
+  entry.cacheKey = m_cache.key(stages, defines);
+  entry.cacheHit = m_cache.enabled() && m_cache.submitBinary(entry.program, entry.cacheKey);
+  if (!entry.cacheHit)
+  {
+    submitCompile(stages, defines, entry);
+  }
+  return 0;
+}
+
+bool TessVariantTable::finished(const Entry &_entry) const
+{
+  return m_parallelCompile ? ProgramCache::linkCompleted(_entry.program) : _entry.frames >= PollFrames;
+}
+
+void TessVariantTable::poll()
+{
+  TESS_TRACE_ZONE("TessVariantTable::poll");
+  for (auto &entry : m_entries)
+  {
+    if (entry.second.state != State::Building)
+    {
+      continue;
+    }
+    ++entry.second.frames;
+    if (finished(entry.second))
+    {
+      finish(entry.second);
+    }
+  }
+}
+
+void TessVariantTable::finish(Entry &io_entry)
+{
+  GLint linked = GL_FALSE;
+  glGetProgramiv(io_entry.program, GL_LINK_STATUS, &linked);
+  if (!linked && io_entry.cacheHit)
+  {
+    // the driver turned the binary down (e.g. after an update), compile it and check again later
+    io_entry.cacheHit = false;
+    io_entry.frames = 0;
+    const auto stages = tessProgramStages(io_entry.variant.pipeline, "TessVariant");
+    submitCompile(stages, io_entry.variant.defines() + tessProgramDefines(m_positions), io_entry);
+    return;
+  }
+  if (!linked)
+  {
+    std::cerr << "Tess variant " << io_entry.variant.name() << " failed to build\n" << programLog(io_entry.program) << '\n';
+    for (auto shader : io_entry.shaders)
+    {
+      std::cerr << shaderLog(shader);
+    }
+    io_entry.state = State::Failed;
+  }
+  else
+  {
+    setTessProgramUniforms(io_entry.program);
+    if (m_cache.enabled() && !io_entry.cacheHit)
+    {
+      m_cache.saveBinary(io_entry.program, io_entry.cacheKey);
+    }
+    io_entry.state = State::Ready;
+    m_lastBuildMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - io_entry.start).count();
+    std::cout << "Tess variant " << io_entry.variant.name() << (io_entry.variant.pipeline == TessPipeline::GeometryShader ? "" : " (no geometry shader)")
+              << " ready after " << m_lastBuildMS << " ms and " << io_entry.frames << " frames ("
+              << (io_entry.cacheHit ? "warm cache" : "cold cache") << ")\n";
+  }
+  for (auto shader : io_entry.shaders)
+  {
+    glDetachShader(io_entry.program, shader);
+    glDeleteShader(shader);
+  }
+  io_entry.shaders.clear();
+}
+
+bool TessVariantTable::failed(const TessVariant &_variant) const
+{
+  auto found = m_entries.find(_variant.normalized().key());
+  return found != m_entries.end() && found->second.state == State::Failed;
+}
+
+size_t TessVariantTable::pending() const
+{
+  size_t count = 0;
+  for (const auto &entry : m_entries)
+  {
+    count += entry.second.state == State::Building ? 1 : 0;
+  }
+  return count;
+}
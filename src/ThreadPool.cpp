@@ -0,0 +1,122 @@
+#include "ThreadPool.h"
+#include "TessTrace.h"
+#include <algorithm>
+
+namespace tess
+{
+
+ThreadPool::ThreadPool(size_t _threads)
+{
+  if (_threads == 0)
+  {
+    _threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < _threads; ++i)
+  {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < _threads; ++i)
+  {
+    m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (auto &thread : m_threads)
+  {
+    thread.join();
+  }
+}
+
+bool ThreadPool::popTask(size_t _index, Task &o_task)
+{
+  {
+    Queue &own = *m_queues[_index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty())
+    {
+      o_task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      --m_queued;
+      return true;
+    }
+  }
+  // steal the oldest task of the next worker that has any, those are the biggest chunks of untouched work
+  for (size_t i = 1; i < m_queues.size(); ++i)
+  {
+    Queue &victim = *m_queues[(_index + i) % m_queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty())
+    {
+      o_task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      --m_queued;
+      ++m_steals;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(size_t _index)
+{
+  TESS_TRACE_THREAD("worker " + std::to_string(_index));
+  for (;;)
+  {
+    Task task;
+    if (popTask(_index, task))
+    {
+      task(_index);
+      if (--m_pending == 0)
+      {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_done.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    m_wake.wait(lock, [this] { return m_stop || m_queued > 0; });
+    if (m_stop && m_queued == 0)
+    {
+      return;
+    }
+  }
+}
+
+void ThreadPool::parallelFor(size_t _count, size_t _grain, const std::function<void(size_t, size_t, size_t)> &_func)
+{
+  if (_count == 0)
+  {
+    return;
+  }
+  _grain = std::max<size_t>(1, _grain);
+  const size_t chunks = (_count + _grain - 1) / _grain;
+  m_pending += chunks;
+  // deal contiguous runs of chunks to each worker so without stealing every worker walks its own part in order
+  const size_t workers = m_queues.size();
+  for (size_t w = 0; w < workers; ++w)
+  {
+    const size_t first = chunks * w / workers;
+    const size_t last = chunks * (w + 1) / workers;
+    std::lock_guard<std::mutex> lock(m_queues[w]->mutex);
+    // pushed back to front so popping from the back visits them in ascending order
+    for (size_t c = last; c-- > first;)
+    {
+      const size_t begin = c * _grain;
+      const size_t end = std::min(_count, begin + _grain);
+      m_queues[w]->tasks.push_back([&_func, begin, end](size_t _worker) { _func(begin, end, _worker); });
+      ++m_queued;
+    }
+  }
+  std::unique_lock<std::mutex> lock(m_wakeMutex);
+  m_wake.notify_all();
+  m_done.wait(lock, [this] { return m_pending == 0; });
+}
+
+} // end namespace tess
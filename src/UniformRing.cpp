@@ -0,0 +1,104 @@
+#include "UniformRing.h"
+#include <cstring>
+#include <iostream>
+
+UniformRing::UniformRing(size_t _frameBytes)
+{
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  m_alignment = alignment > 0 ? static_cast<size_t>(alignment) : m_alignment;
+  m_regionBytes = (_frameBytes + m_alignment - 1) / m_alignment * m_alignment;
+  const GLsizeiptr size = static_cast<GLsizeiptr>(m_regionBytes * Frames);
+  GLint major = 0;
+  GLint minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+  if (major > 4 || (major == 4 && minor >= 4))
+  {
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+    m_mapped = static_cast<char *>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+  }
+  if (!m_mapped)
+  {
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+  }
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+UniformRing::~UniformRing()
+{
+  for (auto &fence : m_fences)
+  {
+    glDeleteSync(fence);
+  }
+  if (m_mapped)
+  {
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+  glDeleteBuffers(1, &m_buffer);
+}
+
+void UniformRing::beginFrame()
+{
+  m_region = (m_region + 1) % Frames;
+  m_cursor = 0;
+  GLsync &fence = m_fences[m_region];
+  if (!fence)
+  {
+    return;
+  }
+  // poll first so we only count the frames that really had to wait
+  GLenum status = glClientWaitSync(fence, 0, 0);
+  if (status == GL_TIMEOUT_EXPIRED)
+  {
+    ++m_stalls;
+    do
+    {
+      status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    } while (status == GL_TIMEOUT_EXPIRED);
+  }
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+
+void UniformRing::endFrame()
+{
+  m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLintptr UniformRing::write(const void *_data, size_t _size)
+{
+  if (m_cursor + _size > m_regionBytes)
+  {
+    // better to draw something wrong than to scribble over a region the GPU may still be reading
+    if (!m_overflowReported)
+    {
+      std::cerr << "UniformRing region of " << m_regionBytes << " bytes is too small for this frame\n";
+      m_overflowReported = true;
+    }
+    m_cursor = 0;
+  }
+  const size_t offset = m_region * m_regionBytes + m_cursor;
+  if (m_mapped)
+  {
+    std::memcpy(m_mapped + offset, _data, _size);
+  }
+  else
+  {
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(_size), _data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+  m_cursor = (m_cursor + _size + m_alignment - 1) / m_alignment * m_alignment;
+  return static_cast<GLintptr>(offset);
+}
+
+void UniformRing::bind(GLuint _binding, GLintptr _offset, size_t _size) const
+{
+  glBindBufferRange(GL_UNIFORM_BUFFER, _binding, m_buffer, _offset, static_cast<GLsizeiptr>(_size));
+}
@@ -2,13 +2,39 @@
 basic OpenGL demo modified from http://qt-project.org/doc/qt-5.0/qtgui/openglwindow.html
 ****************************************************************************/
 #include "NGLScene.h"
+#include "AppOptions.h"
+#include "TessBenchmark.h"
+#include "TessTrace.h"
 #include <QtGui/QGuiApplication>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 
 int main(int argc, char** argv)
 {
+  // the benchmark and headless replays never show a window so don't require a display unless a platform was asked for
+  if (std::any_of(argv + 1, argv + argc, [](const char *_a) { return std::strcmp(_a, "--bench") == 0 || std::strcmp(_a, "--headless") == 0; }) &&
+      !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+  {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
   QGuiApplication app(argc, argv);
+  AppOptions options = parseAppOptions(app);
+  if (!options.traceFile.empty())
+  {
+    if (tess::Trace::compiledIn())
+    {
+      TESS_TRACE_THREAD("main");
+      tess::Trace::start();
+    }
+    else
+    {
+      std::cerr << "--trace needs a build with -DTESS_ENABLE_TRACE=ON\n";
+    }
+  }
   // create an OpenGL format specifier
   QSurfaceFormat format;
   // set the number of samples for multisampling
@@ -31,13 +57,33 @@ int main(int argc, char** argv)
   // set that as the default format for all windows
   QSurfaceFormat::setDefaultFormat(format);
 
+  if (options.bench)
+  {
+    TessBenchmark bench(options);
+    return bench.run();
+  }
+
+  if (options.headless && options.replayFile.empty())
+  {
+    std::cerr << "--headless without --replay never exits by itself\n";
+  }
+  std::unique_ptr<InputReplay> replay;
+  if (!options.replayFile.empty())
+  {
+    replay = std::make_unique<InputReplay>();
+    if (!replay->load(options.replayFile))
+    {
+      // a replay that doesn't match the recording is no use for comparing runs
+      return EXIT_FAILURE;
+    }
+  }
   // now we are going to create our scene window
-  NGLScene window;
+  NGLScene window(options, std::move(replay));
 
   // we can now query the version to see if it worked
   std::cout << "Profile is " << format.majorVersion() << " " << format.minorVersion() << "\n";
   // set the window size
-  window.resize(1024, 720);
+  window.resize(window.initialSize());
   // and finally show
   window.show();
   return app.exec();
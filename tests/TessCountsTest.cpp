@@ -0,0 +1,189 @@
+// Checks the CPU tessellator against the GL tessellation rules for the triangle domain with equal_spacing, no GL
+// needed. Every inner level 1..64 is tried with uniform outer levels and with each outer edge at its own level, the
+// vertex / triangle counts of TessPattern, expectedVertexCount / expectedTriangleCount and a CPUTessellator run over
+// the icosahedron are compared with counts worked out here from the spec. The quad domain count the Bezier mode is
+// checked against is tested the same way. Exits non zero on any mismatch.
+// usage : TessCountsTest
+#include "BezierPatch.h"
+#include "CPUTessellator.h"
+#include "Icosahedron.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <tuple>
+
+namespace
+{
+  //----------------------------------------------------------------------------------------------------------------------
+  /// @brief the counts GL generates for one patch, from section 11.2.2 of the GL spec rather than from the library:
+  /// equal_spacing clamps to [1,64] and rounds up, an inner level of 1 becomes 2 if any outer level is above 1, then
+  /// the domain is concentric triangles each with 2 fewer segments a side than the one outside it. The outermost
+  /// ring's sides take the outer levels, an innermost ring of 0 segments is the centre point and one of 1 segment is
+  /// a single triangle. The strip between a ring of a segments and one of b holds a + b triangles.
+  //----------------------------------------------------------------------------------------------------------------------
+  struct Counts
+  {
+    size_t vertices = 0;
+    size_t triangles = 0;
+  };
+
+  int glRound(float _level)
+  {
+    return static_cast<int>(std::ceil(std::min(64.0f, std::max(1.0f, _level))));
+  }
+
+  Counts glCounts(float _inner, const std::array<float, 3> &_outer)
+  {
+    Counts counts;
+    std::array<int, 3> outer;
+    for (int i = 0; i < 3; ++i)
+    {
+      if (!(_outer[i] > 0.0f))
+      {
+        return counts;
+      }
+      outer[i] = glRound(_outer[i]);
+    }
+    int inner = glRound(_inner);
+    const bool anyOuter = outer[0] > 1 || outer[1] > 1 || outer[2] > 1;
+    if (inner == 1 && !anyOuter)
+    {
+      counts.vertices = 3;
+      counts.triangles = 1;
+      return counts;
+    }
+    inner = std::max(inner, 2);
+    // the outer ring and the strip inside it
+    counts.vertices = static_cast<size_t>(outer[0] + outer[1] + outer[2]);
+    counts.triangles = static_cast<size_t>(outer[0] + outer[1] + outer[2] + 3 * (inner - 2));
+    for (int ring = inner - 2; ring >= 0; ring -= 2)
+    {
+      if (ring == 0)
+      {
+        counts.vertices += 1;
+      }
+      else if (ring == 1)
+      {
+        counts.vertices += 3;
+        counts.triangles += 1;
+      }
+      else
+      {
+        counts.vertices += static_cast<size_t>(3 * ring);
+        counts.triangles += static_cast<size_t>(3 * ring + 3 * (ring - 2));
+      }
+    }
+    return counts;
+  }
+
+  int s_failures = 0;
+  int s_checks = 0;
+
+  void check(bool _ok, const char *_what, float _inner, const std::array<float, 3> &_outer, size_t _got, size_t _expected)
+  {
+    ++s_checks;
+    if (!_ok)
+    {
+      if (++s_failures <= 20)
+      {
+        std::printf("FAIL %s inner %g outer %g %g %g : got %zu expected %zu\n", _what, _inner, _outer[0], _outer[1],
+                    _outer[2], _got, _expected);
+      }
+    }
+  }
+
+  void checkLevels(tess::CPUTessellator &io_tessellator, float _inner, const std::array<float, 3> &_outer)
+  {
+    tess::TessLevels levels;
+    levels.inner = _inner;
+    levels.outer = _outer;
+    const Counts expected = glCounts(_inner, _outer);
+    const tess::TessPattern pattern(levels);
+    check(pattern.numVertices() == expected.vertices, "pattern vertices", _inner, _outer, pattern.numVertices(), expected.vertices);
+    check(pattern.numTriangles() == expected.triangles, "pattern triangles", _inner, _outer, pattern.numTriangles(), expected.triangles);
+    check(tess::expectedVertexCount(levels) == expected.vertices, "expectedVertexCount", _inner, _outer,
+          tess::expectedVertexCount(levels), expected.vertices);
+    check(tess::expectedTriangleCount(levels) == expected.triangles, "expectedTriangleCount", _inner, _outer,
+          tess::expectedTriangleCount(levels), expected.triangles);
+
+    // GL generates each domain point once, so the pattern must not repeat one and every index must be in range
+    std::set<std::tuple<long, long, long>> points;
+    for (size_t i = 0; i < pattern.numVertices(); ++i)
+    {
+      points.insert(std::make_tuple(std::lround(pattern.u()[i] * 1e5f), std::lround(pattern.v()[i] * 1e5f),
+                                    std::lround(pattern.w()[i] * 1e5f)));
+    }
+    check(points.size() == pattern.numVertices(), "distinct points", _inner, _outer, points.size(), pattern.numVertices());
+    const auto &indices = pattern.indices();
+    const bool inRange = std::all_of(indices.begin(), indices.end(), [&](uint32_t _i) { return _i < pattern.numVertices(); });
+    check(inRange, "indices in range", _inner, _outer, inRange, 1);
+
+    tess::TessMesh mesh;
+    io_tessellator.tessellate(tess::IcosahedronVerts.data(), tess::IcosahedronFaces.data(), tess::IcosahedronPatchCount,
+                              levels, mesh);
+    check(mesh.numVertices() == expected.vertices * tess::IcosahedronPatchCount, "sphere vertices", _inner, _outer,
+          mesh.numVertices(), expected.vertices * tess::IcosahedronPatchCount);
+    check(mesh.numTriangles() == expected.triangles * tess::IcosahedronPatchCount, "sphere triangles", _inner, _outer,
+          mesh.numTriangles(), expected.triangles * tess::IcosahedronPatchCount);
+  }
+} // end anonymous namespace
+
+int main()
+{
+  tess::CPUTessellator tessellator;
+  for (int inner = 1; inner <= tess::MaxTessLevel; ++inner)
+  {
+    const float n = static_cast<float>(inner);
+    for (int outer = 1; outer <= tess::MaxTessLevel; ++outer)
+    {
+      const float o = static_cast<float>(outer);
+      checkLevels(tessellator, n, {{o, o, o}});
+      // every edge at its own level, spread over the whole range
+      const float o1 = static_cast<float>((outer * 7 + inner) % tess::MaxTessLevel + 1);
+      const float o2 = static_cast<float>((outer * 13 + inner * 5) % tess::MaxTessLevel + 1);
+      checkLevels(tessellator, n, {{o, o1, o2}});
+      checkLevels(tessellator, n, {{o2, o, o1}});
+    }
+    // the closed forms for uniform levels: 3n^2/2 triangles at even n, (3n^2 - 1)/2 at odd n
+    tess::TessLevels uniform;
+    uniform.inner = n;
+    uniform.outer = {{n, n, n}};
+    const size_t closed = inner % 2 == 0 ? static_cast<size_t>(3 * inner * inner / 2) : static_cast<size_t>((3 * inner * inner - 1) / 2);
+    check(tess::TessPattern(uniform).numTriangles() == closed, "uniform closed form", n, uniform.outer,
+          tess::TessPattern(uniform).numTriangles(), closed);
+    // equal levels split the quad domain into an n x n grid
+    const size_t quads = static_cast<size_t>(2 * inner * inner);
+    check(tess::expectedQuadTriangleCount(n, n) == quads, "quad closed form", n, uniform.outer,
+          tess::expectedQuadTriangleCount(n, n), quads);
+  }
+  // fractional levels round up, levels outside [1,64] clamp and an outer level of 0 or NaN discards the patch
+  const std::array<std::pair<float, std::array<float, 3>>, 7> edgeCases = {{{2.3f, {{1.0f, 4.5f, 3.01f}}},
+                                                                            {0.5f, {{0.2f, 0.7f, 1.0f}}},
+                                                                            {1.0f, {{1.0f, 2.0f, 1.0f}}},
+                                                                            {100.0f, {{80.0f, 64.0f, 65.0f}}},
+                                                                            {-3.0f, {{1.0f, 1.0f, 1.0f}}},
+                                                                            {4.0f, {{0.0f, 4.0f, 4.0f}}},
+                                                                            {4.0f, {{4.0f, std::nanf(""), 4.0f}}}}};
+  for (const auto &levels : edgeCases)
+  {
+    checkLevels(tessellator, levels.first, levels.second);
+  }
+  // quads: one quad at all 1s, inner 1 becomes 2 so inner 2 with outer m is a fan of 4m around the centre, a
+  // discarded patch generates nothing
+  const std::array<std::array<float, 3>, 5> quadCases = {{{{1.0f, 1.0f, 2.0f}},
+                                                          {{1.0f, 3.0f, 12.0f}},
+                                                          {{2.0f, 5.0f, 20.0f}},
+                                                          {{3.0f, 1.0f, 10.0f}},
+                                                          {{4.0f, 0.0f, 0.0f}}}};
+  for (const auto &quad : quadCases)
+  {
+    const size_t expected = static_cast<size_t>(quad[2]);
+    check(tess::expectedQuadTriangleCount(quad[0], quad[1]) == expected, "quad triangles", quad[0], {{quad[1], quad[1], quad[1]}},
+          tess::expectedQuadTriangleCount(quad[0], quad[1]), expected);
+  }
+  std::printf("%d checks, %d failures\n", s_checks, s_failures);
+  return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}